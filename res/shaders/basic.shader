@@ -12,7 +12,8 @@ void main() {
 #shader fragment
 #version 330 core
 layout (location = 0) out vec4 fragColor;
+uniform vec4 u_color;
 
 void main() {
-    fragColor = vec4(0.91, 0.44, 0.11, 1.0);
+    fragColor = u_color;
 }
\ No newline at end of file
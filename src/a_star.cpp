@@ -1,15 +1,15 @@
 // a_star.cpp (updated: respect oneway & drivable ways; nearest-node helper)
 
+#include "a_star.hpp"
+#include "geo.hpp"
+#include "traffic.hpp"
+#include "weight_overrides.hpp"
+
 #include <iostream>
-#include <unordered_map>
-#include <unordered_set>
+#include <memory_resource>
 #include <vector>
-#include <queue>
 #include <cmath>
 #include <limits>
-#include <osmium/io/any_input.hpp>
-#include <osmium/handler.hpp>
-#include <osmium/visitor.hpp>
 #include <fstream>
 #include <chrono>
 #include <iomanip>
@@ -17,217 +17,1414 @@
 #include <algorithm>
 #include <string>
 
-struct Node {
-    double lat, lon;
+using NodeIndex = RoutingGraph::NodeIndex;
+
+void SearchWorkspace::reset(size_t stateCount) {
+    if (gScore.size() < stateCount) {
+        gScore.assign(stateCount, 0.0);
+        parent.assign(stateCount, RoutingGraph::INVALID_STATE);
+        stamp.assign(stateCount, 0);
+        epoch = 0;
+    }
+    if (++epoch == 0) {
+        // wrapped around: stale stamps could now look current
+        std::fill(stamp.begin(), stamp.end(), 0);
+        epoch = 1;
+    }
+    heap.clear();
+    nodesExplored = 0;
+}
+
+bool usesTurnSearch(const RoutingGraph& graph, const SearchOptions& options) {
+    return graph.hasTurnRestrictions(options.profile) ||
+           (options.metric == Metric::Duration && (options.uturnPenalty > 0.0 || options.crossTrafficPenalty > 0.0));
+}
+
+namespace {
+
+bool queueGreater(const SearchWorkspace::QueueItem& a, const SearchWorkspace::QueueItem& b) {
+    return a.key > b.key;
+}
+
+void pushQueue(SearchWorkspace& ws, double key, double g, uint32_t state) {
+    ws.heap.push_back({key, g, state});
+    std::push_heap(ws.heap.begin(), ws.heap.end(), queueGreater);
+}
+
+SearchWorkspace::QueueItem popQueue(SearchWorkspace& ws) {
+    std::pop_heap(ws.heap.begin(), ws.heap.end(), queueGreater);
+    SearchWorkspace::QueueItem item = ws.heap.back();
+    ws.heap.pop_back();
+    return item;
+}
+
+// Straight-line lower bound on the remaining cost; zero turns A* into Dijkstra.
+struct Heuristic {
+    NodeIndex goal = RoutingGraph::INVALID_NODE;
+    double scale = 0.0;
+
+    double operator()(const RoutingGraph& graph, NodeIndex u) const {
+        if (scale == 0.0) return 0.0;
+        return scale * graph.lowerBoundMeters(u, goal);
+    }
 };
-struct Edge {
-    int64_t to;
-    double weight;
+
+bool isTimed(const SearchOptions& options) {
+    return options.traffic && options.metric == Metric::Duration && followsTraffic(options.profile);
+}
+
+// Factor on the cost of edge e entered at search cost g: the traffic at that
+// time of day for timed searches, plus its live override's factor - 1 (only
+// closures count for Distance). The override adds a fixed delay rather than
+// scaling the traffic: TrafficModel keeps base * traffic FIFO, and scaling its
+// slopes by the override would undo that. +infinity for closed edges, which
+// searches skip.
+double edgeFactor(const SearchOptions& options, RoutingGraph::EdgeIndex e, double g) {
+    double factor = isTimed(options) ? options.traffic->factor(e, options.departure + g / 10.0) : 1.0;
+    if (options.overrides) {
+        const double slowdown = options.overrides->factor(e);
+        if (std::isinf(slowdown)) return slowdown;
+        if (options.metric == Metric::Duration) factor += slowdown - 1.0;
+    }
+    return factor;
+}
+
+Heuristic towards(const RoutingGraph& graph, NodeIndex goal, const SearchOptions& options) {
+    double scale = graph.heuristicScale(options.metric, options.profile);
+    // light traffic can beat free flow
+    if (isTimed(options)) scale *= options.traffic->minFactor();
+    return {goal, scale};
+}
+
+// Search endpoints that are shape nodes. A search from a shape node starts at
+// the heads of the edges running through it; a shape-node target is reached
+// part-way along such an edge. Each of those partial edges ("hits") gets an
+// extra search state after the graph's own states.
+struct Endpoints {
+    struct Seed {
+        RoutingGraph::EdgeIndex edge;
+        uint32_t index;  // start is shape(edge)[index]
+        double cost;     // from start to the edge's head
+    };
+    struct Hit {
+        RoutingGraph::EdgeIndex edge;
+        uint32_t index;  // target is shape(edge)[index]
+        double cost;     // from the edge's tail (or from start, if direct) to the target
+        NodeIndex target;
+        bool direct;     // start and target on the same edge, start first
+    };
+
+    explicit Endpoints(std::pmr::memory_resource* mem = std::pmr::get_default_resource()) : seeds(mem), hits(mem) {}
+
+    std::pmr::vector<Seed> seeds;
+    std::pmr::vector<Hit> hits; // hits[0 .. edgeHits) sorted by edge, then the direct ones
+    size_t edgeHits = 0;
+    uint32_t firstHitState = 0;
+
+    // Hits along edge e, as [first, last) into hits.
+    std::pair<size_t, size_t> hitsOn(RoutingGraph::EdgeIndex e) const {
+        auto less = [](const Hit& h, RoutingGraph::EdgeIndex x) { return h.edge < x; };
+        auto first = std::lower_bound(hits.begin(), hits.begin() + edgeHits, e, less);
+        auto last = first;
+        while (last != hits.begin() + edgeHits && last->edge == e) ++last;
+        return {static_cast<size_t>(first - hits.begin()), static_cast<size_t>(last - hits.begin())};
+    }
 };
 
-std::unordered_map<int64_t, Node> nodes;
-std::unordered_map<int64_t, std::vector<Edge>> adj;
-
-constexpr double PI_CONST = 3.14159265358979323846;
-inline double deg2rad(double deg) { return deg * PI_CONST / 180.0; }
-
-double haversine(double lat1, double lon1, double lat2, double lon2) {
-    // Returns distance in meters
-    const double R = 6371000.0; // mean Earth radius in meters
-    double dLat = deg2rad(lat2 - lat1);
-    double dLon = deg2rad(lon2 - lon1);
-    double a = std::sin(dLat / 2.0) * std::sin(dLat / 2.0) +
-               std::cos(deg2rad(lat1)) * std::cos(deg2rad(lat2)) *
-               std::sin(dLon / 2.0) * std::sin(dLon / 2.0);
-    double c = 2.0 * std::atan2(std::sqrt(a), std::sqrt(1.0 - a));
-    return R * c;
-}
-
-// Helper: find nearest node id for a lat/lon (linear search - slow for full map, but fine for testing)
-int64_t findNearestNode(double lat, double lon) {
-    double bestDist = std::numeric_limits<double>::infinity();
-    int64_t bestId = 0;
-    for (const auto &p : nodes) {
-        double d = haversine(lat, lon, p.second.lat, p.second.lon);
-        if (d < bestDist) {
-            bestDist = d;
-            bestId = p.first;
-        }
-    }
-    return bestId;
-}
-
-void loadKarachiMap(const std::string& filename) {
-    struct MapHandler : public osmium::handler::Handler {
-        // set of highway tags that are appropriate for motor vehicle routing
-        const std::unordered_set<std::string> drivables = {
-            "motorway","trunk","primary","secondary","tertiary",
-            "unclassified","residential","service","living_street",
-            "motorway_link","primary_link","secondary_link","tertiary_link"
-        };
+Endpoints endpointsFor(const RoutingGraph& graph, NodeIndex start, const NodeIndex* targets, size_t targetCount,
+                       const SearchOptions& options, std::pmr::memory_resource* mem = std::pmr::get_default_resource()) {
+    const Metric metric = options.metric;
+    const Profile profile = options.profile;
+    Endpoints ends(mem);
+    RoutingGraph::ShapeRef refs[2];
+    size_t count = graph.shapeRefs(start, refs, profile);
+    for (size_t k = 0; k < count; ++k) {
+        const double factor = edgeFactor(options, refs[k].edge, 0.0);
+        if (std::isinf(factor)) continue; // closed
+        const RoutingGraph::ShapePoint& at = graph.shape(refs[k].edge)[refs[k].index];
+        ends.seeds.push_back({refs[k].edge, refs[k].index,
+                              (graph.cost(refs[k].edge, metric, profile) - at.cost(metric, profile)) * factor});
+    }
 
-        // disallow these (pedestrian/cycle) types explicitly
-        const std::unordered_set<std::string> nondrivable = {
-            "footway","path","cycleway","steps","pedestrian","track","bridleway","corridor"
-        };
+    std::pmr::vector<Endpoints::Hit> direct(mem);
+    for (const NodeIndex* t = targets; t != targets + targetCount; ++t) {
+        if (*t == start || *t >= graph.nodeCount()) continue;
+        count = graph.shapeRefs(*t, refs, profile);
+        for (size_t k = 0; k < count; ++k) {
+            const double toTarget = graph.shape(refs[k].edge)[refs[k].index].cost(metric, profile);
+            ends.hits.push_back({refs[k].edge, refs[k].index, toTarget, *t, false});
+            for (const auto& seed : ends.seeds) {
+                if (seed.edge != refs[k].edge || seed.index >= refs[k].index) continue;
+                const double fromStart = graph.shape(seed.edge)[seed.index].cost(metric, profile);
+                direct.push_back({refs[k].edge, refs[k].index,
+                                  (toTarget - fromStart) * edgeFactor(options, seed.edge, 0.0), *t, true});
+            }
+        }
+    }
+    std::sort(ends.hits.begin(), ends.hits.end(), [](const Endpoints::Hit& a, const Endpoints::Hit& b) {
+        return a.edge < b.edge;
+    });
+    ends.edgeHits = ends.hits.size();
+    ends.hits.insert(ends.hits.end(), direct.begin(), direct.end());
+    return ends;
+}
+
+// Appends the shape nodes of e from position `from` on, then (unless stopping
+// at a shape position) its head.
+void appendEdge(const RoutingGraph& graph, RoutingGraph::EdgeIndex e, size_t from, std::vector<NodeIndex>& path,
+                size_t until = SIZE_MAX) {
+    const RoutingGraph::ShapeRange s = graph.shape(e);
+    for (size_t i = from; i < s.size() && i <= until; ++i) path.push_back(s[i].node);
+    if (until == SIZE_MAX) path.push_back(graph.edge(e).to);
+}
+
+// Node the last stretch of edge `in` starts from (inTail itself for unshaped edges).
+NodeIndex lastHopFrom(const RoutingGraph& graph, RoutingGraph::EdgeIndex in, NodeIndex inTail) {
+    const RoutingGraph::ShapeRange s = graph.shape(in);
+    return s.empty() ? inTail : s.back().node;
+}
+
+// Extra deciseconds for turning from edge `in` (whose last stretch started at
+// lastHop) onto edge `out`.
+double turnPenalty(const RoutingGraph& graph, const SearchOptions& options,
+                   RoutingGraph::EdgeIndex in, NodeIndex lastHop, RoutingGraph::EdgeIndex out) {
+    if (options.metric != Metric::Duration) return 0.0;
+    const RoutingGraph::ShapeRange s = graph.shape(out);
+    if ((s.empty() ? graph.edge(out).to : s[0].node) == lastHop) return options.uturnPenalty * 10.0;
+    if (options.crossTrafficPenalty <= 0.0) return 0.0;
+
+    // signed turn angle, positive = right turn
+    int delta = static_cast<int8_t>(static_cast<uint8_t>(graph.bearing(out) - graph.arrivalBearing(in)));
+    double degrees = delta * 360.0 / 256.0;
+    bool crosses = options.leftHandTraffic ? (degrees >= 45.0 && degrees <= 170.0)
+                                           : (degrees <= -45.0 && degrees >= -170.0);
+    return crosses ? options.crossTrafficPenalty * 10.0 : 0.0;
+}
 
-        void node(const osmium::Node& node) {
-            if (node.location().valid()) {
-                nodes[node.id()] = {node.location().lat(), node.location().lon()};
+// Pushes the states a search starts from: direct hits, plus start itself
+// (core start) or the seeds' heads (shape start) via seedNode(edge, cost).
+template <typename SeedNode>
+void pushStart(const RoutingGraph& graph, const Endpoints& ends, const Heuristic& h,
+               SearchWorkspace& ws, SeedNode seedNode) {
+    for (const auto& seed : ends.seeds) seedNode(seed.edge, seed.cost);
+    for (size_t k = ends.edgeHits; k < ends.hits.size(); ++k) {
+        const uint32_t state = ends.firstHitState + static_cast<uint32_t>(k);
+        ws.touch(state, ends.hits[k].cost, RoutingGraph::INVALID_STATE);
+        pushQueue(ws, ends.hits[k].cost + h(graph, ends.hits[k].target), ends.hits[k].cost, state);
+    }
+}
+
+// Relaxes the hits along edge e, reached at cost g from state `from`; factor
+// as returned by edgeFactor() for e at g.
+void relaxHits(const RoutingGraph& graph, const Endpoints& ends, const Heuristic& h, SearchWorkspace& ws,
+               RoutingGraph::EdgeIndex e, double g, uint32_t from, double factor) {
+    if (ends.edgeHits == 0) return;
+    auto range = ends.hitsOn(e);
+    for (size_t k = range.first; k < range.second; ++k) {
+        const uint32_t state = ends.firstHitState + static_cast<uint32_t>(k);
+        const double tentative = g + ends.hits[k].cost * factor;
+        if (!ws.touched(state) || tentative < ws.gScore[state]) {
+            ws.touch(state, tentative, from);
+            pushQueue(ws, tentative + h(graph, ends.hits[k].target), tentative, state);
+        }
+    }
+}
+
+// First half of nodeSearch(): resets ws and queues the states around start.
+void seedNodeSearch(const RoutingGraph& graph, NodeIndex start, Endpoints& ends, const Heuristic& h,
+                    SearchWorkspace& ws) {
+    ends.firstHitState = static_cast<uint32_t>(graph.coreNodeCount());
+    ws.reset(graph.coreNodeCount() + ends.hits.size());
+    if (graph.isCore(start)) {
+        ws.touch(start, 0.0, RoutingGraph::INVALID_STATE);
+        pushQueue(ws, h(graph, start), 0.0, start);
+    }
+    pushStart(graph, ends, h, ws, [&](RoutingGraph::EdgeIndex e, double g) {
+        const NodeIndex head = graph.edge(e).to;
+        if (!ws.touched(head) || g < ws.gScore[head]) {
+            ws.touch(head, g, RoutingGraph::INVALID_STATE);
+            pushQueue(ws, g + h(graph, head), g, head);
+        }
+    });
+}
+
+// Second half of nodeSearch(): settles what ws has queued. Stopped by
+// onSettle, it carries on from the same queue when called again.
+template <typename OnSettle>
+void expandNodeSearch(const RoutingGraph& graph, const Endpoints& ends, const Heuristic& h,
+                      const SearchOptions& options, SearchWorkspace& ws, OnSettle onSettle) {
+    const uint8_t allowed = profileBit(options.profile);
+    while (!ws.heap.empty()) {
+        SearchWorkspace::QueueItem current = popQueue(ws);
+        const uint32_t s = current.state;
+        if (current.g > ws.gScore[s]) continue; // stale entry
+
+        ws.nodesExplored++;
+        if (s >= ends.firstHitState) {
+            if (onSettle(ends.hits[s - ends.firstHitState].target, current.g, s)) return;
+            continue;
+        }
+        const NodeIndex u = s;
+        if (onSettle(u, current.g, s)) return;
+
+        for (const auto& edge : graph.edges(u)) {
+            if (!(edge.profiles & allowed)) continue;
+            const RoutingGraph::EdgeIndex e = graph.edgeIndex(edge);
+            const double factor = edgeFactor(options, e, current.g);
+            if (std::isinf(factor)) continue; // closed
+            double tentative_gScore = current.g + graph.cost(e, options.metric, options.profile) * factor;
+            if (!ws.touched(edge.to) || tentative_gScore < ws.gScore[edge.to]) {
+                ws.touch(edge.to, tentative_gScore, u);
+                pushQueue(ws, tentative_gScore + h(graph, edge.to), tentative_gScore, edge.to);
             }
+            relaxHits(graph, ends, h, ws, e, current.g, u, factor);
         }
+    }
+}
 
-        void way(const osmium::Way& way) {
-            const char* highway_tag = way.tags()["highway"];
-            if (!highway_tag) return; // not a highway/road-type way
+// Node-based best-first search over the edges options.profile may use. Calls
+// onSettle(node, g, state) for each settled node and stops as soon as it
+// returns true. Workspace states are core node indices, then the Endpoints hits.
+template <typename OnSettle>
+void nodeSearch(const RoutingGraph& graph, NodeIndex start, Endpoints& ends, const Heuristic& h,
+                const SearchOptions& options, SearchWorkspace& ws, OnSettle onSettle) {
+    seedNodeSearch(graph, start, ends, h, ws);
+    expandNodeSearch(graph, ends, h, options, ws, onSettle);
+}
 
-            std::string hw = highway_tag;
-            if (nondrivable.count(hw)) return; // skip pedestrian / cycle / steps etc.
+struct NoRelax {
+    void operator()(RoutingGraph::EdgeIndex, double, double) const {}
+};
 
-            // allow ways that are in drivables set; if not present, skip to be conservative
-            if (!drivables.count(hw)) {
-                // there are some ambiguous 'road' ways; to be conservative, skip unknown kinds
-                return;
+// First half of turnSearch(): resets ws and queues the edges out of start.
+template <typename OnRelax>
+void seedTurnSearch(const RoutingGraph& graph, NodeIndex start, Endpoints& ends, const Heuristic& h,
+                    const SearchOptions& options, SearchWorkspace& ws, OnRelax onRelax) {
+    const uint8_t allowed = profileBit(options.profile);
+    ends.firstHitState = static_cast<uint32_t>(graph.turnStateCount());
+    ws.reset(graph.turnStateCount() + ends.hits.size());
+
+    auto seed = [&](RoutingGraph::EdgeIndex e, double g) {
+        if (!ws.touched(e) || g < ws.gScore[e]) {
+            ws.touch(e, g, RoutingGraph::INVALID_STATE);
+            pushQueue(ws, g + h(graph, graph.edge(e).to), g, e);
+        }
+    };
+    for (const auto& edge : graph.edges(start)) {
+        if (!(edge.profiles & allowed)) continue;
+        const RoutingGraph::EdgeIndex e = graph.edgeIndex(edge);
+        const double factor = edgeFactor(options, e, 0.0);
+        if (std::isinf(factor)) continue; // closed
+        seed(e, graph.cost(e, options.metric, options.profile) * factor);
+        relaxHits(graph, ends, h, ws, e, 0.0, RoutingGraph::INVALID_STATE, factor);
+        onRelax(e, 0.0, factor);
+    }
+    pushStart(graph, ends, h, ws, seed);
+}
+
+// Second half of turnSearch(): settles what ws has queued. Stopped by
+// onSettle, it carries on from the same queue when called again.
+template <typename OnSettle, typename OnRelax>
+void expandTurnSearch(const RoutingGraph& graph, NodeIndex start, const Endpoints& ends, const Heuristic& h,
+                      const SearchOptions& options, SearchWorkspace& ws, OnSettle onSettle, OnRelax onRelax) {
+    const uint8_t allowed = profileBit(options.profile);
+    const bool restricted = graph.hasTurnRestrictions(options.profile);
+    while (!ws.heap.empty()) {
+        SearchWorkspace::QueueItem current = popQueue(ws);
+        RoutingGraph::TurnState s = current.state;
+        if (current.g > ws.gScore[s]) continue; // stale entry
+
+        ws.nodesExplored++;
+        if (s >= ends.firstHitState) {
+            if (onSettle(ends.hits[s - ends.firstHitState].target, current.g, s)) return;
+            continue;
+        }
+        const RoutingGraph::EdgeIndex in = graph.stateEdge(s);
+        const NodeIndex u = graph.edge(in).to;
+        if (onSettle(u, current.g, s)) return;
+
+        const RoutingGraph::TurnState p = ws.parent[s];
+        const NodeIndex inTail = p == RoutingGraph::INVALID_STATE ? start : graph.edge(graph.stateEdge(p)).to;
+        const NodeIndex lastHop = lastHopFrom(graph, in, inTail);
+
+        for (const auto& edge : graph.edges(u)) {
+            if (!(edge.profiles & allowed)) continue;
+            const RoutingGraph::EdgeIndex out = graph.edgeIndex(edge);
+            RoutingGraph::TurnState next = restricted ? graph.nextTurnState(s, out, options.profile) : out;
+            if (next == RoutingGraph::INVALID_STATE) continue; // restricted turn
+
+            const double g = current.g + turnPenalty(graph, options, in, lastHop, out);
+            const double factor = edgeFactor(options, out, g);
+            if (std::isinf(factor)) continue; // closed
+            double tentative_gScore = g + graph.cost(out, options.metric, options.profile) * factor;
+            if (!ws.touched(next) || tentative_gScore < ws.gScore[next]) {
+                ws.touch(next, tentative_gScore, s);
+                pushQueue(ws, tentative_gScore + h(graph, edge.to), tentative_gScore, next);
             }
+            relaxHits(graph, ends, h, ws, out, g, s, factor);
+            onRelax(out, g, factor);
+        }
+    }
+}
+
+// Edge-based search over RoutingGraph::TurnStates (then the Endpoints hits),
+// honouring turn penalties and, for profiles that obey them, turn
+// restrictions. onSettle as in nodeSearch(); the start node itself is never
+// reported. onRelax(edge, g, factor) sees every edge entered from its tail at
+// cost g, with its edgeFactor().
+template <typename OnSettle, typename OnRelax = NoRelax>
+void turnSearch(const RoutingGraph& graph, NodeIndex start, Endpoints& ends, const Heuristic& h,
+                const SearchOptions& options, SearchWorkspace& ws, OnSettle onSettle, OnRelax onRelax = {}) {
+    seedTurnSearch(graph, start, ends, h, options, ws, onRelax);
+    expandTurnSearch(graph, start, ends, h, options, ws, onSettle, onRelax);
+}
+
+// Dial's bucket queue: costs are whole deciseconds, or meters rounded down, so
+// one bucket per unit replaces the heap. Keys inside a bucket are not ordered;
+// an entry improved after it was expanded is pushed and expanded again, which
+// keeps the result exact. The ring of buckets grows to span the longest edge.
+class BucketQueue {
+public:
+    explicit BucketQueue(std::vector<std::vector<SearchWorkspace::QueueItem>>& buckets) : m_buckets(buckets) {
+        if (m_buckets.empty()) m_buckets.resize(1024);
+        for (auto& b : m_buckets) b.clear();
+    }
+
+    void push(double g, uint32_t state) {
+        const uint64_t key = static_cast<uint64_t>(g);
+        if (key - m_current >= m_buckets.size()) grow(key);
+        m_buckets[key & (m_buckets.size() - 1)].push_back({g, g, state});
+        ++m_size;
+    }
 
-            // check simple access restrictions
-            const char* access_tag = way.tags()["access"];
-            const char* motor_tag = way.tags()["motor_vehicle"];
-            if ((access_tag && std::string(access_tag) == "no") ||
-                (motor_tag && std::string(motor_tag) == "no")) {
-                return; // not allowed for motor vehicles
+    bool empty() const { return m_size == 0; }
+
+    SearchWorkspace::QueueItem pop() {
+        for (;;) {
+            auto& bucket = m_buckets[m_current & (m_buckets.size() - 1)];
+            if (!bucket.empty()) {
+                SearchWorkspace::QueueItem item = bucket.back();
+                bucket.pop_back();
+                --m_size;
+                return item;
             }
+            ++m_current;
+        }
+    }
+
+private:
+    std::vector<std::vector<SearchWorkspace::QueueItem>>& m_buckets; // size is a power of two
+    uint64_t m_current = 0;
+    size_t m_size = 0;
+
+    void grow(uint64_t key) {
+        size_t size = m_buckets.size();
+        while (key - m_current >= size) size *= 2;
+        std::vector<std::vector<SearchWorkspace::QueueItem>> buckets(size);
+        for (auto& bucket : m_buckets) {
+            for (const auto& item : bucket) buckets[static_cast<uint64_t>(item.g) & (size - 1)].push_back(item);
+        }
+        m_buckets.swap(buckets);
+    }
+};
+
+// Node-based Dijkstra from every source at once over a BucketQueue, up to
+// maxCost. Fills cost for core nodes and for the shape nodes of relaxed edges.
+void bucketSearch(const RoutingGraph& graph, const std::vector<NodeIndex>& sources, const SearchOptions& options,
+                  double maxCost, SearchWorkspace& ws, std::vector<double>& cost) {
+    const uint8_t allowed = profileBit(options.profile);
+    ws.reset(graph.coreNodeCount());
+    BucketQueue queue(ws.buckets);
+    auto reach = [&](NodeIndex u, double g) {
+        if (g > maxCost) return;
+        if (!ws.touched(u) || g < ws.gScore[u]) {
+            ws.touch(u, g, RoutingGraph::INVALID_STATE);
+            queue.push(g, u);
+        }
+    };
+    // shape nodes along e, entered from its tail at cost g
+    auto relaxShape = [&](RoutingGraph::EdgeIndex e, double g, size_t from, double factor) {
+        const RoutingGraph::ShapeRange s = graph.shape(e);
+        for (size_t i = from; i < s.size(); ++i) {
+            const double c = g + s[i].cost(options.metric, options.profile) * factor;
+            if (c > maxCost) break;
+            cost[s[i].node] = std::min(cost[s[i].node], c);
+        }
+    };
+
+    for (NodeIndex source : sources) {
+        if (source >= graph.nodeCount()) continue;
+        cost[source] = 0.0;
+        if (graph.isCore(source)) {
+            reach(source, 0.0);
+            continue;
+        }
+        Endpoints ends = endpointsFor(graph, source, nullptr, 0, options);
+        for (const auto& seed : ends.seeds) {
+            const double factor = edgeFactor(options, seed.edge, 0.0);
+            const double offset = graph.shape(seed.edge)[seed.index].cost(options.metric, options.profile);
+            relaxShape(seed.edge, -offset * factor, seed.index + 1, factor);
+            reach(graph.edge(seed.edge).to, seed.cost);
+        }
+    }
+
+    while (!queue.empty()) {
+        const SearchWorkspace::QueueItem current = queue.pop();
+        const NodeIndex u = current.state;
+        if (current.g > ws.gScore[u]) continue; // stale entry
+
+        ws.nodesExplored++;
+        cost[u] = std::min(cost[u], current.g);
+        for (const auto& edge : graph.edges(u)) {
+            if (!(edge.profiles & allowed)) continue;
+            const RoutingGraph::EdgeIndex e = graph.edgeIndex(edge);
+            const double factor = edgeFactor(options, e, current.g);
+            if (std::isinf(factor)) continue; // closed
+            relaxShape(e, current.g, 0, factor);
+            reach(edge.to, current.g + graph.cost(e, options.metric, options.profile) * factor);
+        }
+    }
+}
+
+// A route as the graph edges it travels. The first edge may be entered past
+// its tail (shape start) and the last one left before its head (shape goal).
+struct EdgeRoute {
+    explicit EdgeRoute(std::pmr::memory_resource* mem = std::pmr::get_default_resource()) : edges(mem) {}
+
+    std::pmr::vector<RoutingGraph::EdgeIndex> edges;
+    size_t firstFrom = 0;        // first shape position of edges.front() that is travelled
+    size_t lastUntil = SIZE_MAX; // shape position edges.back() stops at, SIZE_MAX for its head
+};
+
+// First shape position after the start on e, if e is one of the seeds.
+size_t seedFrom(const Endpoints& ends, RoutingGraph::EdgeIndex e) {
+    size_t from = 0;
+    for (const auto& seed : ends.seeds) {
+        if (seed.edge == e) from = seed.index + 1;
+    }
+    return from;
+}
+
+// Follows the chain of search states ending at `last` back to the start.
+// edgeOf(state, previous core node) names the edge a non-hit state was reached by.
+template <typename EdgeOf>
+EdgeRoute routeFromStates(const RoutingGraph& graph, NodeIndex start, const Endpoints& ends,
+                          const SearchWorkspace& ws, uint32_t last, EdgeOf edgeOf,
+                          std::pmr::memory_resource* mem = std::pmr::get_default_resource()) {
+    std::pmr::vector<uint32_t> states(mem);
+    for (uint32_t at = last; at != RoutingGraph::INVALID_STATE; at = ws.parent[at]) states.push_back(at);
+    std::reverse(states.begin(), states.end());
+
+    EdgeRoute route(mem);
+    NodeIndex at = start;
+    for (size_t i = 0; i < states.size(); ++i) {
+        const uint32_t s = states[i];
+        if (s >= ends.firstHitState) {
+            const Endpoints::Hit& hit = ends.hits[s - ends.firstHitState];
+            if (hit.direct) route.firstFrom = seedFrom(ends, hit.edge);
+            route.edges.push_back(hit.edge);
+            route.lastUntil = hit.index;
+            break;
+        }
+        const RoutingGraph::EdgeIndex e = edgeOf(s, i == 0 ? RoutingGraph::INVALID_NODE : at);
+        if (e == RoutingGraph::INVALID_EDGE) continue; // the core start itself
+        if (i == 0 && !graph.isCore(start)) route.firstFrom = seedFrom(ends, e);
+        route.edges.push_back(e);
+        at = graph.edge(e).to;
+    }
+    return route;
+}
+
+// OSM-level nodes along route.
+std::vector<NodeIndex> expandRoute(const RoutingGraph& graph, NodeIndex start, const EdgeRoute& route) {
+    // sized up front: the path is the one allocation a warm query makes
+    size_t most = 1;
+    for (RoutingGraph::EdgeIndex e : route.edges) most += graph.shape(e).size() + 1;
+    std::vector<NodeIndex> path;
+    path.reserve(most);
+    path.push_back(start);
+    for (size_t i = 0; i < route.edges.size(); ++i) {
+        appendEdge(graph, route.edges[i], i == 0 ? route.firstFrom : 0, path,
+                   i + 1 == route.edges.size() ? route.lastUntil : SIZE_MAX);
+    }
+    return path;
+}
+
+// Edge a node-based search in ws took into core node s from core node prev, or
+// from the start if prev is INVALID_NODE: the cheapest one, as the search relaxed.
+RoutingGraph::EdgeIndex nodeSearchEdge(const RoutingGraph& graph, const SearchOptions& options, NodeIndex start,
+                                       const Endpoints& ends, const SearchWorkspace& ws, uint32_t s, NodeIndex prev) {
+    if (prev == RoutingGraph::INVALID_NODE) {
+        if (graph.isCore(start)) return RoutingGraph::INVALID_EDGE;
+        // entered from a seed; the cheapest one into s set its cost
+        const Endpoints::Seed* best = nullptr;
+        for (const auto& seed : ends.seeds) {
+            if (graph.edge(seed.edge).to == s && (!best || seed.cost < best->cost)) best = &seed;
+        }
+        return best ? best->edge : RoutingGraph::INVALID_EDGE;
+    }
+    RoutingGraph::EdgeIndex best = RoutingGraph::INVALID_EDGE;
+    double bestCost = 0.0;
+    for (const auto& edge : graph.edges(prev)) {
+        if (edge.to != s || !edge.allows(options.profile)) continue;
+        const RoutingGraph::EdgeIndex e = graph.edgeIndex(edge);
+        const double c = graph.cost(e, options.metric, options.profile) * edgeFactor(options, e, ws.gScore[prev]);
+        if (best == RoutingGraph::INVALID_EDGE || c < bestCost) {
+            best = graph.edgeIndex(edge);
+            bestCost = c;
+        }
+    }
+    return best;
+}
+
+// Cost of travelling route from start with the turn penalties, traffic and,
+// for profiles that obey them, turn restrictions of options; +infinity if the
+// route takes a banned turn.
+double routeCost(const RoutingGraph& graph, NodeIndex start, const EdgeRoute& route, const SearchOptions& options) {
+    const bool restricted = graph.hasTurnRestrictions(options.profile);
+    double total = 0.0;
+    RoutingGraph::TurnState state = RoutingGraph::INVALID_STATE;
+    NodeIndex tail = start;
+    for (size_t i = 0; i < route.edges.size(); ++i) {
+        const RoutingGraph::EdgeIndex e = route.edges[i];
+        const RoutingGraph::ShapeRange s = graph.shape(e);
+        double c = i + 1 == route.edges.size() && route.lastUntil != SIZE_MAX
+                       ? s[route.lastUntil].cost(options.metric, options.profile)
+                       : graph.cost(e, options.metric, options.profile);
+        if (i == 0 && route.firstFrom > 0) c -= s[route.firstFrom - 1].cost(options.metric, options.profile);
+
+        if (i == 0) {
+            state = e;
+        } else {
+            const RoutingGraph::EdgeIndex in = route.edges[i - 1];
+            state = restricted ? graph.nextTurnState(state, e, options.profile) : e;
+            if (state == RoutingGraph::INVALID_STATE) return std::numeric_limits<double>::infinity();
+            total += turnPenalty(graph, options, in, lastHopFrom(graph, in, tail), e);
+            tail = graph.edge(in).to;
+        }
+        total += c * edgeFactor(options, e, total);
+    }
+    return total;
+}
+
+// Dijkstra towards goal over incoming edges, settling core nodes up to bound.
+// ws.parent holds the edge each node leaves by on its way to goal
+// (INVALID_STATE at goal itself); for a shape goal the tails of its edges leave
+// by those edges, which end part-way at goal. order receives the settled nodes.
+void backwardTree(const RoutingGraph& graph, NodeIndex goal, const SearchOptions& options, double bound,
+                  SearchWorkspace& ws, std::vector<NodeIndex>& order) {
+    const uint8_t allowed = profileBit(options.profile);
+    ws.reset(graph.coreNodeCount());
+    auto reach = [&](NodeIndex u, double g, uint32_t via) {
+        if (g > bound) return;
+        if (!ws.touched(u) || g < ws.gScore[u]) {
+            ws.touch(u, g, via);
+            pushQueue(ws, g, g, u);
+        }
+    };
+    if (graph.isCore(goal)) {
+        reach(goal, 0.0, RoutingGraph::INVALID_STATE);
+    } else {
+        RoutingGraph::ShapeRef refs[2];
+        const size_t count = graph.shapeRefs(goal, refs, options.profile);
+        for (size_t k = 0; k < count; ++k) {
+            const double factor = edgeFactor(options, refs[k].edge, 0.0);
+            if (std::isinf(factor)) continue; // closed
+            reach(graph.edgeTail(refs[k].edge),
+                  graph.shape(refs[k].edge)[refs[k].index].cost(options.metric, options.profile) * factor,
+                  refs[k].edge);
+        }
+    }
+
+    while (!ws.heap.empty()) {
+        const SearchWorkspace::QueueItem current = popQueue(ws);
+        const NodeIndex v = current.state;
+        if (current.g > ws.gScore[v]) continue; // stale entry
+
+        ws.nodesExplored++;
+        order.push_back(v);
+        for (const auto& in : graph.incoming(v)) {
+            if (!(graph.edge(in.edge).profiles & allowed)) continue;
+            const double factor = edgeFactor(options, in.edge, 0.0);
+            if (std::isinf(factor)) continue; // closed
+            reach(in.from, current.g + graph.cost(in.edge, options.metric, options.profile) * factor, in.edge);
+        }
+    }
+}
 
-            // determine one-way behavior
-            bool oneway = false;
-            bool oneway_reverse = false;
-            const char* oneway_tag = way.tags()["oneway"];
-            const char* junction_tag = way.tags()["junction"];
-            if (junction_tag && std::string(junction_tag) == "roundabout") {
-                oneway = true;
+// OSM-level nodes from start to state `last` of the nodeSearch() (or, if
+// turns, turnSearch()) in ws.
+std::vector<NodeIndex> settledPath(const RoutingGraph& graph, NodeIndex start, const Endpoints& ends,
+                                   const SearchWorkspace& ws, uint32_t last, const SearchOptions& options, bool turns,
+                                   std::pmr::memory_resource* mem = std::pmr::get_default_resource()) {
+    if (!turns) {
+        // states are core nodes; between two of them take the cheapest edge, as the search did
+        return expandRoute(graph, start, routeFromStates(graph, start, ends, ws, last, [&](uint32_t s, NodeIndex prev) {
+            return nodeSearchEdge(graph, options, start, ends, ws, s, prev);
+        }, mem));
+    }
+    return expandRoute(graph, start, routeFromStates(graph, start, ends, ws, last, [&](uint32_t s, NodeIndex) {
+        return graph.stateEdge(s);
+    }, mem));
+}
+
+// astar() under budget: weighted A* that stops once out of settles or time.
+SearchResult searchRoute(const RoutingGraph& graph, NodeIndex start, NodeIndex goal, SearchWorkspace& ws,
+                         const SearchOptions& options, const SearchBudget& budget = {}) {
+    ws.nodesExplored = 0;
+    SearchResult result;
+    if (start >= graph.nodeCount() || goal >= graph.nodeCount()) return result;
+    if (start == goal) {
+        result.path = {start};
+        result.status = SearchStatus::Optimal;
+        result.cost = result.lowerBound = 0.0;
+        return result;
+    }
+    if (!graph.mayReach(start, goal, options.profile)) return result; // separate components, nothing to search
+
+    const double weight = std::max(1.0, budget.heuristicWeight);
+    Heuristic h = towards(graph, goal, options);
+    const double plainScale = h.scale;
+    h.scale *= weight;
+    const bool timed = budget.maxTime.count() > 0;
+    const auto deadline = std::chrono::steady_clock::now() + budget.maxTime;
+
+    std::pmr::memory_resource* mem = ws.scratch->rewind();
+    Endpoints ends = endpointsFor(graph, start, &goal, 1, options, mem);
+    uint32_t last = RoutingGraph::INVALID_STATE;
+    bool outOfBudget = false;
+    uint32_t nearest = RoutingGraph::INVALID_STATE; // settled state closest to the goal, for Partial
+    double nearestH = 0.0;
+    // unweighted f of the state the budget stopped at: popped, so not in the
+    // heap, but its successors were never relaxed
+    double stoppedAt = std::numeric_limits<double>::infinity();
+    auto reached = [&](NodeIndex u, double g, uint32_t s) {
+        if (u == goal) {
+            last = s;
+            result.cost = g;
+            return true;
+        }
+        const double toGoal = graph.lowerBoundMeters(u, goal);
+        if (nearest == RoutingGraph::INVALID_STATE || toGoal < nearestH) {
+            nearest = s;
+            nearestH = toGoal;
+        }
+        if ((budget.maxSettled > 0 && ws.nodesExplored >= budget.maxSettled) ||
+            (timed && (ws.nodesExplored & 255) == 0 && std::chrono::steady_clock::now() >= deadline)) {
+            outOfBudget = true;
+            stoppedAt = g + plainScale * toGoal;
+            return true;
+        }
+        return false;
+    };
+
+    const bool turns = usesTurnSearch(graph, options);
+    if (turns) turnSearch(graph, start, ends, h, options, ws, reached);
+    else nodeSearch(graph, start, ends, h, options, ws, reached);
+
+    // queued states bound what is left: unweighted f = g + (key - g) / weight
+    double queued = stoppedAt;
+    for (const SearchWorkspace::QueueItem& item : ws.heap) {
+        if (item.g > ws.gScore[item.state]) continue; // stale entry
+        queued = std::min(queued, plainScale == 0.0 ? item.g : item.g + (item.key - item.g) / weight);
+    }
+    if (outOfBudget) {
+        last = nearest;
+        result.cost = ws.gScore[nearest];
+        result.status = SearchStatus::Partial;
+        result.lowerBound = queued;
+    } else if (last != RoutingGraph::INVALID_STATE) {
+        result.lowerBound = std::min(result.cost, queued);
+        result.status = weight == 1.0 || result.cost <= result.lowerBound ? SearchStatus::Optimal
+                                                                           : SearchStatus::Bounded;
+    } else {
+        return result;
+    }
+
+    result.path = settledPath(graph, start, ends, ws, last, options, turns, mem);
+    return result;
+}
+
+} // namespace
+
+std::vector<NodeIndex> astar(const RoutingGraph& graph, NodeIndex start, NodeIndex goal, SearchWorkspace& ws,
+                             const SearchOptions& options) {
+    return searchRoute(graph, start, goal, ws, options).path;
+}
+
+SearchResult astar(const RoutingGraph& graph, NodeIndex start, NodeIndex goal, SearchWorkspace& ws,
+                   const SearchOptions& options, const SearchBudget& budget) {
+    return searchRoute(graph, start, goal, ws, options, budget);
+}
+
+std::vector<Route> alternativeRoutes(const RoutingGraph& graph, NodeIndex start, NodeIndex goal,
+                                     SearchWorkspace& forward, SearchWorkspace& backward,
+                                     const SearchOptions& options, const AlternativeOptions& alternatives) {
+    forward.nodesExplored = 0;
+    backward.nodesExplored = 0;
+    if (start >= graph.nodeCount() || goal >= graph.nodeCount()) return {};
+    if (start == goal) return {{{start}, 0.0}};
+    if (!graph.mayReach(start, goal, options.profile)) return {};
+
+    // The trees ignore turns and traffic (closures and other overrides stay);
+    // with either, the best route comes from its own search and every candidate
+    // is re-costed by routeCost().
+    const bool turns = usesTurnSearch(graph, options);
+    const bool exact = turns || isTimed(options);
+    SearchOptions treeOptions = options;
+    treeOptions.traffic = nullptr;
+    Endpoints ends = endpointsFor(graph, start, &goal, 1, options);
+    Endpoints treeEnds = isTimed(options) ? endpointsFor(graph, start, &goal, 1, treeOptions) : ends;
+    auto viaForward = [&](uint32_t s, NodeIndex prev) {
+        return nodeSearchEdge(graph, treeOptions, start, treeEnds, forward, s, prev);
+    };
+
+    EdgeRoute best;
+    double bestCost = std::numeric_limits<double>::infinity();
+    size_t exactExplored = 0;
+    if (exact) {
+        uint32_t last = RoutingGraph::INVALID_STATE;
+        auto reached = [&](NodeIndex u, double g, uint32_t s) {
+            if (u != goal) return false;
+            last = s;
+            bestCost = g;
+            return true;
+        };
+        const Heuristic h = towards(graph, goal, options);
+        if (turns) turnSearch(graph, start, ends, h, options, forward, reached);
+        else nodeSearch(graph, start, ends, h, options, forward, reached);
+        if (last == RoutingGraph::INVALID_STATE) return {};
+        best = routeFromStates(graph, start, ends, forward, last, [&](uint32_t s, NodeIndex prev) {
+            return turns ? graph.stateEdge(s) : nodeSearchEdge(graph, options, start, ends, forward, s, prev);
+        });
+        exactExplored = forward.nodesExplored;
+    }
+
+    // forward tree up to the stretch bound, which is known once goal is settled
+    double bound = exact ? bestCost * (1.0 + alternatives.maxStretch) : bestCost;
+    uint32_t goalState = RoutingGraph::INVALID_STATE;
+    std::vector<NodeIndex> forwardOrder;
+    nodeSearch(graph, start, treeEnds, Heuristic{}, treeOptions, forward, [&](NodeIndex u, double g, uint32_t s) {
+        if (g > bound) return true;
+        if (u == goal && goalState == RoutingGraph::INVALID_STATE) {
+            goalState = s;
+            if (!exact) {
+                bestCost = g;
+                bound = g * (1.0 + alternatives.maxStretch);
             }
-            if (oneway_tag) {
-                std::string ow(oneway_tag);
-                if (ow == "yes" || ow == "true" || ow == "1") oneway = true;
-                else if (ow == "-1") oneway_reverse = true;
+        }
+        if (s < treeEnds.firstHitState) forwardOrder.push_back(u);
+        return false;
+    });
+    forward.nodesExplored += exactExplored;
+    if (!exact) {
+        if (goalState == RoutingGraph::INVALID_STATE) return {};
+        best = routeFromStates(graph, start, treeEnds, forward, goalState, viaForward);
+    }
+
+    std::vector<Route> routes{{expandRoute(graph, start, best), bestCost}};
+    if (alternatives.count == 0) return routes;
+
+    std::vector<NodeIndex> backwardOrder;
+    backwardTree(graph, goal, treeOptions, bound, backward, backwardOrder);
+
+    // A plateau is a run of edges u -> v that is in both trees; every via node
+    // on it gives the same path, and that path is a shortest path along the
+    // whole plateau. Walking each tree in settle order carries the plateau's
+    // first node forwards and its last node backwards.
+    RoutingGraph::ShapeRef goalRefs[2];
+    const size_t goalRefCount = graph.isCore(goal) ? 0 : graph.shapeRefs(goal, goalRefs, options.profile);
+    auto endsAtGoal = [&](RoutingGraph::EdgeIndex e) {
+        for (size_t k = 0; k < goalRefCount; ++k) {
+            if (goalRefs[k].edge == e) return true;
+        }
+        return false;
+    };
+    auto inBoth = [&](NodeIndex v) { return forward.touched(v) && backward.touched(v); };
+    auto treeEdge = [&](NodeIndex u, NodeIndex v) {
+        const uint32_t e = backward.parent[u];
+        return e != RoutingGraph::INVALID_STATE && !endsAtGoal(e) && graph.edge(e).to == v;
+    };
+    std::vector<NodeIndex> plateauFirst(graph.coreNodeCount(), RoutingGraph::INVALID_NODE);
+    std::vector<NodeIndex> plateauLast(graph.coreNodeCount(), RoutingGraph::INVALID_NODE);
+    for (NodeIndex v : forwardOrder) {
+        if (!inBoth(v)) continue;
+        const NodeIndex u = forward.parent[v];
+        plateauFirst[v] = u != RoutingGraph::INVALID_NODE && inBoth(u) && treeEdge(u, v) ? plateauFirst[u] : v;
+    }
+    for (NodeIndex u : backwardOrder) {
+        if (!inBoth(u)) continue;
+        const uint32_t e = backward.parent[u];
+        const bool joins = e != RoutingGraph::INVALID_STATE && !endsAtGoal(e) && inBoth(graph.edge(e).to) &&
+                           forward.parent[graph.edge(e).to] == u;
+        plateauLast[u] = joins ? plateauLast[graph.edge(e).to] : u;
+    }
+
+    struct Candidate {
+        NodeIndex via; // first node of its plateau
+        double cost;
+        double plateau;
+    };
+    std::vector<Candidate> candidates;
+    for (NodeIndex v : forwardOrder) {
+        if (!inBoth(v) || plateauFirst[v] != v) continue;
+        const double cost = forward.gScore[v] + backward.gScore[v];
+        const double plateau = backward.gScore[v] - backward.gScore[plateauLast[v]];
+        if (cost <= bound && plateau >= alternatives.minPlateau * bestCost) candidates.push_back({v, cost, plateau});
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+        return a.cost != b.cost ? a.cost < b.cost : a.plateau > b.plateau;
+    });
+
+    // edges of the routes picked so far, each list sorted
+    std::vector<std::vector<RoutingGraph::EdgeIndex>> picked{{best.edges.begin(), best.edges.end()}};
+    std::sort(picked[0].begin(), picked[0].end());
+    std::vector<NodeIndex> visited;
+    for (const Candidate& c : candidates) {
+        if (routes.size() > alternatives.count) break;
+
+        EdgeRoute route = routeFromStates(graph, start, treeEnds, forward, c.via, viaForward);
+        for (NodeIndex u = c.via;;) {
+            const uint32_t e = backward.parent[u];
+            if (e == RoutingGraph::INVALID_STATE) break;
+            route.edges.push_back(e);
+            if (endsAtGoal(e)) {
+                for (size_t k = 0; k < goalRefCount; ++k) {
+                    if (goalRefs[k].edge == e) route.lastUntil = goalRefs[k].index;
+                }
+                break;
             }
+            u = graph.edge(e).to;
+        }
+
+        // start -> via and via -> goal may cross; such a path is not simple
+        visited.clear();
+        if (graph.isCore(start)) visited.push_back(start);
+        for (size_t i = 0; i < route.edges.size(); ++i) {
+            if (i + 1 < route.edges.size() || route.lastUntil == SIZE_MAX) visited.push_back(graph.edge(route.edges[i]).to);
+        }
+        std::sort(visited.begin(), visited.end());
+        if (std::adjacent_find(visited.begin(), visited.end()) != visited.end()) continue;
+
+        const double cost = routeCost(graph, start, route, options);
+        if (cost > bestCost * (1.0 + alternatives.maxStretch)) continue;
 
-            const osmium::WayNodeList& wnl = way.nodes();
-            // add edges according to the directionality indicated by tags
-            for (auto it = wnl.begin(); std::next(it) != wnl.end(); ++it) {
-                int64_t id1 = it->ref();
-                int64_t id2 = std::next(it)->ref();
-                if (!nodes.count(id1) || !nodes.count(id2)) continue; // skip if coordinates unknown
-
-                double d = haversine(nodes[id1].lat, nodes[id1].lon,
-                                     nodes[id2].lat, nodes[id2].lon);
-
-                if (oneway_reverse) {
-                    // edge only from id2 -> id1
-                    adj[id2].push_back({id1, d});
-                } else if (oneway) {
-                    // edge only from id1 -> id2 (way node order)
-                    adj[id1].push_back({id2, d});
-                } else {
-                    // bidirectional (normal two-way street)
-                    adj[id1].push_back({id2, d});
-                    adj[id2].push_back({id1, d});
+        bool distinct = true;
+        for (const auto& edges : picked) {
+            double shared = 0.0;
+            for (RoutingGraph::EdgeIndex e : route.edges) {
+                if (std::binary_search(edges.begin(), edges.end(), e)) {
+                    shared += graph.cost(e, options.metric, options.profile);
                 }
             }
+            if (shared > alternatives.maxSharing * bestCost) {
+                distinct = false;
+                break;
+            }
         }
+        if (!distinct) continue;
+
+        routes.push_back({expandRoute(graph, start, route), cost});
+        picked.emplace_back(route.edges.begin(), route.edges.end());
+        std::sort(picked.back().begin(), picked.back().end());
+    }
+    return routes;
+}
+
+std::vector<double> distancesFrom(const RoutingGraph& graph, NodeIndex source,
+                                  const std::vector<NodeIndex>& targets, SearchWorkspace& ws,
+                                  const SearchOptions& options) {
+    const double INF = std::numeric_limits<double>::infinity();
+    std::vector<double> result(targets.size(), INF);
+    ws.nodesExplored = 0;
+    if (source >= graph.nodeCount()) return result;
+
+    // sorted (node, result slot) pairs; the same node may be requested twice
+    std::pmr::memory_resource* mem = ws.scratch->rewind();
+    std::pmr::vector<std::pair<NodeIndex, size_t>> pending(mem);
+    pending.reserve(targets.size());
+    for (size_t i = 0; i < targets.size(); ++i) {
+        if (targets[i] == source) result[i] = 0.0;
+        else if (targets[i] < graph.nodeCount() && graph.mayReach(source, targets[i], options.profile)) {
+            pending.push_back({targets[i], i});
+        }
+    }
+    std::sort(pending.begin(), pending.end());
+    size_t remaining = pending.size();
+    if (remaining == 0) return result;
+
+    auto settle = [&](NodeIndex u, double g, uint32_t) {
+        auto hit = std::lower_bound(pending.begin(), pending.end(), std::make_pair(u, size_t(0)));
+        for (; hit != pending.end() && hit->first == u; ++hit) {
+            if (result[hit->second] == INF) {
+                result[hit->second] = g;
+                --remaining;
+            }
+        }
+        return remaining == 0;
     };
 
-    try {
-        osmium::io::Reader reader(filename);
-        MapHandler handler;
-        osmium::apply(reader, handler);
-        reader.close();
-        std::cout << "Map loaded successfully! Nodes: " << nodes.size()
-                  << "  Adjacencies (non-empty keys): " << adj.size() << "\n";
-    } catch (const std::exception& e) {
-        std::cerr << "Error reading Karachi map: " << e.what() << "\n";
+    const Heuristic none;
+    Endpoints ends = endpointsFor(graph, source, targets.data(), targets.size(), options, mem);
+    if (!usesTurnSearch(graph, options)) {
+        nodeSearch(graph, source, ends, none, options, ws, settle);
+    } else {
+        turnSearch(graph, source, ends, none, options, ws, settle);
     }
+    return result;
 }
 
-std::vector<int64_t> astar(int64_t start, int64_t goal) {
-    std::unordered_map<int64_t, double> gScore;
-    std::unordered_map<int64_t, double> fScore;
-    std::unordered_map<int64_t, int64_t> parent;
+std::vector<double> oneToAll(const RoutingGraph& graph, const std::vector<NodeIndex>& sources, SearchWorkspace& ws,
+                             const SearchOptions& options, double maxCost) {
+    std::vector<double> cost(graph.nodeCount(), std::numeric_limits<double>::infinity());
+    ws.nodesExplored = 0;
+    if (!usesTurnSearch(graph, options)) {
+        bucketSearch(graph, sources, options, maxCost, ws, cost);
+        return cost;
+    }
+
+    // turn-aware: one edge-based search per source
+    size_t explored = 0;
+    for (NodeIndex source : sources) {
+        if (source >= graph.nodeCount()) continue;
+        cost[source] = 0.0;
+        auto settle = [&](NodeIndex u, double g, uint32_t) {
+            if (g > maxCost) return true;
+            cost[u] = std::min(cost[u], g);
+            return false;
+        };
+        auto relaxShape = [&](RoutingGraph::EdgeIndex e, double g, double factor, size_t from = 0) {
+            const RoutingGraph::ShapeRange s = graph.shape(e);
+            for (size_t i = from; i < s.size(); ++i) {
+                const double c = g + s[i].cost(options.metric, options.profile) * factor;
+                if (c > maxCost) break;
+                cost[s[i].node] = std::min(cost[s[i].node], c);
+            }
+        };
+
+        const Heuristic none;
+        Endpoints ends = endpointsFor(graph, source, nullptr, 0, options);
+        for (const auto& seed : ends.seeds) {
+            const double factor = edgeFactor(options, seed.edge, 0.0);
+            relaxShape(seed.edge, -graph.shape(seed.edge)[seed.index].cost(options.metric, options.profile) * factor,
+                       factor, seed.index + 1);
+        }
+        turnSearch(graph, source, ends, none, options, ws, settle,
+                   [&](RoutingGraph::EdgeIndex e, double g, double factor) { relaxShape(e, g, factor); });
+        explored += ws.nodesExplored;
+    }
+    ws.nodesExplored = explored;
+    return cost;
+}
 
-    gScore[start] = 0.0;
-    fScore[start] = haversine(nodes[start].lat, nodes[start].lon,
-                              nodes[goal].lat, nodes[goal].lon);
+// LPA* over core nodes rooted at start, plus one sink state standing for the
+// goal: its predecessors are the tails of the goal's edges (or the goal
+// itself, if core). Keys are (min(g, rhs) + h + km, min(g, rhs)); when the goal
+// moves, km grows by the most any heuristic value can drop, so queued keys
+// stay lower bounds (D* Lite) and nothing has to be re-keyed up front.
+struct IncrementalRoute::State {
+    using Key = std::pair<double, double>;
+    static constexpr double INF = std::numeric_limits<double>::infinity();
 
-    auto cmp = [](const std::pair<int64_t, double>& a, const std::pair<int64_t, double>& b) {
-        return a.second > b.second;
+    // a way into the goal: from core node tail, along edge (INVALID_EDGE for a core goal) at cost
+    struct Entry {
+        NodeIndex tail;
+        RoutingGraph::EdgeIndex edge;
+        double cost;
     };
-    std::priority_queue<std::pair<int64_t, double>,
-                       std::vector<std::pair<int64_t, double>>,
-                       decltype(cmp)> openSet(cmp);
 
-    openSet.push({start, fScore[start]});
+    const RoutingGraph& graph;
+    SearchOptions options;
+    const bool incremental;
+    const uint8_t allowed;
+    const double scale;
+    const uint32_t sink;
+    NodeIndex start = RoutingGraph::INVALID_NODE;
+    NodeIndex goal = RoutingGraph::INVALID_NODE;
+    double km = 0.0;
+    bool reachable = false;
+    bool done = true;
+    size_t explored = 0;
 
-    int nodes_explored = 0;
+    std::vector<double> g, rhs;
+    std::vector<uint8_t> queued;  // whether a state has a live heap entry
+    std::vector<Key> queuedKey;   // its key; other entries for the state are stale
+    std::vector<SearchWorkspace::QueueItem> heap; // key = first, g = second of the Key
+    Endpoints ends;
+    std::vector<Entry> entries;
 
-    while (!openSet.empty()) {
-        auto current_pair = openSet.top();
-        openSet.pop();
-        int64_t current = current_pair.first;
-        double current_fscore_in_queue = current_pair.second;
+    // plain A* when the search cannot be incremental, resumed across update()s
+    SearchWorkspace ws;
+    Heuristic h;
+    bool seeded = false; // whether ws holds the search for the current endpoints and weights
+    std::vector<NodeIndex> fullPath;
+    double fullCost = INF;
 
-        if (fScore.count(current) && current_fscore_in_queue > fScore[current] + 1e-9) {
-            continue; // stale entry
+    State(const RoutingGraph& graph, const SearchOptions& options)
+        : graph(graph), options(options),
+          incremental(!usesTurnSearch(graph, options) && !isTimed(options)),
+          allowed(profileBit(options.profile)),
+          scale(graph.heuristicScale(options.metric, options.profile)),
+          sink(static_cast<uint32_t>(graph.coreNodeCount())) {}
+
+    static bool heapGreater(const SearchWorkspace::QueueItem& a, const SearchWorkspace::QueueItem& b) {
+        return a.key != b.key ? a.key > b.key : a.g > b.g;
+    }
+
+    double edgeCost(RoutingGraph::EdgeIndex e) const {
+        if (!(graph.edge(e).profiles & allowed)) return INF;
+        const double factor = edgeFactor(options, e, 0.0);
+        return std::isinf(factor) ? INF : graph.cost(e, options.metric, options.profile) * factor;
+    }
+
+    Key key(uint32_t s) const {
+        const double m = std::min(g[s], rhs[s]);
+        const double h = s == sink ? 0.0 : scale * graph.lowerBoundMeters(s, goal);
+        return {m + h + km, m};
+    }
+
+    void push(uint32_t s) {
+        const Key k = key(s);
+        queued[s] = 1;
+        queuedKey[s] = k;
+        heap.push_back({k.first, k.second, s});
+        std::push_heap(heap.begin(), heap.end(), heapGreater);
+        if (heap.size() > 4 * g.size()) {
+            // mostly stale entries after a long drag
+            heap.erase(std::remove_if(heap.begin(), heap.end(), [&](const SearchWorkspace::QueueItem& item) {
+                           return !queued[item.state] || queuedKey[item.state] != Key{item.key, item.g};
+                       }), heap.end());
+            std::make_heap(heap.begin(), heap.end(), heapGreater);
+        }
+    }
+
+    // Drops stale entries off the top; {INF, INF} once the queue is empty.
+    Key topKey() {
+        while (!heap.empty()) {
+            const SearchWorkspace::QueueItem& top = heap.front();
+            if (queued[top.state] && queuedKey[top.state] == Key{top.key, top.g}) return {top.key, top.g};
+            std::pop_heap(heap.begin(), heap.end(), heapGreater);
+            heap.pop_back();
         }
+        return {INF, INF};
+    }
 
-        nodes_explored++;
+    double computeRhs(uint32_t s) const {
+        double best = INF;
+        if (s == sink) {
+            for (size_t k = ends.edgeHits; k < ends.hits.size(); ++k) best = std::min(best, ends.hits[k].cost);
+            for (const Entry& in : entries) best = std::min(best, g[in.tail] + in.cost);
+            return best;
+        }
+        for (const auto& seed : ends.seeds) {
+            if (graph.edge(seed.edge).to == s) best = std::min(best, seed.cost);
+        }
+        for (const auto& in : graph.incoming(s)) best = std::min(best, g[in.from] + edgeCost(in.edge));
+        return best;
+    }
 
-        if (current == goal) {
-            std::vector<int64_t> path;
-            for (int64_t at = goal; at != start; at = parent[at]) {
-                path.push_back(at);
+    void updateVertex(uint32_t s) {
+        if (s != start) rhs[s] = computeRhs(s); // a core start is the root, rhs 0
+        queued[s] = 0;
+        if (g[s] != rhs[s]) push(s);
+    }
+
+    // States whose rhs may depend on g[u].
+    void updateSuccessors(NodeIndex u) {
+        for (const auto& edge : graph.edges(u)) {
+            if (edge.profiles & allowed) updateVertex(edge.to);
+        }
+        for (const Entry& in : entries) {
+            if (in.tail == u) {
+                updateVertex(sink);
+                break;
             }
-            path.push_back(start);
-            std::reverse(path.begin(), path.end());
-            std::cout << "Path found! Nodes explored: " << nodes_explored << "\n";
-            return path;
         }
+    }
 
-        if (!adj.count(current)) continue;
+    void setGoalEntries() {
+        ends = endpointsFor(graph, start, &goal, 1, options);
+        entries.clear();
+        if (graph.isCore(goal)) {
+            entries.push_back({goal, RoutingGraph::INVALID_EDGE, 0.0});
+            return;
+        }
+        for (size_t k = 0; k < ends.edgeHits; ++k) {
+            const double factor = edgeFactor(options, ends.hits[k].edge, 0.0);
+            if (std::isinf(factor)) continue; // closed
+            entries.push_back({graph.edgeTail(ends.hits[k].edge), ends.hits[k].edge, ends.hits[k].cost * factor});
+        }
+    }
 
-        for (const auto& edge : adj[current]) {
-            double tentative_gScore = gScore[current] + edge.weight;
+    void restart() {
+        const size_t states = graph.coreNodeCount() + 1;
+        g.assign(states, INF);
+        rhs.assign(states, INF);
+        queued.assign(states, 0);
+        queuedKey.resize(states);
+        heap.clear();
+        km = 0.0;
+        setGoalEntries();
+        if (graph.isCore(start)) {
+            rhs[start] = 0.0;
+            push(start);
+        }
+        for (const auto& seed : ends.seeds) updateVertex(graph.edge(seed.edge).to);
+        updateVertex(sink);
+    }
 
-            if (!gScore.count(edge.to) || tentative_gScore < gScore[edge.to]) {
-                parent[edge.to] = current;
-                gScore[edge.to] = tentative_gScore;
-                fScore[edge.to] = tentative_gScore +
-                    haversine(nodes[edge.to].lat, nodes[edge.to].lon,
-                              nodes[goal].lat, nodes[goal].lon);
+    // LPA*'s ComputeShortestPath, stopping at deadline.
+    bool search(std::chrono::steady_clock::time_point deadline) {
+        for (size_t n = 1;; ++n) {
+            // run through ties too: a core goal shares the sink's key
+            const Key top = topKey();
+            if (rhs[sink] == g[sink] && (heap.empty() || key(sink) < top)) return true;
+            if ((n & 63) == 0 && std::chrono::steady_clock::now() >= deadline) return false;
+
+            std::pop_heap(heap.begin(), heap.end(), heapGreater);
+            const uint32_t u = heap.back().state;
+            heap.pop_back();
+            queued[u] = 0;
+            if (top < key(u)) {
+                push(u); // its heuristic dropped since it was queued
+            } else if (g[u] > rhs[u]) {
+                g[u] = rhs[u];
+                ++explored;
+                if (u != sink) updateSuccessors(u);
+            } else {
+                g[u] = INF;
+                updateVertex(u);
+                if (u != sink) updateSuccessors(u);
+            }
+        }
+    }
 
-                openSet.push({edge.to, fScore[edge.to]});
+    // A* over turn states (or, for timed searches, core nodes) from the
+    // start, stopping at deadline; the next call carries on from its queue.
+    bool searchFull(std::chrono::steady_clock::time_point deadline) {
+        const bool turns = usesTurnSearch(graph, options);
+        if (!seeded) {
+            h = towards(graph, goal, options);
+            ends = endpointsFor(graph, start, &goal, 1, options);
+            if (turns) seedTurnSearch(graph, start, ends, h, options, ws, NoRelax{});
+            else seedNodeSearch(graph, start, ends, h, ws);
+            fullPath.clear();
+            fullCost = INF;
+            seeded = true;
+        }
+        uint32_t last = RoutingGraph::INVALID_STATE;
+        bool outOfTime = false;
+        auto reached = [&](NodeIndex u, double cost, uint32_t s) {
+            if (u == goal) {
+                last = s;
+                fullCost = cost;
+                return true;
+            }
+            if ((ws.nodesExplored & 255) == 0 && std::chrono::steady_clock::now() >= deadline) {
+                // not expanded yet: back on the queue for the next call
+                --ws.nodesExplored;
+                pushQueue(ws, cost + h(graph, u), cost, s);
+                outOfTime = true;
+                return true;
+            }
+            return false;
+        };
+        if (turns) expandTurnSearch(graph, start, ends, h, options, ws, reached, NoRelax{});
+        else expandNodeSearch(graph, ends, h, options, ws, reached);
+        explored = ws.nodesExplored;
+        if (outOfTime) return false;
+        if (last != RoutingGraph::INVALID_STATE) fullPath = settledPath(graph, start, ends, ws, last, options, turns);
+        return true;
+    }
+
+    // Walks the settled search back from the sink.
+    std::vector<NodeIndex> extract() const {
+        if (!(g[sink] < INF)) return {};
+        EdgeRoute route;
+        for (size_t k = ends.edgeHits; k < ends.hits.size(); ++k) {
+            if (ends.hits[k].cost == g[sink]) {
+                route.edges.push_back(ends.hits[k].edge);
+                route.firstFrom = seedFrom(ends, ends.hits[k].edge);
+                route.lastUntil = ends.hits[k].index;
+                return expandRoute(graph, start, route);
+            }
+        }
+        const Entry* best = nullptr;
+        for (const Entry& in : entries) {
+            if (!best || g[in.tail] + in.cost < g[best->tail] + best->cost) best = &in;
+        }
+        if (best->edge != RoutingGraph::INVALID_EDGE) {
+            route.edges.push_back(best->edge);
+            for (size_t k = 0; k < ends.edgeHits; ++k) {
+                if (ends.hits[k].edge == best->edge) route.lastUntil = ends.hits[k].index;
             }
         }
+        for (NodeIndex v = best->tail; v != start;) {
+            if (route.edges.size() > graph.coreNodeCount()) return {}; // no way back; cannot happen once settled
+            const Endpoints::Seed* seed = nullptr;
+            for (const auto& s : ends.seeds) {
+                if (graph.edge(s.edge).to == v && (!seed || s.cost < seed->cost)) seed = &s;
+            }
+            RoutingGraph::EdgeIndex via = RoutingGraph::INVALID_EDGE;
+            double viaCost = INF;
+            for (const auto& in : graph.incoming(v)) {
+                const double c = g[in.from] + edgeCost(in.edge);
+                if (c < viaCost) {
+                    via = in.edge;
+                    viaCost = c;
+                }
+            }
+            if (seed && seed->cost <= viaCost) {
+                route.edges.push_back(seed->edge);
+                route.firstFrom = seed->index + 1;
+                break;
+            }
+            if (via == RoutingGraph::INVALID_EDGE) return {};
+            route.edges.push_back(via);
+            v = graph.edgeTail(via);
+        }
+        std::reverse(route.edges.begin(), route.edges.end());
+        return expandRoute(graph, start, route);
     }
+};
+
+IncrementalRoute::IncrementalRoute(const RoutingGraph& graph, const SearchOptions& options)
+    : m_state(std::make_unique<State>(graph, options)) {}
+
+IncrementalRoute::~IncrementalRoute() = default;
 
-    std::cout << "No path found after exploring " << nodes_explored << " nodes.\n";
-    return {};
+void IncrementalRoute::setEndpoints(NodeIndex start, NodeIndex goal) {
+    State& st = *m_state;
+    if (start >= st.graph.nodeCount() || goal >= st.graph.nodeCount()) {
+        st.start = st.goal = RoutingGraph::INVALID_NODE;
+        st.done = true;
+        return;
+    }
+    if (start == st.start && goal == st.goal) return;
+    st.done = false;
+    st.explored = 0;
+    st.reachable = start != goal && st.graph.mayReach(start, goal, st.options.profile);
+    if (!st.incremental) {
+        st.start = start;
+        st.goal = goal;
+        st.seeded = false;
+        return;
+    }
+    if (start != st.start) {
+        st.start = start;
+        st.goal = goal;
+        st.restart();
+        return;
+    }
+    // the heuristic towards the new goal is at most this much lower anywhere
+    st.km += st.scale * (st.graph.lowerBoundMeters(st.goal, goal) + 2.0 * CHORD_MARGIN_M);
+    st.goal = goal;
+    st.setGoalEntries();
+    st.updateVertex(st.sink);
+}
+
+void IncrementalRoute::setOverrides(const WeightOverrides* overrides) {
+    State& st = *m_state;
+    const std::vector<RoutingGraph::EdgeIndex> changed =
+        WeightOverrides::changedEdges(st.options.overrides, overrides);
+    st.options.overrides = overrides;
+    if (changed.empty() || st.start == RoutingGraph::INVALID_NODE) return;
+    st.done = false;
+    st.explored = 0;
+    if (!st.incremental) {
+        st.seeded = false;
+        return;
+    }
+
+    const std::vector<Endpoints::Seed> oldSeeds(st.ends.seeds.begin(), st.ends.seeds.end());
+    st.setGoalEntries();
+    for (const auto& seed : oldSeeds) st.updateVertex(st.graph.edge(seed.edge).to);
+    for (const auto& seed : st.ends.seeds) st.updateVertex(st.graph.edge(seed.edge).to);
+    for (RoutingGraph::EdgeIndex e : changed) st.updateVertex(st.graph.edge(e).to);
+    st.updateVertex(st.sink);
+}
+
+bool IncrementalRoute::update(std::chrono::microseconds budget) {
+    State& st = *m_state;
+    if (st.done) return true;
+    if (!st.reachable) {
+        st.done = true;
+        return true;
+    }
+    const auto now = std::chrono::steady_clock::now();
+    const auto deadline = budget >= std::chrono::duration_cast<std::chrono::microseconds>(
+                                        std::chrono::steady_clock::time_point::max() - now)
+                              ? std::chrono::steady_clock::time_point::max()
+                              : now + budget;
+    st.done = st.incremental ? st.search(deadline) : st.searchFull(deadline);
+    return st.done;
+}
+
+bool IncrementalRoute::done() const { return m_state->done; }
+
+std::vector<NodeIndex> IncrementalRoute::path() const {
+    const State& st = *m_state;
+    if (!st.done || st.start == RoutingGraph::INVALID_NODE) return {};
+    if (st.start == st.goal) return {st.start};
+    if (!st.reachable) return {};
+    if (!st.incremental) return st.fullPath;
+    return st.extract();
+}
+
+double IncrementalRoute::cost() const {
+    const State& st = *m_state;
+    if (st.start == RoutingGraph::INVALID_NODE || !st.done) return State::INF;
+    if (st.start == st.goal) return 0.0;
+    if (!st.reachable) return State::INF;
+    return st.incremental ? st.g[st.sink] : st.fullCost;
+}
+
+size_t IncrementalRoute::nodesExplored() const { return m_state->explored; }
+
+PathLength measurePath(const RoutingGraph& graph, const std::vector<NodeIndex>& path, Metric metric,
+                       Profile profile, const TrafficModel* traffic, double departure,
+                       const WeightOverrides* overrides) {
+    PathLength total;
+    const bool timed = traffic && followsTraffic(profile);
+    RoutingGraph::EdgeIndex current = RoutingGraph::INVALID_EDGE;
+    double factor = 1.0;
+    for (size_t i = 0; i + 1 < path.size(); ++i) {
+        float meters = 0.0f;
+        uint32_t deciseconds = 0;
+        RoutingGraph::EdgeIndex e = RoutingGraph::INVALID_EDGE;
+        if (!graph.segmentCost(path[i], path[i + 1], metric, profile, meters, deciseconds, &e)) continue;
+        if ((timed || overrides) && e != current) {
+            current = e;
+            factor = timed ? traffic->factor(e, departure + total.seconds) : 1.0;
+            // as edgeFactor(): the override is a delay on top of the traffic
+            if (overrides && !std::isinf(overrides->factor(e))) factor += overrides->factor(e) - 1.0;
+        }
+        total.meters += meters;
+        total.seconds += deciseconds / 10.0 * factor;
+    }
+    return total;
 }
 
 void aStar() {
     const std::string map_file = "res/data/karachi.osm.pbf";
-    loadKarachiMap(map_file);
+    std::shared_ptr<const RoutingGraph> graphPtr = RoutingGraph::fromOsm(map_file);
+    if (!graphPtr) return;
+    const RoutingGraph& graph = *graphPtr;
 
     std::cout << "Do you want to enter (1) node IDs or (2) coordinates? Enter 1 or 2: ";
     int mode = 1;
     std::cin >> mode;
 
-    int64_t start = 0, goal = 0;
+    int64_t startId = 0, goalId = 0;
+    NodeIndex start = RoutingGraph::INVALID_NODE, goal = RoutingGraph::INVALID_NODE;
 
     if (mode == 1) {
         std::cout << "Enter start node ID: ";
-        std::cin >> start;
+        std::cin >> startId;
         std::cout << "Enter goal node ID: ";
-        std::cin >> goal;
+        std::cin >> goalId;
+        start = graph.indexOf(startId);
+        goal = graph.indexOf(goalId);
     } else {
         double slat, slon, glat, glon;
         std::cout << "Enter start latitude: ";
@@ -239,17 +1436,23 @@ void aStar() {
         std::cout << "Enter goal longitude: ";
         std::cin >> glon;
 
-        start = findNearestNode(slat, slon);
-        goal  = findNearestNode(glat, glon);
+        start = graph.nearestNode(slat, slon);
+        goal  = graph.nearestNode(glat, glon);
+        if (start == RoutingGraph::INVALID_NODE || goal == RoutingGraph::INVALID_NODE) {
+            std::cerr << "Routing graph is empty.\n";
+            return;
+        }
+        startId = graph.osmId(start);
+        goalId = graph.osmId(goal);
 
-        std::cout << "Nearest start node: " << start
-                  << "  (lat: " << nodes[start].lat << " lon: " << nodes[start].lon << ")\n";
-        std::cout << "Nearest goal node: " << goal
-                  << "  (lat: " << nodes[goal].lat << " lon: " << nodes[goal].lon << ")\n";
+        std::cout << "Nearest start node: " << startId
+                  << "  (lat: " << graph.lat(start) << " lon: " << graph.lon(start) << ")\n";
+        std::cout << "Nearest goal node: " << goalId
+                  << "  (lat: " << graph.lat(goal) << " lon: " << graph.lon(goal) << ")\n";
     }
 
-    if (!nodes.count(start) || !nodes.count(goal)) {
-        std::cerr << "Invalid node IDs (not found in loaded OSM nodes).\n";
+    if (start == RoutingGraph::INVALID_NODE || goal == RoutingGraph::INVALID_NODE) {
+        std::cerr << "Invalid node IDs (not found in the routing graph).\n";
         return;
     }
 
@@ -266,22 +1469,24 @@ void aStar() {
         return;
     }
 
-    double straight_distance = haversine(nodes[start].lat, nodes[start].lon,
-                                         nodes[goal].lat, nodes[goal].lon);
+    double straight_distance = haversine(graph.coord(start), graph.coord(goal));
     std::cout << "Straight-line distance: " << straight_distance / 1000.0 << " km\n";
 
     std::cout << "Calculating shortest path...\n";
     auto start_time = std::chrono::high_resolution_clock::now();
-    std::vector<int64_t> path = astar(start, goal);
+    SearchWorkspace ws;
+    std::vector<NodeIndex> path = astar(graph, start, goal, ws);
     auto end_time = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
 
-    outfile << "Start Node ID: " << start << "\n";
-    outfile << "Goal Node ID: " << goal << "\n";
+    outfile << "Start Node ID: " << startId << "\n";
+    outfile << "Goal Node ID: " << goalId << "\n";
     outfile << "Straight-line distance: " << straight_distance / 1000.0 << " km\n";
     outfile << "Calculation time: " << duration.count() << " ms\n";
     outfile << "------------------------------------\n";
 
+    std::cout << "Nodes explored: " << ws.nodesExplored << "\n";
+
     if (path.empty()) {
         outfile << "No path found between given nodes.\n";
         std::cout << "No path found between given nodes.\n";
@@ -289,15 +1494,15 @@ void aStar() {
         double total = 0;
         outfile << "Shortest path:\n";
         for (size_t i = 0; i < path.size(); ++i) {
-            outfile << path[i];
+            outfile << graph.osmId(path[i]);
             if (i + 1 < path.size()) {
-                double d = haversine(nodes[path[i]].lat, nodes[path[i]].lon,
-                                     nodes[path[i + 1]].lat, nodes[path[i + 1]].lon);
+                double d = haversine(graph.coord(path[i]), graph.coord(path[i + 1]));
                 total += d;
                 outfile << " -> ";
             }
         }
         outfile << "\nTotal distance: " << total / 1000.0 << " km\n";
+        outfile << "Travel time: " << measurePath(graph, path, Metric::Duration).seconds / 60.0 << " min\n";
         outfile << "Path length: " << path.size() << " nodes\n";
         outfile << "Efficiency ratio: " << (straight_distance > 0 ? (total / straight_distance) : 0.0) << " (ideal: ~1.0)\n";
 
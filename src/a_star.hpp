@@ -1,6 +1,245 @@
 #ifndef A_STAR
 #define A_STAR
 
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include "routing_graph.hpp"
+#include "scratch_arena.hpp"
+
+class TrafficModel;
+class WeightOverrides;
+
+// Per-thread scratch space for searches over one RoutingGraph. Arrays grow to
+// the largest state count searched so far; each search bumps epoch instead of
+// clearing them, so a reused workspace costs nothing per query beyond the
+// states touched.
+// States are core node indices, or RoutingGraph::TurnStates for turn-aware
+// searches, plus a few per query for endpoints inside compressed edges.
+struct SearchWorkspace {
+    struct QueueItem {
+        double key;
+        double g;
+        uint32_t state;
+    };
+
+    std::vector<double> gScore;
+    std::vector<uint32_t> parent;
+    std::vector<uint32_t> stamp; // gScore/parent of s are valid iff stamp[s] == epoch
+    uint32_t epoch = 0;
+    std::vector<QueueItem> heap;
+    std::vector<std::vector<QueueItem>> buckets; // oneToAll()'s bucket queue
+    // endpoint and route-building temporaries, rewound by each astar() and
+    // distancesFrom() call so warm queries allocate only their result
+    std::unique_ptr<ScratchArena> scratch = std::make_unique<ScratchArena>();
+    size_t nodesExplored = 0;
+
+    // Starts a new search over stateCount states (growing if needed).
+    void reset(size_t stateCount);
+
+    bool touched(uint32_t s) const { return stamp[s] == epoch; }
+    void touch(uint32_t s, double g, uint32_t from) {
+        stamp[s] = epoch;
+        gScore[s] = g;
+        parent[s] = from;
+    }
+};
+
+struct SearchOptions {
+    Metric metric = Metric::Duration;
+    // Travel mode: which edges are usable and at what speed.
+    Profile profile = Profile::Car;
+    // Seconds added per U-turn and per turn across oncoming traffic (Duration only).
+    double uturnPenalty = 0.0;
+    double crossTrafficPenalty = 0.0;
+    // Pakistan drives on the left, so right turns are the ones that cross traffic.
+    bool leftHandTraffic = true;
+    // Time-of-day slowdowns for Duration searches of profiles that
+    // followsTraffic(); costs are then deciseconds after leaving at
+    // `departure` (seconds after midnight). Not owned; nullptr is free flow.
+    const TrafficModel* traffic = nullptr;
+    double departure = 0.0;
+    // Live closures and slowdowns (see WeightOverrides), typically from a
+    // WeightSnapshot held for the whole query. Not owned; nullptr is none.
+    const WeightOverrides* overrides = nullptr;
+
+    SearchOptions() = default;
+    SearchOptions(Metric m) : metric(m) {}
+};
+
+// True if searches with these options must run edge-based (turn restrictions in
+// the graph that the profile obeys, or non-zero turn penalties); otherwise the
+// cheaper node-based search is used.
+bool usesTurnSearch(const RoutingGraph& graph, const SearchOptions& options);
+
+// Cheapest path from start to goal (node indices, shape nodes included), empty
+// if unreachable. Either end may be a shape node. Only takes edges the profile
+// may use and obeys the graph's turn restrictions where the profile does.
+// Only reads graph, so threads with separate workspaces can query
+// concurrently.
+std::vector<RoutingGraph::NodeIndex> astar(const RoutingGraph& graph,
+                                           RoutingGraph::NodeIndex start,
+                                           RoutingGraph::NodeIndex goal,
+                                           SearchWorkspace& ws,
+                                           const SearchOptions& options = {});
+
+// Limits for latency-critical queries, traded against route quality.
+struct SearchBudget {
+    // Weighted A* (f = g + weight * h, weight >= 1): settles far fewer states
+    // and returns a route costing at most weight times the cheapest one.
+    double heuristicWeight = 1.0;
+    // Give up after settling this many states or after this much time; 0 is no limit.
+    size_t maxSettled = 0;
+    std::chrono::microseconds maxTime{0};
+};
+
+enum class SearchStatus : uint8_t {
+    Optimal,     // the cheapest route
+    Bounded,     // within heuristicWeight (and cost / lowerBound) of the cheapest
+    Partial,     // out of budget; the path stops at the settled node nearest the goal
+    Unreachable,
+};
+
+constexpr std::string_view statusName(SearchStatus s) {
+    switch (s) {
+        case SearchStatus::Optimal: return "optimal";
+        case SearchStatus::Bounded: return "bounded";
+        case SearchStatus::Partial: return "partial";
+        default: return "unreachable";
+    }
+}
+
+struct SearchResult {
+    std::vector<RoutingGraph::NodeIndex> path; // as astar() returns it, or the partial route
+    SearchStatus status = SearchStatus::Unreachable;
+    double cost = std::numeric_limits<double>::infinity(); // of path, meters or deciseconds
+    // No route to the goal is cheaper than this (+infinity if unreachable).
+    double lowerBound = std::numeric_limits<double>::infinity();
+};
+
+// astar() within budget. Once the goal is settled the bound comes from the
+// unweighted f = g + h of the states still queued, so it is usually much
+// tighter than heuristicWeight.
+SearchResult astar(const RoutingGraph& graph,
+                   RoutingGraph::NodeIndex start,
+                   RoutingGraph::NodeIndex goal,
+                   SearchWorkspace& ws,
+                   const SearchOptions& options,
+                   const SearchBudget& budget);
+
+struct AlternativeOptions {
+    // Alternatives wanted besides the best route.
+    size_t count = 2;
+    // Limits relative to the best route's cost: an alternative costs at most
+    // (1 + maxStretch) times as much, shares edges worth at most maxSharing of
+    // it with any route picked before, and is locally optimal over a stretch
+    // worth at least minPlateau of it around its via node.
+    double maxStretch = 0.25;
+    double maxSharing = 0.6;
+    double minPlateau = 0.2;
+};
+
+struct Route {
+    std::vector<RoutingGraph::NodeIndex> path; // as returned by astar()
+    double cost;                               // meters or deciseconds
+};
+
+// The best route from start to goal followed by up to options.count
+// meaningfully different ones, cheapest first; empty if unreachable.
+// Alternatives are via-node paths start -> v -> goal taken from one forward
+// and one backward shortest-path tree: v must lie on a plateau (a stretch both
+// trees share) and the candidates are then filtered by stretch and sharing.
+// Trees are node-based and ignore traffic (not overrides); with turn
+// restrictions, penalties or traffic the best route comes from an exact search
+// and each candidate is re-costed (and dropped if it takes a banned turn).
+// Uses both workspaces; their nodesExplored add up to the work done.
+std::vector<Route> alternativeRoutes(const RoutingGraph& graph,
+                                     RoutingGraph::NodeIndex start,
+                                     RoutingGraph::NodeIndex goal,
+                                     SearchWorkspace& forward,
+                                     SearchWorkspace& backward,
+                                     const SearchOptions& options = {},
+                                     const AlternativeOptions& alternatives = {});
+
+// One Dijkstra from source that stops once every target is settled. Results are
+// search costs (meters or deciseconds); unreachable targets get +infinity.
+std::vector<double> distancesFrom(const RoutingGraph& graph,
+                                  RoutingGraph::NodeIndex source,
+                                  const std::vector<RoutingGraph::NodeIndex>& targets,
+                                  SearchWorkspace& ws,
+                                  const SearchOptions& options = {});
+
+// Cost (meters or deciseconds) from the nearest of sources to every node,
+// shape nodes included, +infinity for nodes farther than maxCost or
+// unreachable. Node-based searches settle all sources in one Dijkstra over a
+// bucket queue; turn-aware ones run one edge-based search per source.
+std::vector<double> oneToAll(const RoutingGraph& graph,
+                             const std::vector<RoutingGraph::NodeIndex>& sources,
+                             SearchWorkspace& ws,
+                             const SearchOptions& options = {},
+                             double maxCost = std::numeric_limits<double>::infinity());
+
+// A route that is kept up to date while its goal moves (a dragged marker) or
+// edge weights change: LPA* rooted at start, with D* Lite's key offset for the
+// moving end, repairs only the part of the search tree the change affects
+// instead of searching again. update() stops when its time budget runs out and
+// carries on where it left off on the next call, so an interactive caller can
+// spend a slice of each frame on it.
+// Node-based only: when options need turns or traffic, update() runs a plain
+// A* instead, still within its budget and resumed on the next call, but
+// started over on every change. Keeps a reference to graph, which must outlive it.
+class IncrementalRoute {
+public:
+    explicit IncrementalRoute(const RoutingGraph& graph, const SearchOptions& options = {});
+    ~IncrementalRoute();
+    IncrementalRoute(const IncrementalRoute&) = delete;
+    IncrementalRoute& operator=(const IncrementalRoute&) = delete;
+
+    // A new start restarts the search; a new goal reuses it.
+    void setEndpoints(RoutingGraph::NodeIndex start, RoutingGraph::NodeIndex goal);
+    // Switches to another generation of overrides for the same graph (see
+    // SearchOptions::overrides) and repairs around the edges that changed.
+    void setOverrides(const WeightOverrides* overrides);
+
+    // Searches for at most budget; true once path() and cost() are exact for
+    // the current endpoints and weights.
+    bool update(std::chrono::microseconds budget = std::chrono::microseconds::max());
+    bool done() const;
+
+    // As astar() returns it, once done(); empty if unreachable.
+    std::vector<RoutingGraph::NodeIndex> path() const;
+    // Meters or deciseconds, +infinity if unreachable.
+    double cost() const;
+    // Nodes expanded since the endpoints or weights last changed.
+    size_t nodesExplored() const;
+
+private:
+    struct State;
+    std::unique_ptr<State> m_state;
+};
+
+struct PathLength {
+    double meters = 0.0;
+    double seconds = 0.0;
+};
+
+// Length and travel time along a path returned by astar() with the same metric
+// and profile; with traffic, the time when leaving at departure (seconds after
+// midnight), each edge slowed by its factor at the moment it is entered. Times
+// include the slowdowns of overrides.
+PathLength measurePath(const RoutingGraph& graph,
+                       const std::vector<RoutingGraph::NodeIndex>& path,
+                       Metric metric,
+                       Profile profile = Profile::Car,
+                       const TrafficModel* traffic = nullptr,
+                       double departure = 0.0,
+                       const WeightOverrides* overrides = nullptr);
+
+// Interactive console mode (reads node ids / coordinates from stdin).
 void aStar();
 
 #endif
@@ -0,0 +1,229 @@
+// Degree-2 chain compression: turns the builder's OSM segments into a graph
+// whose edges run from junction to junction, keeping the nodes in between as
+// shape points for path expansion.
+
+#include "routing_graph.hpp"
+
+#include <algorithm>
+
+namespace {
+
+using NodeIndex = RoutingGraph::NodeIndex;
+
+using Durations = std::array<uint64_t, PROFILE_COUNT>;
+
+// Compressed edge while the chains are walked; nodes are indices into the sorted id list.
+struct Chain {
+    uint32_t from;
+    uint32_t to;
+    double distance;
+    Durations durations;
+    uint8_t profiles;
+    int64_t wayId;
+    uint32_t shapeBegin; // into the walk's shape buffer
+    uint32_t shapeEnd;
+};
+
+struct WalkPoint {
+    uint32_t node;
+    double distance;
+    Durations durations;
+};
+
+uint32_t clampDuration(uint64_t deciseconds) {
+    return static_cast<uint32_t>(std::min<uint64_t>(deciseconds, UINT32_MAX));
+}
+
+} // namespace
+
+void RoutingGraph::Builder::compressChains(RoutingGraph& g, std::vector<int64_t>& edgeWays) const {
+    // every node that is part of some edge, sorted by OSM id
+    std::vector<int64_t> ids;
+    ids.reserve(m_edges.size() * 2);
+    for (const auto& e : m_edges) {
+        ids.push_back(e.from);
+        ids.push_back(e.to);
+    }
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    const size_t n = ids.size();
+    auto idOf = [&](int64_t osmId) {
+        return static_cast<uint32_t>(std::lower_bound(ids.begin(), ids.end(), osmId) - ids.begin());
+    };
+
+    // raw segments in and out of every node
+    const size_t m = m_edges.size();
+    std::vector<uint32_t> from(m), to(m);
+    std::vector<uint32_t> outOffsets(n + 1, 0), inOffsets(n + 1, 0);
+    for (size_t i = 0; i < m; ++i) {
+        from[i] = idOf(m_edges[i].from);
+        to[i] = idOf(m_edges[i].to);
+        ++outOffsets[from[i] + 1];
+        ++inOffsets[to[i] + 1];
+    }
+    for (size_t i = 0; i < n; ++i) {
+        outOffsets[i + 1] += outOffsets[i];
+        inOffsets[i + 1] += inOffsets[i];
+    }
+    std::vector<uint32_t> outEdges(m), inEdges(m);
+    {
+        std::vector<uint32_t> outCursor(outOffsets.begin(), outOffsets.end() - 1);
+        std::vector<uint32_t> inCursor(inOffsets.begin(), inOffsets.end() - 1);
+        for (uint32_t i = 0; i < m; ++i) {
+            outEdges[outCursor[from[i]]++] = i;
+            inEdges[inCursor[to[i]]++] = i;
+        }
+    }
+
+    // restrictions name their via node; it has to stay a junction
+    std::vector<bool> pinned(n, false);
+    for (const auto& r : m_restrictions) {
+        if (r.viaNode == 0) continue;
+        auto it = std::lower_bound(ids.begin(), ids.end(), r.viaNode);
+        if (it != ids.end() && *it == r.viaNode) pinned[it - ids.begin()] = true;
+    }
+
+    // A node can be collapsed if it joins exactly two other nodes through one
+    // way and every segment entering it continues to the other neighbour with
+    // the same profiles: a -> v -> b for one-way chains, or both directions for
+    // two-way ones.
+    auto collapsible = [&](uint32_t v) {
+        const uint32_t outCount = outOffsets[v + 1] - outOffsets[v];
+        const uint32_t inCount = inOffsets[v + 1] - inOffsets[v];
+        if (pinned[v] || outCount == 0 || outCount > 2 || outCount != inCount) return false;
+
+        const int64_t way = m_edges[outEdges[outOffsets[v]]].wayId;
+        const uint32_t NONE = UINT32_MAX;
+        uint32_t a = NONE, b = NONE;
+        auto neighbour = [&](uint32_t segment, uint32_t other) {
+            if (m_edges[segment].wayId != way || other == v) return false;
+            if (a == NONE || a == other) a = other;
+            else if (b == NONE || b == other) b = other;
+            else return false;
+            return true;
+        };
+        for (uint32_t k = outOffsets[v]; k < outOffsets[v + 1]; ++k) {
+            if (!neighbour(outEdges[k], to[outEdges[k]])) return false;
+        }
+        for (uint32_t k = inOffsets[v]; k < inOffsets[v + 1]; ++k) {
+            if (!neighbour(inEdges[k], from[inEdges[k]])) return false;
+        }
+        if (b == NONE) return false;
+
+        // no two segments to (or from) the same neighbour
+        if (outCount == 2 && to[outEdges[outOffsets[v]]] == to[outEdges[outOffsets[v] + 1]]) return false;
+        if (inCount == 2 && from[inEdges[inOffsets[v]]] == from[inEdges[inOffsets[v] + 1]]) return false;
+
+        for (uint32_t k = inOffsets[v]; k < inOffsets[v + 1]; ++k) {
+            const uint32_t in = inEdges[k];
+            uint32_t out = outEdges[outOffsets[v]];
+            if (to[out] == from[in]) out = outEdges[outOffsets[v] + 1];
+            if (m_edges[out].profiles != m_edges[in].profiles) return false;
+        }
+        return true;
+    };
+    std::vector<bool> shape(n);
+    for (uint32_t v = 0; v < n; ++v) shape[v] = collapsible(v);
+
+    // walk every chain from its core tail; a shape node no walk reaches sits on
+    // a ring without junctions, so one of its nodes is made core
+    std::vector<Chain> chains;
+    std::vector<WalkPoint> walked;
+    std::vector<bool> reached(n, false);
+    auto walkFrom = [&](uint32_t u) {
+        for (uint32_t k = outOffsets[u]; k < outOffsets[u + 1]; ++k) {
+            uint32_t e = outEdges[k];
+            Chain c{u, 0, 0.0, {}, m_edges[e].profiles, m_edges[e].wayId, static_cast<uint32_t>(walked.size()), 0};
+            uint32_t prev = u;
+            for (;;) {
+                c.distance += m_edges[e].distance;
+                for (size_t p = 0; p < PROFILE_COUNT; ++p) c.durations[p] += m_edges[e].durations[p];
+                const uint32_t x = to[e];
+                if (!shape[x]) {
+                    c.to = x;
+                    break;
+                }
+                reached[x] = true;
+                walked.push_back({x, c.distance, c.durations});
+                // leave x towards the neighbour we did not come from
+                uint32_t next = outEdges[outOffsets[x]];
+                if (to[next] == prev) next = outEdges[outOffsets[x] + 1];
+                prev = x;
+                e = next;
+            }
+            c.shapeEnd = static_cast<uint32_t>(walked.size());
+            chains.push_back(c);
+        }
+    };
+    for (uint32_t u = 0; u < n; ++u) {
+        if (!shape[u]) walkFrom(u);
+    }
+    for (uint32_t u = 0; u < n; ++u) {
+        if (shape[u] && !reached[u]) {
+            shape[u] = false;
+            walkFrom(u);
+        }
+    }
+
+    // core nodes first, each group in OSM id order
+    std::vector<NodeIndex> index(n);
+    uint32_t coreCount = 0;
+    for (uint32_t u = 0; u < n; ++u) {
+        if (!shape[u]) index[u] = coreCount++;
+    }
+    uint32_t nextShape = coreCount;
+    for (uint32_t u = 0; u < n; ++u) {
+        if (shape[u]) index[u] = nextShape++;
+    }
+    g.m_coreCount = coreCount;
+    g.m_osmIds.resize(n);
+    g.m_coords.resize(n);
+    for (uint32_t u = 0; u < n; ++u) {
+        g.m_osmIds[index[u]] = ids[u];
+        g.m_coords[index[u]] = m_coords.at(ids[u]);
+    }
+
+    // counting sort of chains by tail; shape nodes keep empty edge ranges
+    g.m_offsets.assign(n + 1, 0);
+    for (const Chain& c : chains) ++g.m_offsets[index[c.from] + 1];
+    for (size_t i = 0; i < n; ++i) g.m_offsets[i + 1] += g.m_offsets[i];
+
+    const size_t edgeCount = chains.size();
+    std::vector<uint32_t> slotOf(edgeCount);
+    {
+        std::vector<uint32_t> cursor(g.m_offsets.begin(), g.m_offsets.end() - 1);
+        for (size_t i = 0; i < edgeCount; ++i) slotOf[i] = cursor[index[chains[i].from]]++;
+    }
+
+    g.m_edges.resize(edgeCount);
+    for (auto& durations : g.m_durations) durations.resize(edgeCount);
+    edgeWays.assign(edgeCount, 0);
+    g.m_shapeOffsets.assign(edgeCount + 1, 0);
+    for (size_t i = 0; i < edgeCount; ++i) {
+        const Chain& c = chains[i];
+        g.m_edges[slotOf[i]] = {index[c.to], static_cast<float>(c.distance), c.profiles};
+        for (size_t p = 0; p < PROFILE_COUNT; ++p) g.m_durations[p][slotOf[i]] = clampDuration(c.durations[p]);
+        edgeWays[slotOf[i]] = c.wayId;
+        g.m_shapeOffsets[slotOf[i] + 1] = c.shapeEnd - c.shapeBegin;
+    }
+    for (size_t e = 0; e < edgeCount; ++e) g.m_shapeOffsets[e + 1] += g.m_shapeOffsets[e];
+
+    g.m_shapePoints.resize(walked.size());
+    g.m_shapeRefs.assign((n - coreCount) * 2, {INVALID_EDGE, 0});
+    for (size_t i = 0; i < edgeCount; ++i) {
+        const Chain& c = chains[i];
+        const EdgeIndex e = slotOf[i];
+        uint32_t out = g.m_shapeOffsets[e];
+        for (uint32_t k = c.shapeBegin; k < c.shapeEnd; ++k, ++out) {
+            const WalkPoint& p = walked[k];
+            const NodeIndex node = index[p.node];
+            ShapePoint& point = g.m_shapePoints[out];
+            point.node = node;
+            point.distance = static_cast<float>(p.distance);
+            for (size_t q = 0; q < PROFILE_COUNT; ++q) point.durations[q] = clampDuration(p.durations[q]);
+            ShapeRef* refs = &g.m_shapeRefs[(node - coreCount) * 2];
+            ShapeRef& ref = refs[0].edge == INVALID_EDGE ? refs[0] : refs[1];
+            ref = {e, k - c.shapeBegin};
+        }
+    }
+}
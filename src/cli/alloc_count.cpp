@@ -0,0 +1,26 @@
+#include "alloc_count.hpp"
+
+#include <cstdlib>
+#include <new>
+
+namespace {
+thread_local bool t_counting = false;
+thread_local uint64_t t_allocations = 0;
+} // namespace
+
+void setAllocationCounting(bool on) {
+    t_counting = on;
+}
+
+uint64_t threadAllocations() {
+    return t_allocations;
+}
+
+// In a file of their own, so callers never see malloc/free under new/delete.
+void* operator new(std::size_t size) {
+    if (t_counting) ++t_allocations;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
@@ -0,0 +1,12 @@
+#ifndef CLI_ALLOC_COUNT_HPP
+#define CLI_ALLOC_COUNT_HPP
+
+#include <cstdint>
+
+// Heap allocations (operator new) by the calling thread, counted only while
+// counting is on for it. alloc_count.cpp replaces the global operator new of
+// route_tracer_cli for this; with counting off it costs a thread-local test.
+void setAllocationCounting(bool on);
+uint64_t threadAllocations();
+
+#endif
@@ -0,0 +1,890 @@
+// Micro-benchmarks for the routing kernels. Each suite checks its fast paths
+// against the reference implementation and reports throughput as JSON.
+
+#include "bench.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "a_star.hpp"
+#include "alloc_count.hpp"
+#include "contraction.hpp"
+#include "distance_kernels.hpp"
+#include "geo.hpp"
+#include "road_catalog.hpp"
+#include "road_search.hpp"
+#include "route_cache.hpp"
+#include "tour.hpp"
+#include "weight_overrides.hpp"
+
+namespace {
+
+double elapsedSec(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - since).count();
+}
+
+std::vector<SimdLevel> supportedLevels() {
+    std::vector<SimdLevel> levels{SimdLevel::Scalar};
+    if (detectedSimdLevel() >= SimdLevel::SSE2) levels.push_back(SimdLevel::SSE2);
+    if (detectedSimdLevel() >= SimdLevel::AVX2) levels.push_back(SimdLevel::AVX2);
+    return levels;
+}
+
+// Batch haversine and chord nearest-point scans at every supported SIMD level,
+// on random points around Karachi (mostly street-length pairs, some long ones).
+int benchDistance(size_t count) {
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> lat(24.75, 25.10), lon(66.90, 67.35);
+    std::uniform_real_distribution<double> nearby(-0.002, 0.002), far(-15.0, 15.0);
+
+    std::vector<FixedCoord> a(count), b(count);
+    for (size_t i = 0; i < count; ++i) {
+        double la = lat(rng), lo = lon(rng);
+        a[i] = toFixedCoord(la, lo);
+        bool longPair = i % 16 == 0;
+        b[i] = toFixedCoord(la + (longPair ? far(rng) : nearby(rng)), lo + (longPair ? far(rng) : nearby(rng)));
+    }
+
+    std::vector<double> reference(count);
+    for (size_t i = 0; i < count; ++i) reference[i] = haversine(a[i], b[i]);
+
+    // the A* heuristic must never exceed the true distance
+    std::vector<float> ux(count), uy(count), uz(count), vx(count), vy(count), vz(count);
+    projectToUnitSphere(a.data(), count, ux.data(), uy.data(), uz.data());
+    projectToUnitSphere(b.data(), count, vx.data(), vy.data(), vz.data());
+    size_t boundViolations = 0;
+    double boundSlack = 0.0;
+    for (size_t i = 0; i < count; ++i) {
+        double bound = chordLowerBound(ux[i] - vx[i], uy[i] - vy[i], uz[i] - vz[i]);
+        if (bound > reference[i]) ++boundViolations;
+        boundSlack = std::max(boundSlack, reference[i] - bound);
+    }
+
+    const size_t queries = std::min<size_t>(200, count);
+    const SimdLevel original = activeSimdLevel();
+    std::vector<size_t> scalarNearest;
+    std::vector<double> out(count);
+
+    std::cout << std::setprecision(6) << "{\"suite\":\"distance\",\"pairs\":" << count
+              << ",\"detected\":\"" << simdLevelName(detectedSimdLevel()) << "\""
+              << ",\"bound_violations\":" << boundViolations << ",\"bound_max_slack_m\":" << boundSlack
+              << ",\"levels\":[";
+
+    bool first = true;
+    for (SimdLevel level : supportedLevels()) {
+        setSimdLevel(level);
+
+        const int rounds = 5;
+        auto t0 = std::chrono::steady_clock::now();
+        for (int r = 0; r < rounds; ++r) haversineBatch(a.data(), b.data(), count, out.data());
+        double haversineSec = elapsedSec(t0);
+
+        double maxAbs = 0.0, maxRel = 0.0;
+        for (size_t i = 0; i < count; ++i) {
+            double err = std::fabs(out[i] - reference[i]);
+            maxAbs = std::max(maxAbs, err);
+            if (reference[i] > 1.0) maxRel = std::max(maxRel, err / reference[i]);
+        }
+
+        std::vector<size_t> nearest(queries);
+        t0 = std::chrono::steady_clock::now();
+        for (size_t q = 0; q < queries; ++q) {
+            nearest[q] = nearestByChord(ux.data(), uy.data(), uz.data(), count, vx[q], vy[q], vz[q]);
+        }
+        double nearestSec = elapsedSec(t0);
+
+        size_t nearestMismatch = 0;
+        if (level == SimdLevel::Scalar) scalarNearest = nearest;
+        for (size_t q = 0; q < queries; ++q) {
+            // an index that differs is only wrong if it is measurably farther
+            double got = haversine(a[nearest[q]], b[q]);
+            double want = haversine(a[scalarNearest[q]], b[q]);
+            if (got > want + 1.0) ++nearestMismatch;
+        }
+
+        std::cout << (first ? "" : ",") << "{\"level\":\"" << simdLevelName(level) << "\""
+                  << ",\"haversine_mpairs_per_s\":" << rounds * count / haversineSec / 1e6
+                  << ",\"max_abs_err_m\":" << maxAbs << ",\"max_rel_err\":" << maxRel
+                  << ",\"nearest_mpoints_per_s\":" << queries * count / nearestSec / 1e6
+                  << ",\"nearest_mismatches\":" << nearestMismatch << "}";
+        first = false;
+    }
+    std::cout << "]}\n";
+
+    setSimdLevel(original);
+    return boundViolations == 0 ? 0 : 1;
+}
+
+// Search-as-you-type over synthetic road names: every query is typed one
+// keystroke at a time through a Session, either correctly or with one
+// character replaced. Reports per-keystroke latency and how often the intended
+// road comes back in the first page of results.
+int benchSearch(size_t count) {
+    static const char* const stems[] = {
+        "Shahrah-e-Faisal", "Jinnah", "Tipu Sultan", "Karsaz", "Rashid Minhas", "University",
+        "Korangi", "Sharea Quaideen", "Abdullah Haroon", "Khayaban-e-Ittehad", "M.A. Jinnah",
+        "Sir Shah Suleman", "Allama Iqbal", "Nishtar", "Lyari Expressway", "Shaheed-e-Millat"};
+    static const char* const kinds[] = {"Road", "Street", "Avenue", "Boulevard", "Lane"};
+    static const HighwayClass classes[] = {HighwayClass::Primary, HighwayClass::Secondary, HighwayClass::Tertiary};
+
+    std::mt19937 rng(42);
+    RoadCatalog roads;
+    std::vector<std::string> names;
+    for (size_t i = 0; i < count; ++i) {
+        std::string name = std::string(stems[rng() % std::size(stems)]) + " " + kinds[rng() % std::size(kinds)] +
+                           " " + std::to_string(i);
+        RoadCatalog::RoadId road = roads.road(name, classes[rng() % std::size(classes)]);
+        if (i % 4 == 0) roads.addAlias(road, "Block " + std::to_string(i) + " Link");
+        names.push_back(std::move(name));
+    }
+    roads.finalize();
+
+    auto t0 = std::chrono::steady_clock::now();
+    RoadSearchIndex index(roads);
+    double buildSec = elapsedSec(t0);
+
+    const size_t queries = std::min<size_t>(500, count);
+    const size_t limit = 20;
+    size_t keystrokes[2] = {0, 0}, found[2] = {0, 0};
+    double totalSec[2] = {0.0, 0.0}, worstSec[2] = {0.0, 0.0};
+    for (size_t q = 0; q < queries; ++q) {
+        const std::string& name = names[rng() % names.size()];
+        for (int typo = 0; typo < 2; ++typo) {
+            std::string typed = name;
+            if (typo) typed[typed.size() / 2] = typed[typed.size() / 2] == 'x' ? 'q' : 'x';
+            RoadSearchIndex::Session session(index);
+            for (size_t len = 1; len <= typed.size(); ++len) {
+                auto k0 = std::chrono::steady_clock::now();
+                session.update(std::string_view(typed).substr(0, len), limit);
+                double sec = elapsedSec(k0);
+                totalSec[typo] += sec;
+                worstSec[typo] = std::max(worstSec[typo], sec);
+                ++keystrokes[typo];
+            }
+            bool hit = false;
+            for (const auto& m : session.results()) hit = hit || roads.name(m.road) == name;
+            found[typo] += hit;
+        }
+    }
+
+    std::cout << std::setprecision(6) << "{\"suite\":\"search\",\"roads\":" << count
+              << ",\"index_build_ms\":" << buildSec * 1e3 << ",\"queries\":" << queries;
+    const char* const labels[] = {"typed", "typo"};
+    for (int typo = 0; typo < 2; ++typo) {
+        std::cout << ",\"" << labels[typo] << "\":{\"keystrokes\":" << keystrokes[typo]
+                  << ",\"mean_ms\":" << totalSec[typo] / keystrokes[typo] * 1e3
+                  << ",\"max_ms\":" << worstSec[typo] * 1e3
+                  << ",\"recall\":" << static_cast<double>(found[typo]) / queries << "}";
+    }
+    std::cout << "}\n";
+    return found[0] == queries ? 0 : 1;
+}
+
+// Value at fraction q of sorted samples, 0 if there are none.
+double percentile(const std::vector<double>& sorted, double q) {
+    if (sorted.empty()) return 0.0;
+    return sorted[std::min(sorted.size() - 1, static_cast<size_t>(q * sorted.size()))];
+}
+
+// A saved graph (.rtg) or a map to build one from.
+std::shared_ptr<const RoutingGraph> loadGraph(const std::string& input) {
+    return input.size() >= 4 && input.compare(input.size() - 4, 4, ".rtg") == 0 ? RoutingGraph::load(input)
+                                                                                : RoutingGraph::fromOsm(input);
+}
+
+using NodePair = std::pair<RoutingGraph::NodeIndex, RoutingGraph::NodeIndex>;
+
+// Random distinct nodes profile may travel between, drawn from rng; a pair
+// of INVALID_NODE if a thousand draws find none.
+NodePair randomPair(const RoutingGraph& graph, Profile profile, std::mt19937& rng) {
+    for (size_t attempt = 0; attempt < 1000; ++attempt) {
+        const RoutingGraph::NodeIndex s = rng() % graph.nodeCount();
+        const RoutingGraph::NodeIndex t = rng() % graph.nodeCount();
+        if (s != t && graph.mayReach(s, t, profile)) return {s, t};
+    }
+    return {RoutingGraph::INVALID_NODE, RoutingGraph::INVALID_NODE};
+}
+
+// count randomPair()s, fewer if the draws run out.
+std::vector<NodePair> randomPairs(const RoutingGraph& graph, Profile profile, size_t count, std::mt19937& rng) {
+    std::vector<NodePair> pairs;
+    while (pairs.size() < count) {
+        const NodePair pair = randomPair(graph, profile, rng);
+        if (pair.first == RoutingGraph::INVALID_NODE) break;
+        pairs.push_back(pair);
+    }
+    return pairs;
+}
+
+// Live weight updates under query load. Reader threads route random pairs,
+// each query on its own WeightSnapshot, first with no writer and then while
+// batches of closures and slowdowns are published every few milliseconds
+// (each batch reopens the previous one's closures). Reports update latency and
+// query latency percentiles for both phases, and counts routes that use an
+// edge closed in the snapshot they ran on.
+int benchUpdates(const std::string& input, size_t batches, size_t batchSize, size_t threads) {
+    auto graph = loadGraph(input);
+    if (!graph || graph->nodeCount() < 2 || graph->edgeCount() == 0) return 1;
+
+    std::mt19937 rng(42);
+    std::vector<NodePair> pairs(4096);
+    for (auto& p : pairs) p = {rng() % graph->nodeCount(), rng() % graph->nodeCount()};
+
+    std::atomic<bool> running{true};
+    std::atomic<size_t> violations{0};
+    auto reader = [&](size_t id, std::vector<double>& latenciesMs) {
+        SearchWorkspace ws;
+        for (size_t i = id; running.load(); i += threads) {
+            const auto& pair = pairs[i % pairs.size()];
+            auto t0 = std::chrono::steady_clock::now();
+            const WeightSnapshot snapshot;
+            SearchOptions options;
+            options.overrides = snapshot.get(*graph);
+            std::vector<RoutingGraph::NodeIndex> path = astar(*graph, pair.first, pair.second, ws, options);
+            latenciesMs.push_back(elapsedSec(t0) * 1e3);
+            if (!options.overrides) continue;
+            for (size_t k = 0; k + 1 < path.size(); ++k) {
+                const RoutingGraph::EdgeIndex e = graph->segmentEdge(path[k], path[k + 1]);
+                if (e != RoutingGraph::INVALID_EDGE && std::isinf(options.overrides->factor(e))) ++violations;
+            }
+        }
+    };
+    // runs the readers until phase() returns
+    auto measure = [&](auto phase) {
+        std::vector<std::vector<double>> perThread(threads);
+        std::vector<std::thread> pool;
+        running = true;
+        for (size_t t = 0; t < threads; ++t) pool.emplace_back(reader, t, std::ref(perThread[t]));
+        phase();
+        running = false;
+        for (auto& th : pool) th.join();
+        std::vector<double> all;
+        for (const auto& v : perThread) all.insert(all.end(), v.begin(), v.end());
+        std::sort(all.begin(), all.end());
+        return all;
+    };
+
+    const auto interval = std::chrono::milliseconds(5);
+    const std::vector<double> quiet = measure([&] { std::this_thread::sleep_for(interval * batches); });
+
+    std::vector<double> updateMs;
+    std::vector<WeightOverrides::Update> batch;
+    std::vector<RoutingGraph::EdgeIndex> closed;
+    std::uniform_real_distribution<float> slowdown(1.5f, 3.0f);
+    uint64_t generation = 0;
+    const std::vector<double> busy = measure([&] {
+        for (size_t b = 0; b < batches; ++b) {
+            batch.clear();
+            for (RoutingGraph::EdgeIndex e : closed) batch.push_back({e, 1.0f});
+            closed.clear();
+            for (size_t k = 0; k < batchSize; ++k) {
+                const RoutingGraph::EdgeIndex e = rng() % graph->edgeCount();
+                if (k % 2 == 0) closed.push_back(e);
+                batch.push_back({e, k % 2 == 0 ? WeightOverrides::CLOSED : slowdown(rng)});
+            }
+            auto t0 = std::chrono::steady_clock::now();
+            std::shared_ptr<const WeightOverrides> published = applyWeightUpdates(*graph, batch);
+            updateMs.push_back(elapsedSec(t0) * 1e3);
+            if (published) generation = published->generation();
+            std::this_thread::sleep_for(interval);
+        }
+    });
+    std::sort(updateMs.begin(), updateMs.end());
+
+    auto report = [](const char* name, const std::vector<double>& ms) {
+        std::cout << ",\"" << name << "\":{\"count\":" << ms.size() << ",\"p50_ms\":" << percentile(ms, 0.5)
+                  << ",\"p99_ms\":" << percentile(ms, 0.99) << ",\"max_ms\":" << (ms.empty() ? 0.0 : ms.back())
+                  << "}";
+    };
+    std::cout << std::setprecision(6) << "{\"suite\":\"updates\",\"edges\":" << graph->edgeCount()
+              << ",\"threads\":" << threads << ",\"batch\":" << batchSize << ",\"generation\":" << generation;
+    report("updates", updateMs);
+    report("queries_quiet", quiet);
+    report("queries_during_updates", busy);
+    std::cout << ",\"closed_edge_violations\":" << violations.load() << "}\n";
+    return violations == 0 ? 0 : 1;
+}
+
+// A goal dragged across the map: each step moves it a few dozen meters on and
+// replans, once with IncrementalRoute and once with a fresh astar(). Every
+// fourth step also closes an edge of the current route. Reports time and nodes
+// expanded for both, and counts incremental costs that differ from a Dijkstra.
+// IncrementalRoute is driven in 8 ms slices, as the viewer spends its frames;
+// max_frames is the most a step took. Car and motorbike replan with a resumed
+// plain A* on maps with turn restrictions ("lpa":false).
+int benchReplan(const std::string& input, size_t steps, Profile profile) {
+    auto graph = loadGraph(input);
+    if (!graph || graph->nodeCount() < 2 || graph->edgeCount() == 0) return 1;
+
+    std::mt19937 rng(42);
+    const NodePair pair = randomPair(*graph, profile, rng);
+    const RoutingGraph::NodeIndex start = pair.first;
+    RoutingGraph::NodeIndex goal = pair.second;
+    if (goal == RoutingGraph::INVALID_NODE) return 1;
+
+    SearchOptions options;
+    options.profile = profile;
+    IncrementalRoute incremental(*graph, options);
+    SearchWorkspace ws, check;
+    std::shared_ptr<const WeightOverrides> overrides, previous; // previous: what incremental still points at
+    std::vector<double> incrementalMs, fullMs;
+    size_t incrementalNodes = 0, fullNodes = 0, closures = 0, mismatches = 0, maxFrames = 0;
+    std::normal_distribution<double> jitter(0.0, 0.0003); // ~30 m in degrees
+    double dLat = 0.0002, dLon = 0.0002;
+
+    for (size_t step = 0; step <= steps; ++step) {
+        if (step > 0) {
+            dLat = 0.8 * dLat + jitter(rng);
+            dLon = 0.8 * dLon + jitter(rng);
+            const RoutingGraph::NodeIndex moved = graph->nearestNode(graph->lat(goal) + dLat, graph->lon(goal) + dLon, profile);
+            if (moved != RoutingGraph::INVALID_NODE && moved != start) goal = moved;
+        }
+        if (step > 0 && step % 4 == 0) {
+            // close an edge halfway along the route
+            const std::vector<RoutingGraph::NodeIndex> path = incremental.path();
+            const RoutingGraph::EdgeIndex e =
+                path.size() < 2 ? RoutingGraph::INVALID_EDGE
+                                : graph->segmentEdge(path[path.size() / 2 - 1], path[path.size() / 2]);
+            if (e != RoutingGraph::INVALID_EDGE) {
+                if (!overrides) overrides = std::make_shared<WeightOverrides>(graph->edgeCount(), 0);
+                overrides = overrides->apply({{e, WeightOverrides::CLOSED}});
+                options.overrides = overrides.get();
+                ++closures;
+            }
+        }
+
+        auto t0 = std::chrono::steady_clock::now();
+        incremental.setOverrides(options.overrides);
+        previous = overrides;
+        incremental.setEndpoints(start, goal);
+        size_t frames = 1;
+        while (!incremental.update(std::chrono::milliseconds(8))) ++frames;
+        if (step > 0) maxFrames = std::max(maxFrames, frames);
+        const double cost = incremental.cost();
+        const std::vector<RoutingGraph::NodeIndex> path = incremental.path();
+        if (step > 0) incrementalMs.push_back(elapsedSec(t0) * 1e3);
+        if (step > 0) incrementalNodes += incremental.nodesExplored();
+
+        t0 = std::chrono::steady_clock::now();
+        astar(*graph, start, goal, ws, options);
+        if (step > 0) fullMs.push_back(elapsedSec(t0) * 1e3);
+        if (step > 0) fullNodes += ws.nodesExplored;
+
+        const double exact = distancesFrom(*graph, start, {goal}, check, options)[0];
+        const bool costOk = std::isinf(exact) ? std::isinf(cost) : std::abs(cost - exact) <= 1e-6 * exact + 1e-6;
+        const bool pathOk = std::isinf(exact) ? path.empty() : !path.empty() && path.front() == start && path.back() == goal;
+        if (!costOk || !pathOk) ++mismatches;
+    }
+    std::sort(incrementalMs.begin(), incrementalMs.end());
+    std::sort(fullMs.begin(), fullMs.end());
+
+    auto report = [&](const char* name, const std::vector<double>& ms, size_t nodes) {
+        std::cout << ",\"" << name << "\":{\"p50_ms\":" << percentile(ms, 0.5) << ",\"p99_ms\":" << percentile(ms, 0.99)
+                  << ",\"mean_nodes\":" << nodes / std::max<size_t>(1, steps) << "}";
+    };
+    std::cout << std::setprecision(6) << "{\"suite\":\"replan\",\"edges\":" << graph->edgeCount()
+              << ",\"profile\":\"" << profileName(profile) << "\",\"lpa\":"
+              << (usesTurnSearch(*graph, options) ? "false" : "true") << ",\"steps\":" << steps
+              << ",\"closures\":" << closures << ",\"max_frames\":" << maxFrames;
+    report("incremental", incrementalMs, incrementalNodes);
+    report("from_scratch", fullMs, fullNodes);
+    std::cout << ",\"mismatches\":" << mismatches << "}\n";
+    return mismatches == 0 ? 0 : 1;
+}
+
+// Weighted A* and settle budgets on random pairs, against exact astar(). For
+// each setting: query latency, states settled, the worst cost ratio to the
+// optimum and the mean reported bound (cost / lowerBound). Counts violations:
+// routes dearer than weight times the optimum, or lower bounds above it.
+int benchBounded(const std::string& input, size_t count, Profile profile) {
+    auto graph = loadGraph(input);
+    if (!graph || graph->nodeCount() < 2 || graph->edgeCount() == 0) return 1;
+
+    std::mt19937 rng(42);
+    const std::vector<NodePair> pairs = randomPairs(*graph, profile, count, rng);
+
+    SearchOptions options;
+    options.profile = profile;
+    SearchWorkspace ws;
+    std::vector<double> optimal;
+    for (const auto& pair : pairs) optimal.push_back(astar(*graph, pair.first, pair.second, ws, options, {}).cost);
+
+    struct Setting {
+        const char* name;
+        SearchBudget budget;
+    };
+    std::vector<Setting> settings{{"exact", {}}, {"weight_1.2", {}}, {"weight_1.5", {}}, {"weight_2", {}},
+                                  {"settled_2000", {}}, {"weight_1.5_settled_2000", {}}};
+    settings[1].budget.heuristicWeight = 1.2;
+    settings[2].budget.heuristicWeight = 1.5;
+    settings[3].budget.heuristicWeight = 2.0;
+    settings[4].budget.maxSettled = 2000;
+    settings[5].budget.heuristicWeight = 1.5;
+    settings[5].budget.maxSettled = 2000;
+
+    size_t violations = 0;
+    std::cout << std::setprecision(6) << "{\"suite\":\"bounded\",\"edges\":" << graph->edgeCount()
+              << ",\"profile\":\"" << profileName(profile) << "\",\"queries\":" << pairs.size();
+    for (const Setting& setting : settings) {
+        std::vector<double> ms;
+        size_t settled = 0, partial = 0;
+        double worstRatio = 1.0, boundSum = 0.0;
+        for (size_t i = 0; i < pairs.size(); ++i) {
+            auto t0 = std::chrono::steady_clock::now();
+            const SearchResult r = astar(*graph, pairs[i].first, pairs[i].second, ws, options, setting.budget);
+            ms.push_back(elapsedSec(t0) * 1e3);
+            settled += ws.nodesExplored;
+            if (r.lowerBound > optimal[i] * (1.0 + 1e-9) + 1e-6) ++violations;
+            if (r.status == SearchStatus::Partial) {
+                ++partial;
+                continue;
+            }
+            const double ratio = optimal[i] > 0.0 ? r.cost / optimal[i] : 1.0;
+            if (ratio > setting.budget.heuristicWeight * (1.0 + 1e-9)) ++violations;
+            worstRatio = std::max(worstRatio, ratio);
+            boundSum += r.lowerBound > 0.0 ? r.cost / r.lowerBound : 1.0;
+        }
+        std::sort(ms.begin(), ms.end());
+        const size_t complete = pairs.size() - partial;
+        std::cout << ",\"" << setting.name << "\":{\"p50_ms\":" << percentile(ms, 0.5)
+                  << ",\"p99_ms\":" << percentile(ms, 0.99) << ",\"mean_settled\":" << settled / std::max<size_t>(1, pairs.size())
+                  << ",\"partial\":" << partial << ",\"worst_ratio\":" << worstRatio
+                  << ",\"mean_bound\":" << (complete ? boundSum / complete : 0.0) << "}";
+    }
+    std::cout << ",\"violations\":" << violations << "}\n";
+    return violations == 0 ? 0 : 1;
+}
+
+// RouteCache under a skewed query stream on reader threads: most queries go
+// from a few depots to popular destinations (Zipf-distributed), the rest
+// between random nodes, while a slowdown is published every updateEvery
+// queries so earlier entries go stale. Reports the hit rate, hit and miss
+// latency and cache bytes per stored path node, and checks every tenth hit
+// against a fresh search on the same snapshot.
+int benchCache(const std::string& input, size_t count, size_t threads, size_t capacityMb, Profile profile) {
+    auto graph = loadGraph(input);
+    if (!graph || graph->nodeCount() < 2 || graph->edgeCount() == 0) return 1;
+
+    std::mt19937 rng(42);
+    std::vector<RoutingGraph::NodeIndex> depots;
+    for (size_t d = 0; d < 4; ++d) depots.push_back(randomPair(*graph, profile, rng).first);
+    std::vector<NodePair> hot;
+    std::vector<double> weights;
+    for (size_t i = 0; i < 1000; ++i) {
+        const RoutingGraph::NodeIndex depot = depots[i % depots.size()];
+        const RoutingGraph::NodeIndex t = rng() % graph->nodeCount();
+        if (depot == RoutingGraph::INVALID_NODE || t == depot || !graph->mayReach(depot, t, profile)) continue;
+        hot.push_back({depot, t});
+        weights.push_back(1.0 / double(hot.size()));
+    }
+    if (hot.empty()) return 1;
+    std::discrete_distribution<size_t> zipf(weights.begin(), weights.end());
+
+    RouteCache cache(capacityMb << 20);
+    const size_t updateEvery = std::max<size_t>(1, count / 4);
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> mismatches{0};
+    std::vector<std::vector<double>> hitMs(threads), missMs(threads);
+    std::vector<std::thread> readers;
+    auto t0 = std::chrono::steady_clock::now();
+    for (size_t t = 0; t < threads; ++t) {
+        readers.emplace_back([&, t] {
+            std::mt19937 local(1000 + static_cast<uint32_t>(t));
+            std::uniform_real_distribution<double> coin(0.0, 1.0);
+            SearchWorkspace ws;
+            std::vector<RoutingGraph::NodeIndex> path;
+            for (size_t i = next++; i < count; i = next++) {
+                if (i > 0 && i % updateEvery == 0) {
+                    applyWeightUpdates(*graph, {{static_cast<RoutingGraph::EdgeIndex>(local() % graph->edgeCount()), 1.5f}});
+                }
+                const auto pair = coin(local) < 0.8 ? hot[zipf(local)] : randomPair(*graph, profile, local);
+                if (pair.first == RoutingGraph::INVALID_NODE) continue;
+
+                const WeightSnapshot snapshot;
+                SearchOptions options;
+                options.profile = profile;
+                options.overrides = snapshot.get(*graph);
+                RouteCache::Key key;
+                RouteCache::makeKey(pair.first, pair.second, options, key);
+                auto q0 = std::chrono::steady_clock::now();
+                if (cache.lookup(key, path)) {
+                    hitMs[t].push_back(elapsedSec(q0) * 1e3);
+                    if (i % 10 == 0 && path != astar(*graph, pair.first, pair.second, ws, options)) ++mismatches;
+                } else {
+                    path = astar(*graph, pair.first, pair.second, ws, options);
+                    cache.insert(key, path);
+                    missMs[t].push_back(elapsedSec(q0) * 1e3);
+                }
+            }
+        });
+    }
+    for (auto& r : readers) r.join();
+    const double seconds = elapsedSec(t0);
+
+    std::vector<double> hits, misses;
+    for (size_t t = 0; t < threads; ++t) {
+        hits.insert(hits.end(), hitMs[t].begin(), hitMs[t].end());
+        misses.insert(misses.end(), missMs[t].begin(), missMs[t].end());
+    }
+    std::sort(hits.begin(), hits.end());
+    std::sort(misses.begin(), misses.end());
+    const RouteCache::Stats stats = cache.stats();
+    std::cout << std::setprecision(6) << "{\"suite\":\"cache\",\"edges\":" << graph->edgeCount()
+              << ",\"profile\":\"" << profileName(profile) << "\",\"queries\":" << count
+              << ",\"threads\":" << threads << ",\"qps\":" << count / seconds << ",\"hit_rate\":" << stats.hitRate()
+              << ",\"hit_p50_ms\":" << percentile(hits, 0.5) << ",\"hit_p99_ms\":" << percentile(hits, 0.99)
+              << ",\"miss_p50_ms\":" << percentile(misses, 0.5) << ",\"miss_p99_ms\":" << percentile(misses, 0.99)
+              << ",\"entries\":" << stats.entries << ",\"evictions\":" << stats.evictions
+              << ",\"bytes_per_node\":" << (stats.pathNodes ? double(stats.bytes) / stats.pathNodes : 0.0)
+              << ",\"mismatches\":" << mismatches << "}\n";
+    return mismatches == 0 ? 0 : 1;
+}
+
+// Heap allocations per query once workspaces are warm: random pairs are routed
+// once to warm up, then again counted, with node-based astar(), turn-based
+// astar() (a U-turn penalty forces it) and distancesFrom() to ten targets.
+// Each call returns its result in one allocation of its own; anything above
+// that is search scratch. Building or loading the graph is counted as well.
+int benchAlloc(const std::string& input, size_t count, Profile profile) {
+    struct Counting {
+        Counting() { setAllocationCounting(true); }
+        ~Counting() { setAllocationCounting(false); }
+    } counting;
+    uint64_t before = threadAllocations();
+    auto t0 = std::chrono::steady_clock::now();
+    auto graph = loadGraph(input);
+    const double ingestMs = elapsedSec(t0) * 1e3;
+    const uint64_t ingestAllocations = threadAllocations() - before;
+    if (!graph || graph->nodeCount() < 2 || graph->edgeCount() == 0) return 1;
+
+    std::mt19937 rng(42);
+    const std::vector<NodePair> pairs = randomPairs(*graph, profile, count, rng);
+    if (pairs.empty()) return 1;
+    std::vector<RoutingGraph::NodeIndex> targets;
+    for (size_t i = 0; i < 10; ++i) targets.push_back(pairs[i % pairs.size()].second);
+
+    SearchOptions nodeOptions;
+    nodeOptions.profile = profile;
+    SearchOptions turnOptions = nodeOptions;
+    turnOptions.uturnPenalty = 20.0;
+    SearchWorkspace ws;
+    struct Kind {
+        const char* name;
+        std::function<void(RoutingGraph::NodeIndex, RoutingGraph::NodeIndex)> query;
+    };
+    const std::vector<Kind> kinds{
+        {"node_search", [&](RoutingGraph::NodeIndex s, RoutingGraph::NodeIndex t) { astar(*graph, s, t, ws, nodeOptions); }},
+        {"turn_search", [&](RoutingGraph::NodeIndex s, RoutingGraph::NodeIndex t) { astar(*graph, s, t, ws, turnOptions); }},
+        {"distances_from", [&](RoutingGraph::NodeIndex s, RoutingGraph::NodeIndex) {
+             distancesFrom(*graph, s, targets, ws, nodeOptions);
+         }}};
+
+    std::cout << std::setprecision(6) << "{\"suite\":\"alloc\",\"edges\":" << graph->edgeCount()
+              << ",\"ingest_ms\":" << ingestMs << ",\"ingest_allocations\":" << ingestAllocations
+              << ",\"profile\":\"" << profileName(profile) << "\",\"queries\":" << pairs.size();
+    bool scratchFree = true;
+    for (const Kind& kind : kinds) {
+        for (const auto& pair : pairs) kind.query(pair.first, pair.second);
+        uint64_t most = 0;
+        before = threadAllocations();
+        for (const auto& pair : pairs) {
+            const uint64_t start = threadAllocations();
+            kind.query(pair.first, pair.second);
+            most = std::max(most, threadAllocations() - start);
+        }
+        const double mean = double(threadAllocations() - before) / pairs.size();
+        scratchFree = scratchFree && most <= 1;
+        std::cout << ",\"" << kind.name << "\":{\"mean_allocations\":" << mean << ",\"max_allocations\":" << most
+                  << "}";
+    }
+    std::cout << "}\n";
+    return scratchFree ? 0 : 1;
+}
+
+// Contraction hierarchy preprocessing on one thread and on `threads`: build
+// time, rounds and shortcuts for each, whether both produced the same
+// hierarchy, and CH queries checked against astar() on the same graph, with
+// their path costs recomputed segment by segment.
+int benchCh(const std::string& input, size_t count, size_t threads, Profile profile, Metric metric) {
+    auto graph = loadGraph(input);
+    if (!graph || graph->nodeCount() < 2 || graph->edgeCount() == 0) return 1;
+    SearchOptions options;
+    options.profile = profile;
+    options.metric = metric;
+    if (usesTurnSearch(*graph, options)) {
+        std::cerr << "Profile " << profileName(profile) << " obeys this graph's turn restrictions; "
+                  << "contraction hierarchies ignore them\n";
+        return 2;
+    }
+
+    std::cout << std::setprecision(6) << "{\"suite\":\"ch\",\"edges\":" << graph->edgeCount()
+              << ",\"core_nodes\":" << graph->coreNodeCount() << ",\"profile\":\"" << profileName(profile) << "\"";
+    std::shared_ptr<const ContractionHierarchy> ch;
+    uint64_t serialChecksum = 0;
+    bool identical = true;
+    for (size_t t : {size_t(1), threads}) {
+        ContractionHierarchy::BuildStats stats;
+        auto built = ContractionHierarchy::build(*graph, profile, metric, t, &stats);
+        if (!ch) serialChecksum = built->checksum();
+        else identical = identical && built->checksum() == serialChecksum;
+        ch = built;
+        std::cout << ",\"threads_" << t << "\":{\"build_s\":" << stats.seconds << ",\"rounds\":" << stats.rounds
+                  << ",\"shortcuts\":" << stats.shortcuts << ",\"witness_searches\":" << stats.witnessSearches
+                  << ",\"arcs\":" << ch->arcCount() << "}";
+    }
+
+    std::mt19937 rng(42);
+    const std::vector<NodePair> pairs = randomPairs(*graph, profile, count, rng);
+
+    SearchWorkspace ws, forward, backward;
+    std::vector<double> astarMs, chMs;
+    size_t mismatches = 0, settled = 0;
+    for (const auto& pair : pairs) {
+        auto t0 = std::chrono::steady_clock::now();
+        const SearchResult reference = astar(*graph, pair.first, pair.second, ws, options, {});
+        astarMs.push_back(elapsedSec(t0) * 1e3);
+        t0 = std::chrono::steady_clock::now();
+        const Route r = ch->route(*graph, pair.first, pair.second, forward, backward);
+        chMs.push_back(elapsedSec(t0) * 1e3);
+        settled += forward.nodesExplored + backward.nodesExplored;
+
+        double walked = r.path.empty() ? std::numeric_limits<double>::infinity() : 0.0;
+        for (size_t i = 1; i < r.path.size(); ++i) {
+            float meters;
+            uint32_t deciseconds;
+            if (!graph->segmentCost(r.path[i - 1], r.path[i], metric, profile, meters, deciseconds)) {
+                walked = -1.0;
+                break;
+            }
+            walked += metric == Metric::Distance ? meters : deciseconds;
+        }
+        const bool ends = r.path.empty() || (r.path.front() == pair.first && r.path.back() == pair.second);
+        auto close = [](double a, double b) { return a == b || std::abs(a - b) <= 1e-3 * std::max(1.0, b); };
+        if (!ends || !close(r.cost, reference.cost) || !close(walked, reference.cost)) ++mismatches;
+    }
+    std::sort(astarMs.begin(), astarMs.end());
+    std::sort(chMs.begin(), chMs.end());
+    std::cout << ",\"identical\":" << (identical ? "true" : "false") << ",\"queries\":" << pairs.size()
+              << ",\"astar_p50_ms\":" << percentile(astarMs, 0.5) << ",\"ch_p50_ms\":" << percentile(chMs, 0.5)
+              << ",\"ch_p99_ms\":" << percentile(chMs, 0.99)
+              << ",\"ch_mean_settled\":" << settled / std::max<size_t>(1, pairs.size())
+              << ",\"mismatches\":" << mismatches << "}\n";
+    return identical && mismatches == 0 ? 0 : 1;
+}
+
+// Known answers, no graph needed: cached paths come back unchanged (large
+// jumps both ways, indices next to INVALID_NODE), a one-shard cache evicts
+// and accounts as CLOCK should, and solveTour() finds the optimum of stops on
+// a line, where it is known by construction. Failed checks are named on
+// stderr.
+int benchCheck() {
+    size_t failures = 0;
+    auto check = [&](bool ok, const char* what) {
+        if (!ok) {
+            std::cerr << "check failed: " << what << "\n";
+            ++failures;
+        }
+    };
+    using Path = std::vector<RoutingGraph::NodeIndex>;
+    auto keyOf = [](RoutingGraph::NodeIndex start) {
+        RouteCache::Key key;
+        RouteCache::makeKey(start, start + 1, SearchOptions(), key);
+        return key;
+    };
+
+    // path codec, through insert() and lookup()
+    const RoutingGraph::NodeIndex top = RoutingGraph::INVALID_NODE;
+    const std::vector<Path> paths{
+        {},
+        {0},
+        {5, 4, 3, 2, 1, 0},
+        {0, top - 1, 0, top - 1},
+        {top - 1, top - 2, 1, top},
+        {1u << 31, (1u << 31) - 1, 1u << 31, 127, 128, 16383, 16384, 0},
+    };
+    RouteCache codec(1 << 20, 1);
+    for (size_t i = 0; i < paths.size(); ++i) {
+        codec.insert(keyOf(static_cast<RoutingGraph::NodeIndex>(i)), paths[i]);
+        Path back{42};
+        check(codec.lookup(keyOf(static_cast<RoutingGraph::NodeIndex>(i)), back) && back == paths[i],
+              "cached path round trip");
+    }
+
+    // CLOCK: room for three equal entries; A is looked up, so inserting D
+    // passes over it (clearing its bit) and evicts B
+    const Path path{10, 11, 12, 13};
+    RouteCache probe(1 << 20, 1);
+    probe.insert(keyOf(0), path);
+    const size_t entryBytes = probe.stats().bytes;
+    RouteCache clock(3 * entryBytes, 1);
+    for (RoutingGraph::NodeIndex k = 0; k < 3; ++k) clock.insert(keyOf(k), path);
+    Path out;
+    check(clock.lookup(keyOf(0), out), "clock: A cached");
+    clock.insert(keyOf(3), path);
+    RouteCache::Stats stats = clock.stats();
+    check(stats.insertions == 4 && stats.evictions == 1 && stats.entries == 3 && stats.bytes == 3 * entryBytes &&
+              stats.pathNodes == 3 * path.size(),
+          "clock: one eviction accounted");
+    check(!clock.lookup(keyOf(1), out), "clock: B evicted");
+    check(clock.lookup(keyOf(0), out) && clock.lookup(keyOf(2), out) && clock.lookup(keyOf(3), out),
+          "clock: A, C and D kept");
+    // A, C and D are referenced now; the hand, at C, clears all three bits
+    // and comes round to evict C
+    clock.insert(keyOf(4), path);
+    check(!clock.lookup(keyOf(2), out) && clock.lookup(keyOf(0), out), "clock: C evicted before A");
+    clock.insert(keyOf(0), Path{20, 21, 22, 23}); // replacing an entry is not an eviction
+    stats = clock.stats();
+    check(stats.insertions == 6 && stats.evictions == 2 && stats.hits == 5 && stats.misses == 2,
+          "clock: counters after replacing an entry");
+    clock.insert(keyOf(9), Path(4 * entryBytes, 1));
+    check(!clock.lookup(keyOf(9), out) && clock.stats().entries == 3, "clock: oversized path not kept");
+
+    // tours: stops on a line, 100 cost units (10 s) apart per unit
+    const std::vector<double> x{0, 7, 3, 9, 1, 5};
+    std::vector<std::vector<double>> matrix(x.size(), std::vector<double>(x.size()));
+    for (size_t a = 0; a < x.size(); ++a) {
+        for (size_t b = 0; b < x.size(); ++b) matrix[a][b] = 100.0 * std::abs(x[a] - x[b]);
+    }
+    TourOptions options;
+    options.threads = 1;
+    Tour tour = solveTour(matrix, options);
+    check(tour.reachable && tour.cost == 1800.0 && tour.order.size() == x.size(), "tour: round trip");
+    options.roundTrip = false;
+    options.fixedEnd = true;
+    tour = solveTour(matrix, options);
+    check(tour.cost == 1300.0 && tour.order == std::vector<size_t>{0, 4, 2, 1, 3, 5}, "tour: fixed end");
+    // the stop at 9 closes at 90 s and the one at 1 opens at 200 s: out to 9
+    // first (the others on the way or on the way back), waiting at 1 last
+    options.fixedEnd = false;
+    options.windows.assign(x.size(), TimeWindow());
+    options.windows[3] = {0.0, 90.0};
+    options.windows[4] = {200.0, 200.0};
+    tour = solveTour(matrix, options);
+    check(tour.cost == 1700.0 && tour.lateSeconds == 0.0 && tour.order.back() == 4 && tour.arrivals.back() == 200.0,
+          "tour: time windows");
+
+    std::cout << "{\"suite\":\"check\",\"paths\":" << paths.size() << ",\"entry_bytes\":" << entryBytes
+              << ",\"failures\":" << failures << "}\n";
+    return failures == 0 ? 0 : 1;
+}
+
+} // namespace
+
+int runBench(std::vector<std::string> args) {
+    size_t count = 1000000;
+    for (size_t i = 1; i + 1 < args.size(); i += 2) {
+        if (args[i] == "--n") count = std::max<size_t>(1, std::strtoul(args[i + 1].c_str(), nullptr, 10));
+    }
+
+    if (!args.empty() && args[0] == "distance") return benchDistance(count);
+    if (!args.empty() && args[0] == "search") return benchSearch(std::min<size_t>(count, 1000000));
+    if (!args.empty() && args[0] == "check") return benchCheck();
+    if (args.size() >= 2 && args[0] == "updates") {
+        size_t batches = 200, batchSize = 100;
+        size_t threads = std::max(2u, std::thread::hardware_concurrency()) - 1;
+        for (size_t i = 2; i + 1 < args.size(); i += 2) {
+            const size_t v = std::max<size_t>(1, std::strtoul(args[i + 1].c_str(), nullptr, 10));
+            if (args[i] == "--n") batches = v;
+            else if (args[i] == "--batch") batchSize = v;
+            else if (args[i] == "--threads") threads = v;
+        }
+        return benchUpdates(args[1], batches, batchSize, threads);
+    }
+    if (args.size() >= 2 && args[0] == "replan") {
+        size_t steps = 200;
+        Profile profile = Profile::Car;
+        for (size_t i = 2; i + 1 < args.size(); i += 2) {
+            if (args[i] == "--n") steps = std::max<size_t>(1, std::strtoul(args[i + 1].c_str(), nullptr, 10));
+            else if (args[i] == "--profile" && !parseProfile(args[i + 1], profile)) {
+                std::cerr << "Unknown profile: " << args[i + 1] << "\n";
+                return 2;
+            }
+        }
+        return benchReplan(args[1], steps, profile);
+    }
+    if (args.size() >= 2 && args[0] == "bounded") {
+        size_t queries = 500;
+        Profile profile = Profile::Car;
+        for (size_t i = 2; i + 1 < args.size(); i += 2) {
+            if (args[i] == "--n") queries = std::max<size_t>(1, std::strtoul(args[i + 1].c_str(), nullptr, 10));
+            else if (args[i] == "--profile" && !parseProfile(args[i + 1], profile)) {
+                std::cerr << "Unknown profile: " << args[i + 1] << "\n";
+                return 2;
+            }
+        }
+        return benchBounded(args[1], queries, profile);
+    }
+    if (args.size() >= 2 && args[0] == "alloc") {
+        size_t queries = 200;
+        Profile profile = Profile::Car;
+        for (size_t i = 2; i + 1 < args.size(); i += 2) {
+            if (args[i] == "--n") queries = std::max<size_t>(1, std::strtoul(args[i + 1].c_str(), nullptr, 10));
+            else if (args[i] == "--profile" && !parseProfile(args[i + 1], profile)) {
+                std::cerr << "Unknown profile: " << args[i + 1] << "\n";
+                return 2;
+            }
+        }
+        return benchAlloc(args[1], queries, profile);
+    }
+    if (args.size() >= 2 && args[0] == "cache") {
+        size_t queries = 20000, capacityMb = 64;
+        size_t threads = std::max(2u, std::thread::hardware_concurrency());
+        Profile profile = Profile::Car;
+        for (size_t i = 2; i + 1 < args.size(); i += 2) {
+            const size_t v = std::strtoul(args[i + 1].c_str(), nullptr, 10);
+            if (args[i] == "--n") queries = std::max<size_t>(1, v);
+            else if (args[i] == "--threads") threads = std::max<size_t>(1, v);
+            else if (args[i] == "--cache-mb") capacityMb = std::max<size_t>(1, v);
+            else if (args[i] == "--profile" && !parseProfile(args[i + 1], profile)) {
+                std::cerr << "Unknown profile: " << args[i + 1] << "\n";
+                return 2;
+            }
+        }
+        return benchCache(args[1], queries, threads, capacityMb, profile);
+    }
+
+    if (args.size() >= 2 && args[0] == "ch") {
+        size_t queries = 500;
+        size_t threads = std::max(2u, std::thread::hardware_concurrency());
+        Profile profile = Profile::Foot;
+        Metric metric = Metric::Duration;
+        for (size_t i = 2; i + 1 < args.size(); i += 2) {
+            const size_t v = std::strtoul(args[i + 1].c_str(), nullptr, 10);
+            if (args[i] == "--n") queries = std::max<size_t>(1, v);
+            else if (args[i] == "--threads") threads = std::max<size_t>(1, v);
+            else if (args[i] == "--metric" && !parseMetric(args[i + 1], metric)) {
+                std::cerr << "Unknown metric: " << args[i + 1] << "\n";
+                return 2;
+            } else if (args[i] == "--profile" && !parseProfile(args[i + 1], profile)) {
+                std::cerr << "Unknown profile: " << args[i + 1] << "\n";
+                return 2;
+            }
+        }
+        return benchCh(args[1], queries, threads, profile, metric);
+    }
+
+    std::cerr << "Usage: route_tracer_cli bench distance [--n <pairs>]\n"
+              << "       route_tracer_cli bench search [--n <roads>]\n"
+              << "       route_tracer_cli bench check\n"
+              << "       route_tracer_cli bench updates <map|graph.rtg> [--n <batches>] [--batch <edges>]"
+                 " [--threads N]\n"
+              << "       route_tracer_cli bench replan <map|graph.rtg> [--n <steps>] [--profile <name>]\n"
+              << "       route_tracer_cli bench bounded <map|graph.rtg> [--n <queries>] [--profile <name>]\n"
+              << "       route_tracer_cli bench cache <map|graph.rtg> [--n <queries>] [--threads N] [--cache-mb <MB>]"
+                 " [--profile <name>]\n"
+              << "       route_tracer_cli bench alloc <map|graph.rtg> [--n <queries>] [--profile <name>]\n"
+              << "       route_tracer_cli bench ch <map|graph.rtg> [--n <queries>] [--threads N] [--profile <name>]"
+                 " [--metric duration|distance]\n";
+    return 2;
+}
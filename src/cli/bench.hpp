@@ -0,0 +1,11 @@
+#ifndef CLI_BENCH_HPP
+#define CLI_BENCH_HPP
+
+#include <string>
+#include <vector>
+
+// "route_tracer_cli bench <suite> ..." - micro-benchmarks that print JSON.
+// Returns the process exit code.
+int runBench(std::vector<std::string> args);
+
+#endif
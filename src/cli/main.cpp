@@ -0,0 +1,759 @@
+// Headless entry point: routing without GLFW/OpenGL, JSON on stdout, logs on stderr.
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <algorithm>
+#include <limits>
+#include <thread>
+#include <csignal>
+
+#include "a_star.hpp"
+#include "bench.hpp"
+#include "contraction.hpp"
+#include "geo.hpp"
+#include "http_server.hpp"
+#include "isochrone.hpp"
+#include "route_service.hpp"
+#include "tour.hpp"
+#include "traffic.hpp"
+
+namespace {
+
+void printUsage(std::ostream& out) {
+    out << "Usage:\n"
+        << "  route_tracer_cli load <map.osm.pbf>\n"
+        << "  route_tracer_cli preprocess <map.osm.pbf> <graph.rtg> [--ch <hierarchy.rtc>] [--metric ...] [--profile ...]\n"
+        << "  route_tracer_cli query <map|graph.rtg> --nodes <start> <goal> [--metric duration|distance]\n"
+        << "        [--profile car|motorbike|bicycle|foot] [--uturn-penalty <s>] [--cross-penalty <s>]\n"
+        << "        [--alternatives <k>] [--traffic <traffic.csv|.rtt>] [--depart <hh:mm>]\n"
+        << "        [--weight <w>] [--max-settled <n>] [--max-ms <ms>]\n"
+        << "  route_tracer_cli query <map|graph.rtg> --coords <lat> <lon> <lat> <lon> [--metric ...]\n"
+        << "  route_tracer_cli matrix <map|graph.rtg> <points.csv> [--metric ...]\n"
+        << "  route_tracer_cli trip <map|graph.rtg> <stops.csv> [--open [--fixed-end]] [--service <s>]\n"
+        << "        [--restarts N] [--threads N] [--metric ...] [--profile ...] [--traffic ...]\n"
+        << "  route_tracer_cli isochrone <map|graph.rtg> --coords <lat> <lon> [<lat> <lon> ...]\n"
+        << "        [--limits 10,20,30] [--cell <m>] [--metric ...] [--profile ...] [--traffic ...]\n"
+        << "  route_tracer_cli traffic <map|graph.rtg> <traffic.csv> <traffic.rtt>\n"
+        << "  route_tracer_cli serve <map|graph.rtg> [--host 127.0.0.1] [--port 5000] [--threads N]\n"
+        << "        [--traffic <traffic.csv|.rtt>] [--cache-mb <MB>] [--trip-threads N] [--ch <hierarchy.rtc>]\n"
+        << "  route_tracer_cli bench distance [--n <pairs>]\n"
+        << "  route_tracer_cli bench search [--n <roads>]\n"
+        << "  route_tracer_cli bench check\n"
+        << "  route_tracer_cli bench updates <map|graph.rtg> [--n <batches>] [--batch <edges>] [--threads N]\n"
+        << "  route_tracer_cli bench replan <map|graph.rtg> [--n <steps>] [--profile <name>]\n"
+        << "  route_tracer_cli bench bounded <map|graph.rtg> [--n <queries>] [--profile <name>]\n"
+        << "  route_tracer_cli bench cache <map|graph.rtg> [--n <queries>] [--threads N] [--cache-mb <MB>]\n"
+        << "        [--profile <name>]\n"
+        << "  route_tracer_cli bench alloc <map|graph.rtg> [--n <queries>] [--profile <name>]\n"
+        << "  route_tracer_cli bench ch <map|graph.rtg> [--n <queries>] [--threads N] [--profile <name>]\n"
+        << "        [--metric duration|distance]\n"
+        << "\n"
+        << "Files ending in .rtg are graph dumps written by 'preprocess'; anything else is read as OSM.\n"
+        << "points.csv holds one 'lat,lon' pair per line; stops.csv may add 'open,close' minutes after\n"
+        << "departure to each. Trips start at the first stop and end there unless --open (at the last\n"
+        << "stop with --fixed-end).\n"
+        << "Isochrone limits are minutes (duration) or meters (distance); several sources act as one.\n"
+        << "--traffic applies time-of-day congestion (see traffic.hpp) from --depart, by default now;\n"
+        << "'traffic' converts the text format to a binary .rtt for the graph it was read against.\n"
+        << "'preprocess --ch' also writes a contraction hierarchy for one metric and profile (default\n"
+        << "duration, car); 'serve --ch' answers plain /route queries of that metric and profile from it.\n"
+        << "Hierarchies ignore turn restrictions, so only bicycle and foot always qualify; both commands\n"
+        << "refuse car or motorbike on a map with restrictions for that vehicle.\n"
+        << "--weight runs weighted A* (routes within w times the best); --max-settled and --max-ms cap the\n"
+        << "search and return the partial route towards the goal once they run out.\n";
+}
+
+bool endsWith(const std::string& s, const std::string& suffix) {
+    return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+using NodeIndex = RoutingGraph::NodeIndex;
+
+// Removes "--name value" from args if present. Returns false if the flag has no value.
+bool takeOption(std::vector<std::string>& args, const std::string& name, std::string& value) {
+    for (size_t i = 0; i < args.size(); ++i) {
+        if (args[i] != name) continue;
+        if (i + 1 >= args.size()) return false;
+        value = args[i + 1];
+        args.erase(args.begin() + i, args.begin() + i + 2);
+        return true;
+    }
+    return true;
+}
+
+bool takePenalty(std::vector<std::string>& args, const std::string& name, double& seconds) {
+    std::string value;
+    if (!takeOption(args, name, value)) return false;
+    if (value.empty()) return true;
+    char* end = nullptr;
+    seconds = std::strtod(value.c_str(), &end);
+    if (*end != '\0' || seconds < 0.0) {
+        std::cerr << "Bad " << name << ": " << value << "\n";
+        return false;
+    }
+    return true;
+}
+
+// --weight, --max-settled and --max-ms; true if any was given.
+bool takeBudget(std::vector<std::string>& args, SearchBudget& budget, bool& given) {
+    std::string weight, settled, ms;
+    if (!takeOption(args, "--weight", weight) || !takeOption(args, "--max-settled", settled) ||
+        !takeOption(args, "--max-ms", ms)) {
+        return false;
+    }
+    given = !weight.empty() || !settled.empty() || !ms.empty();
+    char* end = nullptr;
+    if (!weight.empty()) {
+        budget.heuristicWeight = std::strtod(weight.c_str(), &end);
+        if (*end != '\0' || !(budget.heuristicWeight >= 1.0) || !std::isfinite(budget.heuristicWeight)) {
+            std::cerr << "Bad --weight (expected a number >= 1): " << weight << "\n";
+            return false;
+        }
+    }
+    if (!settled.empty()) {
+        budget.maxSettled = std::strtoull(settled.c_str(), &end, 10);
+        if (*end != '\0' || budget.maxSettled == 0) {
+            std::cerr << "Bad --max-settled: " << settled << "\n";
+            return false;
+        }
+    }
+    if (!ms.empty()) {
+        const double value = std::strtod(ms.c_str(), &end);
+        if (*end != '\0' || !(value > 0.0) || value > 3.6e6) {
+            std::cerr << "Bad --max-ms: " << ms << "\n";
+            return false;
+        }
+        budget.maxTime = std::chrono::microseconds(static_cast<int64_t>(value * 1000.0));
+    }
+    return true;
+}
+
+// --metric, --profile, --uturn-penalty and --cross-penalty (seconds).
+bool takeSearchOptions(std::vector<std::string>& args, SearchOptions& options) {
+    std::string name;
+    if (!takeOption(args, "--metric", name)) return false;
+    if (!name.empty() && !parseMetric(name, options.metric)) {
+        std::cerr << "Unknown metric: " << name << "\n";
+        return false;
+    }
+    name.clear();
+    if (!takeOption(args, "--profile", name)) return false;
+    if (!name.empty() && !parseProfile(name, options.profile)) {
+        std::cerr << "Unknown profile: " << name << "\n";
+        return false;
+    }
+    return takePenalty(args, "--uturn-penalty", options.uturnPenalty) &&
+           takePenalty(args, "--cross-penalty", options.crossTrafficPenalty);
+}
+
+std::shared_ptr<const RoutingGraph> loadInput(const std::string& path) {
+    if (endsWith(path, ".rtg")) return RoutingGraph::load(path);
+    return RoutingGraph::fromOsm(path);
+}
+
+std::shared_ptr<const TrafficModel> loadTraffic(const RoutingGraph& graph, const std::string& path) {
+    if (endsWith(path, ".rtt")) return TrafficModel::load(graph, path);
+    return TrafficModel::fromCsv(graph, path);
+}
+
+// --traffic and --depart; the model can only be read once the graph is.
+struct TrafficArgs {
+    std::string file;
+    uint32_t depart = 0;
+    std::shared_ptr<const TrafficModel> model;
+};
+
+bool takeTraffic(std::vector<std::string>& args, TrafficArgs& traffic) {
+    std::string depart;
+    if (!takeOption(args, "--traffic", traffic.file) || !takeOption(args, "--depart", depart)) return false;
+    if (depart.empty()) {
+        traffic.depart = localTimeOfDay();
+    } else if (!parseTimeOfDay(depart, traffic.depart)) {
+        std::cerr << "Bad --depart (expected hh:mm): " << depart << "\n";
+        return false;
+    }
+    return true;
+}
+
+// Loads the model, if any, and points options at it.
+bool applyTraffic(const RoutingGraph& graph, TrafficArgs& traffic, SearchOptions& options) {
+    if (traffic.file.empty()) return true;
+    traffic.model = loadTraffic(graph, traffic.file);
+    if (!traffic.model) return false;
+    options.traffic = traffic.model.get();
+    options.departure = traffic.depart;
+    return true;
+}
+
+double elapsedMs(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+}
+
+// JSON has no infinity, so unreachable distances are written as null.
+void writeNumber(std::ostream& out, double v) {
+    if (std::isfinite(v)) out << v;
+    else out << "null";
+}
+
+int cmdLoad(const std::vector<std::string>& args) {
+    if (args.size() != 1) { printUsage(std::cerr); return 2; }
+
+    auto t0 = std::chrono::steady_clock::now();
+    auto graph = loadInput(args[0]);
+    if (!graph) return 1;
+
+    std::cout << "{\"nodes\":" << graph->nodeCount()
+              << ",\"edges\":" << graph->edgeCount()
+              << ",\"load_ms\":" << elapsedMs(t0) << "}\n";
+    return 0;
+}
+
+int cmdPreprocess(std::vector<std::string> args) {
+    SearchOptions options;
+    std::string hierarchyFile;
+    if (!takeSearchOptions(args, options) || !takeOption(args, "--ch", hierarchyFile) || args.size() != 2) {
+        printUsage(std::cerr);
+        return 2;
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    auto graph = RoutingGraph::fromOsm(args[0]);
+    if (!graph) return 1;
+    double loadMs = elapsedMs(t0);
+    if (!hierarchyFile.empty() && usesTurnSearch(*graph, options)) {
+        std::cerr << "Profile " << profileName(options.profile) << " obeys this map's turn restrictions; "
+                  << "contraction hierarchies ignore them (use bicycle or foot)\n";
+        return 2;
+    }
+
+    auto t1 = std::chrono::steady_clock::now();
+    if (!graph->save(args[1])) return 1;
+
+    const double writeMs = elapsedMs(t1);
+
+    double hierarchyMs = 0.0;
+    if (!hierarchyFile.empty()) {
+        auto t2 = std::chrono::steady_clock::now();
+        auto hierarchy = ContractionHierarchy::build(*graph, options.profile, options.metric);
+        if (!hierarchy->save(hierarchyFile)) return 1;
+        hierarchyMs = elapsedMs(t2);
+    }
+
+    std::cout << "{\"nodes\":" << graph->nodeCount()
+              << ",\"edges\":" << graph->edgeCount()
+              << ",\"load_ms\":" << loadMs
+              << ",\"write_ms\":" << writeMs;
+    if (!hierarchyFile.empty()) std::cout << ",\"ch_ms\":" << hierarchyMs << ",\"ch\":\"" << hierarchyFile << "\"";
+    std::cout << ",\"output\":\"" << args[1] << "\"}\n";
+    return 0;
+}
+
+// "[[lat,lon],...]" for path.
+std::string coordinatesJson(const RoutingGraph& graph, const std::vector<NodeIndex>& path) {
+    std::ostringstream coords;
+    coords << std::setprecision(9) << "[";
+    for (size_t i = 0; i < path.size(); ++i) {
+        if (i > 0) coords << ",";
+        coords << "[" << graph.lat(path[i]) << "," << graph.lon(path[i]) << "]";
+    }
+    coords << "]";
+    return coords.str();
+}
+
+int cmdQuery(std::vector<std::string> args) {
+    SearchOptions options;
+    TrafficArgs traffic;
+    std::string alternativesText;
+    SearchBudget budget;
+    bool bounded = false;
+    if (!takeSearchOptions(args, options) || !takeTraffic(args, traffic) ||
+        !takeOption(args, "--alternatives", alternativesText) || !takeBudget(args, budget, bounded) ||
+        args.size() < 2) {
+        printUsage(std::cerr);
+        return 2;
+    }
+
+    int64_t startId = 0, goalId = 0;
+    bool byCoords = false;
+    double slat = 0, slon = 0, glat = 0, glon = 0;
+    AlternativeOptions alternatives;
+    alternatives.count = 0;
+    try {
+        if (!alternativesText.empty()) alternatives.count = std::stoul(alternativesText);
+        if (args[1] == "--nodes" && args.size() == 4) {
+            startId = std::stoll(args[2]);
+            goalId = std::stoll(args[3]);
+        } else if (args[1] == "--coords" && args.size() == 6) {
+            byCoords = true;
+            slat = std::stod(args[2]);
+            slon = std::stod(args[3]);
+            glat = std::stod(args[4]);
+            glon = std::stod(args[5]);
+        } else {
+            printUsage(std::cerr);
+            return 2;
+        }
+    } catch (const std::exception&) {
+        std::cerr << "Invalid numeric argument.\n";
+        return 2;
+    }
+
+    auto graph = loadInput(args[0]);
+    if (!graph || !applyTraffic(*graph, traffic, options)) return 1;
+
+    NodeIndex start, goal;
+    if (byCoords) {
+        start = graph->nearestNode(slat, slon, options.profile);
+        goal = graph->nearestNode(glat, glon, options.profile);
+    } else {
+        start = graph->indexOf(startId);
+        goal = graph->indexOf(goalId);
+    }
+
+    if (start == RoutingGraph::INVALID_NODE || goal == RoutingGraph::INVALID_NODE) {
+        std::cerr << "Invalid node IDs (not found in loaded graph).\n";
+        return 1;
+    }
+
+    SearchWorkspace ws, backward;
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<NodeIndex> path;
+    std::vector<Route> routes;
+    SearchResult result;
+    if (alternatives.count > 0) {
+        routes = alternativeRoutes(*graph, start, goal, ws, backward, options, alternatives);
+        if (!routes.empty()) path = routes[0].path;
+        ws.nodesExplored += backward.nodesExplored;
+    } else if (bounded) {
+        result = astar(*graph, start, goal, ws, options, budget);
+        path = result.path;
+    } else {
+        path = astar(*graph, start, goal, ws, options);
+    }
+    double queryMs = elapsedMs(t0);
+    std::clog << (path.empty() ? "No path found after exploring " : "Path found! Nodes explored: ")
+              << ws.nodesExplored << "\n";
+
+    PathLength length = measurePath(*graph, path, options.metric, options.profile, options.traffic, options.departure);
+
+    const double INF = std::numeric_limits<double>::infinity();
+    std::cout << std::setprecision(10)
+              << "{\"start\":" << graph->osmId(start)
+              << ",\"goal\":" << graph->osmId(goal)
+              << ",\"metric\":\"" << (options.metric == Metric::Distance ? "distance" : "duration") << "\""
+              << ",\"profile\":\"" << profileName(options.profile) << "\""
+              << ",\"found\":" << (path.empty() || result.status == SearchStatus::Partial ? "false" : "true")
+              << ",\"distance_m\":";
+    writeNumber(std::cout, path.empty() ? INF : length.meters);
+    std::cout << ",\"duration_s\":";
+    writeNumber(std::cout, path.empty() ? INF : length.seconds);
+    if (options.traffic) std::cout << ",\"depart_s\":" << traffic.depart;
+    if (bounded && alternatives.count == 0) {
+        // cost and bound in search units: meters or deciseconds
+        std::cout << ",\"status\":\"" << statusName(result.status) << "\",\"cost\":";
+        writeNumber(std::cout, result.cost);
+        std::cout << ",\"lower_bound\":";
+        writeNumber(std::cout, result.lowerBound);
+    }
+    std::cout << ",\"query_ms\":" << queryMs << ",\"explored\":" << ws.nodesExplored << ",\"nodes\":[";
+    for (size_t i = 0; i < path.size(); ++i) {
+        if (i > 0) std::cout << ",";
+        std::cout << graph->osmId(path[i]);
+    }
+    std::cout << "],\"coordinates\":" << coordinatesJson(*graph, path);
+    if (alternatives.count > 0) {
+        std::cout << ",\"alternatives\":[";
+        for (size_t i = 1; i < routes.size(); ++i) {
+            PathLength alt = measurePath(*graph, routes[i].path, options.metric, options.profile, options.traffic,
+                                         options.departure);
+            if (i > 1) std::cout << ",";
+            std::cout << "{\"distance_m\":" << alt.meters << ",\"duration_s\":" << alt.seconds
+                      << ",\"coordinates\":" << coordinatesJson(*graph, routes[i].path) << "}";
+        }
+        std::cout << "]";
+    }
+    std::cout << "}\n";
+    if (bounded && alternatives.count == 0) return result.status == SearchStatus::Partial || path.empty() ? 1 : 0;
+    return path.empty() ? 1 : 0;
+}
+
+int cmdMatrix(std::vector<std::string> args) {
+    SearchOptions options;
+    TrafficArgs traffic;
+    if (!takeSearchOptions(args, options) || !takeTraffic(args, traffic) || args.size() != 2) {
+        printUsage(std::cerr);
+        return 2;
+    }
+
+    std::ifstream in(args[1]);
+    if (!in) {
+        std::cerr << "Failed to open points file: " << args[1] << "\n";
+        return 1;
+    }
+
+    std::vector<std::pair<double, double>> points;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::replace(line.begin(), line.end(), ',', ' ');
+        std::istringstream ls(line);
+        double lat, lon;
+        if (!(ls >> lat >> lon)) {
+            std::cerr << "Bad point line: " << line << "\n";
+            return 2;
+        }
+        points.push_back({lat, lon});
+    }
+
+    auto graph = loadInput(args[0]);
+    if (!graph || !applyTraffic(*graph, traffic, options)) return 1;
+
+    std::vector<NodeIndex> snapped;
+    snapped.reserve(points.size());
+    for (const auto& p : points) snapped.push_back(graph->nearestNode(p.first, p.second, options.profile));
+
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<std::vector<double>> rows = costMatrix(*graph, snapped, options);
+    double matrixMs = elapsedMs(t0);
+
+    std::cout << std::setprecision(10) << "{\"snapped\":[";
+    for (size_t i = 0; i < snapped.size(); ++i) {
+        if (i > 0) std::cout << ",";
+        if (snapped[i] == RoutingGraph::INVALID_NODE) std::cout << "null";
+        else std::cout << graph->osmId(snapped[i]);
+    }
+    // costs are meters or deciseconds
+    const bool byTime = options.metric == Metric::Duration;
+    std::cout << "],\"matrix_ms\":" << matrixMs << (byTime ? ",\"durations_s\":[" : ",\"distances_m\":[");
+    for (size_t i = 0; i < rows.size(); ++i) {
+        if (i > 0) std::cout << ",";
+        std::cout << "[";
+        for (size_t j = 0; j < rows[i].size(); ++j) {
+            if (j > 0) std::cout << ",";
+            writeNumber(std::cout, byTime ? rows[i][j] / 10.0 : rows[i][j]);
+        }
+        std::cout << "]";
+    }
+    std::cout << "]}\n";
+    return 0;
+}
+
+// stops.csv: "lat,lon" or "lat,lon,open,close" per line, windows in minutes after departure.
+bool readStops(const std::string& path, std::vector<std::pair<double, double>>& points,
+               std::vector<TimeWindow>& windows) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << "Failed to open stops file: " << path << "\n";
+        return false;
+    }
+    std::vector<bool> hasWindow;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::replace(line.begin(), line.end(), ',', ' ');
+        std::istringstream ls(line);
+        double lat, lon;
+        TimeWindow w;
+        if (!(ls >> lat >> lon)) {
+            std::cerr << "Bad stop line: " << line << "\n";
+            return false;
+        }
+        double open, close;
+        const bool windowed = static_cast<bool>(ls >> open >> close);
+        if (windowed) {
+            if (open < 0.0 || close < open) {
+                std::cerr << "Bad time window (minutes, open <= close): " << line << "\n";
+                return false;
+            }
+            w = {open * 60.0, close * 60.0};
+        }
+        points.push_back({lat, lon});
+        windows.push_back(w);
+        hasWindow.push_back(windowed);
+    }
+    if (std::find(hasWindow.begin(), hasWindow.end(), true) == hasWindow.end()) windows.clear();
+    return true;
+}
+
+int cmdTrip(std::vector<std::string> args) {
+    SearchOptions options;
+    TrafficArgs traffic;
+    TourOptions tour;
+    std::string service, restarts, threads;
+    bool open = false;
+    for (auto it = args.begin(); it != args.end();) {
+        if (*it == "--open" || *it == "--fixed-end") {
+            (*it == "--open" ? open : tour.fixedEnd) = true;
+            it = args.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    if (!takeSearchOptions(args, options) || !takeTraffic(args, traffic) || !takeOption(args, "--service", service) ||
+        !takeOption(args, "--restarts", restarts) || !takeOption(args, "--threads", threads) || args.size() != 2) {
+        printUsage(std::cerr);
+        return 2;
+    }
+    tour.roundTrip = !open;
+    try {
+        if (!service.empty()) tour.serviceSeconds = std::stod(service);
+        if (!restarts.empty()) tour.restarts = std::stoul(restarts);
+        if (!threads.empty()) tour.threads = std::stoul(threads);
+    } catch (const std::exception&) {
+        std::cerr << "Invalid numeric argument.\n";
+        return 2;
+    }
+    if (tour.fixedEnd && tour.roundTrip) {
+        std::cerr << "--fixed-end needs --open\n";
+        return 2;
+    }
+
+    std::vector<std::pair<double, double>> points;
+    if (!readStops(args[1], points, tour.windows)) return 2;
+    if (points.empty()) {
+        std::cerr << "No stops.\n";
+        return 2;
+    }
+    if (!tour.windows.empty() && options.metric != Metric::Duration) {
+        std::cerr << "Time windows need --metric duration.\n";
+        return 2;
+    }
+
+    auto graph = loadInput(args[0]);
+    if (!graph || !applyTraffic(*graph, traffic, options)) return 1;
+
+    std::vector<NodeIndex> snapped;
+    for (const auto& p : points) {
+        snapped.push_back(graph->nearestNode(p.first, p.second, options.profile));
+        if (snapped.back() == RoutingGraph::INVALID_NODE) {
+            std::cerr << "No road near " << p.first << "," << p.second << "\n";
+            return 1;
+        }
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    const std::vector<std::vector<double>> matrix = costMatrix(*graph, snapped, options, tour.threads);
+    const double matrixMs = elapsedMs(t0);
+    t0 = std::chrono::steady_clock::now();
+    const Tour best = solveTour(matrix, tour);
+    const double solveMs = elapsedMs(t0);
+    if (!best.reachable) {
+        std::cerr << "Some stops cannot reach each other.\n";
+        return 1;
+    }
+    SearchWorkspace ws;
+    const std::vector<NodeIndex> path = tourPath(*graph, snapped, best, ws, options, tour.roundTrip);
+    PathLength length = measurePath(*graph, path, options.metric, options.profile, options.traffic, options.departure);
+
+    std::cout << std::setprecision(10) << "{\"order\":[";
+    for (size_t i = 0; i < best.order.size(); ++i) std::cout << (i > 0 ? "," : "") << best.order[i];
+    std::cout << "],\"round_trip\":" << (tour.roundTrip ? "true" : "false")
+              << ",\"distance_m\":" << length.meters << ",\"duration_s\":" << length.seconds;
+    if (options.metric == Metric::Duration) {
+        std::cout << ",\"late_s\":" << best.lateSeconds << ",\"arrivals_s\":[";
+        for (size_t i = 0; i < best.arrivals.size(); ++i) std::cout << (i > 0 ? "," : "") << best.arrivals[i];
+        std::cout << "]";
+    }
+    std::cout << ",\"matrix_ms\":" << matrixMs << ",\"solve_ms\":" << solveMs
+              << ",\"coordinates\":" << coordinatesJson(*graph, path) << "}\n";
+    return path.empty() ? 1 : 0;
+}
+
+int cmdIsochrone(std::vector<std::string> args) {
+    SearchOptions options;
+    TrafficArgs traffic;
+    std::string limitList, cellText;
+    if (!takeSearchOptions(args, options) || !takeTraffic(args, traffic) || !takeOption(args, "--limits", limitList) ||
+        !takeOption(args, "--cell", cellText) || args.size() < 4 || args[1] != "--coords" || args.size() % 2 != 0) {
+        printUsage(std::cerr);
+        return 2;
+    }
+
+    const bool byTime = options.metric == Metric::Duration;
+    std::vector<double> limits;
+    std::vector<std::pair<double, double>> points;
+    double cellMeters = 150.0;
+    try {
+        for (size_t i = 2; i + 1 < args.size(); i += 2) points.push_back({std::stod(args[i]), std::stod(args[i + 1])});
+        std::replace(limitList.begin(), limitList.end(), ',', ' ');
+        std::istringstream ls(limitList.empty() ? (byTime ? "10 20 30" : "1000 2000 3000") : limitList);
+        for (double v; ls >> v;) limits.push_back(v);
+        if (!cellText.empty()) cellMeters = std::stod(cellText);
+    } catch (const std::exception&) {
+        std::cerr << "Invalid numeric argument.\n";
+        return 2;
+    }
+    if (limits.empty() || cellMeters <= 0.0) { printUsage(std::cerr); return 2; }
+
+    auto graph = loadInput(args[0]);
+    if (!graph || !applyTraffic(*graph, traffic, options)) return 1;
+
+    std::vector<NodeIndex> sources;
+    for (const auto& p : points) sources.push_back(graph->nearestNode(p.first, p.second, options.profile));
+
+    // limits in search costs: deciseconds or meters
+    std::vector<double> costLimits;
+    for (double l : limits) costLimits.push_back(byTime ? l * 600.0 : l);
+
+    SearchWorkspace ws;
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<double> costs =
+        oneToAll(*graph, sources, ws, options, *std::max_element(costLimits.begin(), costLimits.end()));
+    double searchMs = elapsedMs(t0);
+    auto t1 = std::chrono::steady_clock::now();
+    std::vector<Isochrone> isochrones = traceIsochrones(*graph, costs, costLimits, cellMeters);
+    double traceMs = elapsedMs(t1);
+
+    std::cout << std::setprecision(9) << "{\"sources\":[";
+    for (size_t i = 0; i < sources.size(); ++i) {
+        if (i > 0) std::cout << ",";
+        if (sources[i] == RoutingGraph::INVALID_NODE) std::cout << "null";
+        else std::cout << graph->osmId(sources[i]);
+    }
+    std::cout << "],\"profile\":\"" << profileName(options.profile) << "\""
+              << ",\"search_ms\":" << searchMs << ",\"trace_ms\":" << traceMs
+              << ",\"explored\":" << ws.nodesExplored << ",\"isochrones\":[";
+    for (size_t i = 0; i < isochrones.size(); ++i) {
+        if (i > 0) std::cout << ",";
+        std::cout << (byTime ? "{\"minutes\":" : "{\"meters\":") << limits[i]
+                  << ",\"reached_nodes\":" << isochrones[i].reachedNodes << ",\"rings\":[";
+        for (size_t r = 0; r < isochrones[i].lines.size(); ++r) {
+            if (r > 0) std::cout << ",";
+            std::cout << "[";
+            const auto& line = isochrones[i].lines[r];
+            for (size_t k = 0; k < line.size(); ++k) {
+                if (k > 0) std::cout << ",";
+                std::cout << "[" << toDegrees(line[k].lat) << "," << toDegrees(line[k].lon) << "]";
+            }
+            std::cout << "]";
+        }
+        std::cout << "]}";
+    }
+    std::cout << "]}\n";
+    return 0;
+}
+
+int cmdTraffic(const std::vector<std::string>& args) {
+    if (args.size() != 3) { printUsage(std::cerr); return 2; }
+
+    auto graph = loadInput(args[0]);
+    if (!graph) return 1;
+
+    auto t0 = std::chrono::steady_clock::now();
+    auto traffic = TrafficModel::fromCsv(*graph, args[1]);
+    if (!traffic) return 1;
+    double parseMs = elapsedMs(t0);
+    if (!traffic->save(args[2])) return 1;
+
+    std::cout << "{\"profiles\":" << traffic->profileCount()
+              << ",\"adjusted_profiles\":" << traffic->adjustedProfiles()
+              << ",\"edges\":" << traffic->edgeCount()
+              << ",\"assigned_edges\":" << traffic->assignedEdges()
+              << ",\"memory_bytes\":" << traffic->memoryBytes()
+              << ",\"parse_ms\":" << parseMs
+              << ",\"output\":\"" << args[2] << "\"}\n";
+    return 0;
+}
+
+HttpServer* g_server = nullptr;
+
+void onSignal(int) {
+    if (g_server) g_server->stop();
+}
+
+int cmdServe(const std::vector<std::string>& args) {
+    if (args.empty()) { printUsage(std::cerr); return 2; }
+
+    std::string host = "127.0.0.1";
+    int port = 5000;
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    std::string trafficFile, hierarchyFile;
+    try {
+        for (size_t i = 1; i < args.size(); i += 2) {
+            if (i + 1 >= args.size()) { printUsage(std::cerr); return 2; }
+            if (args[i] == "--host") host = args[i + 1];
+            else if (args[i] == "--port") port = std::stoi(args[i + 1]);
+            else if (args[i] == "--threads") threads = std::stoul(args[i + 1]);
+            else if (args[i] == "--traffic") trafficFile = args[i + 1];
+            else if (args[i] == "--cache-mb") setRouteCacheCapacity(std::stoul(args[i + 1]) << 20);
+            else if (args[i] == "--trip-threads") setTripThreads(std::stoul(args[i + 1]));
+            else if (args[i] == "--ch") hierarchyFile = args[i + 1];
+            else { printUsage(std::cerr); return 2; }
+        }
+    } catch (const std::exception&) {
+        std::cerr << "Invalid numeric argument.\n";
+        return 2;
+    }
+    if (port <= 0 || port > 65535) {
+        std::cerr << "Port out of range.\n";
+        return 2;
+    }
+
+    auto graph = loadInput(args[0]);
+    if (!graph) return 1;
+    if (!trafficFile.empty()) {
+        auto traffic = loadTraffic(*graph, trafficFile);
+        if (!traffic) return 1;
+        publishTraffic(std::move(traffic));
+    }
+    if (!hierarchyFile.empty()) {
+        auto hierarchy = ContractionHierarchy::load(*graph, hierarchyFile);
+        if (!hierarchy) return 1;
+        SearchOptions options;
+        options.profile = hierarchy->profile();
+        options.metric = hierarchy->metric();
+        if (usesTurnSearch(*graph, options)) {
+            // answers() would turn down every query
+            std::cerr << "Profile " << profileName(options.profile) << " obeys this graph's turn restrictions; "
+                      << "contraction hierarchies ignore them (use bicycle or foot)\n";
+            return 2;
+        }
+        publishHierarchy(std::move(hierarchy));
+    }
+    publishGraph(std::move(graph));
+
+    HttpServer server(host, static_cast<uint16_t>(port), threads, handleRouteRequest);
+    g_server = &server;
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+    bool ok = server.run();
+    g_server = nullptr;
+    return ok ? 0 : 1;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        printUsage(std::cerr);
+        return 2;
+    }
+
+    std::string cmd = argv[1];
+    std::vector<std::string> args(argv + 2, argv + argc);
+
+    if (cmd == "load") return cmdLoad(args);
+    if (cmd == "preprocess") return cmdPreprocess(args);
+    if (cmd == "query") return cmdQuery(args);
+    if (cmd == "matrix") return cmdMatrix(args);
+    if (cmd == "trip") return cmdTrip(args);
+    if (cmd == "isochrone") return cmdIsochrone(args);
+    if (cmd == "traffic") return cmdTraffic(args);
+    if (cmd == "serve") return cmdServe(args);
+    if (cmd == "bench") return runBench(args);
+    if (cmd == "help" || cmd == "--help" || cmd == "-h") {
+        printUsage(std::cout);
+        return 0;
+    }
+
+    std::cerr << "Unknown command: " << cmd << "\n";
+    printUsage(std::cerr);
+    return 2;
+}
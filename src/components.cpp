@@ -0,0 +1,184 @@
+// Strongly / weakly connected components of the core graph, one set per
+// profile, used to reject queries between unconnected nodes without searching
+// and to snap to the main road network.
+
+#include "routing_graph.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+namespace {
+
+using NodeIndex = RoutingGraph::NodeIndex;
+
+constexpr uint32_t UNSET = std::numeric_limits<uint32_t>::max();
+
+uint32_t findRoot(std::vector<uint32_t>& parent, uint32_t x) {
+    while (parent[x] != x) {
+        parent[x] = parent[parent[x]];
+        x = parent[x];
+    }
+    return x;
+}
+
+} // namespace
+
+void RoutingGraph::computeComponents() {
+    const NodeIndex n = static_cast<NodeIndex>(coreNodeCount());
+
+    m_nodeProfiles.assign(nodeCount(), 0);
+    for (NodeIndex u = 0; u < n; ++u) {
+        for (const auto& e : edges(u)) {
+            m_nodeProfiles[u] |= e.profiles;
+            m_nodeProfiles[e.to] |= e.profiles;
+            for (const auto& p : shape(edgeIndex(e))) m_nodeProfiles[p.node] |= e.profiles;
+        }
+    }
+
+    for (size_t slot = 0; slot < PROFILE_COUNT; ++slot) {
+        const Profile profile = static_cast<Profile>(slot);
+        Reachability& reach = m_reach[slot];
+        std::vector<uint32_t>& components = reach.components;
+
+        // iterative Tarjan over the edges profile may use; components come out
+        // sinks first, which is the numbering we want
+        components.assign(n, UNSET);
+        reach.componentCount = 0;
+        std::vector<uint32_t> order(n, UNSET), low(n);
+        std::vector<NodeIndex> stack;
+        struct Frame {
+            NodeIndex node;
+            uint32_t nextEdge;
+        };
+        std::vector<Frame> calls;
+        uint32_t counter = 0;
+        for (NodeIndex root = 0; root < n; ++root) {
+            if (order[root] != UNSET) continue;
+            order[root] = low[root] = counter++;
+            stack.push_back(root);
+            calls.push_back({root, m_offsets[root]});
+            while (!calls.empty()) {
+                Frame& f = calls.back();
+                const NodeIndex u = f.node;
+                if (f.nextEdge < m_offsets[u + 1]) {
+                    const Edge& e = m_edges[f.nextEdge++];
+                    if (!e.allows(profile)) continue;
+                    const NodeIndex v = e.to;
+                    if (order[v] == UNSET) {
+                        order[v] = low[v] = counter++;
+                        stack.push_back(v);
+                        calls.push_back({v, m_offsets[v]});
+                    } else if (components[v] == UNSET) {
+                        // visited but unassigned means still on the stack
+                        low[u] = std::min(low[u], order[v]);
+                    }
+                    continue;
+                }
+                calls.pop_back();
+                if (!calls.empty()) low[calls.back().node] = std::min(low[calls.back().node], low[u]);
+                if (low[u] == order[u]) {
+                    NodeIndex w;
+                    do {
+                        w = stack.back();
+                        stack.pop_back();
+                        components[w] = reach.componentCount;
+                    } while (w != u);
+                    ++reach.componentCount;
+                }
+            }
+        }
+
+        // weak components: one-way exits only show up in the strong ones
+        std::vector<uint32_t> parent(n);
+        for (NodeIndex u = 0; u < n; ++u) parent[u] = u;
+        for (NodeIndex u = 0; u < n; ++u) {
+            for (const auto& e : edges(u)) {
+                if (!e.allows(profile)) continue;
+                uint32_t a = findRoot(parent, u), b = findRoot(parent, e.to);
+                if (a != b) parent[std::max(a, b)] = std::min(a, b);
+            }
+        }
+        reach.weakComponents.resize(n);
+        for (NodeIndex u = 0; u < n; ++u) reach.weakComponents[u] = findRoot(parent, u);
+
+        // main component: the strong component with the most core nodes profile
+        // can use, plus the shape nodes on edges inside it
+        std::vector<NodeIndex>& mainNodes = reach.mainNodes;
+        mainNodes.clear();
+        if (reach.componentCount > 0) {
+            std::vector<uint32_t> sizes(reach.componentCount, 0);
+            for (NodeIndex u = 0; u < n; ++u) {
+                if (m_nodeProfiles[u] & profileBit(profile)) ++sizes[components[u]];
+            }
+            const uint32_t main = static_cast<uint32_t>(std::max_element(sizes.begin(), sizes.end()) - sizes.begin());
+
+            if (sizes[main] > 0) {
+                for (NodeIndex u = 0; u < n; ++u) {
+                    if (components[u] == main) mainNodes.push_back(u);
+                }
+                for (NodeIndex u = 0; u < n; ++u) {
+                    if (components[u] != main) continue;
+                    for (const auto& e : edges(u)) {
+                        if (!e.allows(profile) || components[e.to] != main) continue;
+                        for (const auto& p : shape(edgeIndex(e))) mainNodes.push_back(p.node);
+                    }
+                }
+                std::sort(mainNodes.begin(), mainNodes.end());
+                mainNodes.erase(std::unique(mainNodes.begin(), mainNodes.end()), mainNodes.end());
+            }
+        }
+
+        reach.mainUnitX.resize(mainNodes.size());
+        reach.mainUnitY.resize(mainNodes.size());
+        reach.mainUnitZ.resize(mainNodes.size());
+        for (size_t i = 0; i < mainNodes.size(); ++i) {
+            reach.mainUnitX[i] = m_unitX[mainNodes[i]];
+            reach.mainUnitY[i] = m_unitY[mainNodes[i]];
+            reach.mainUnitZ[i] = m_unitZ[mainNodes[i]];
+        }
+    }
+}
+
+RoutingGraph::NodeIndex RoutingGraph::edgeTail(EdgeIndex e) const {
+    // the last node whose edge range starts at or before e; empty ranges share its offset
+    return static_cast<NodeIndex>(std::upper_bound(m_offsets.begin(), m_offsets.end(), e) - m_offsets.begin() - 1);
+}
+
+bool RoutingGraph::mayReach(NodeIndex s, NodeIndex t, Profile p) const {
+    if (s == t) return true;
+    const Reachability& reach = m_reach[profileSlot(p)];
+    if (reach.components.size() != coreNodeCount()) return true;
+
+    // a shape node leaves through the heads of its edges and is entered from their tails
+    ShapeRef fromRefs[2], toRefs[2];
+    const size_t fromCount = shapeRefs(s, fromRefs, p);
+    const size_t toCount = shapeRefs(t, toRefs, p);
+    if ((!isCore(s) && fromCount == 0) || (!isCore(t) && toCount == 0)) return false;
+    for (size_t i = 0; i < fromCount; ++i) {
+        for (size_t j = 0; j < toCount; ++j) {
+            if (fromRefs[i].edge == toRefs[j].edge && fromRefs[i].index < toRefs[j].index) return true;
+        }
+    }
+
+    NodeIndex from[2] = {s, s}, to[2] = {t, t};
+    size_t nFrom = 1, nTo = 1;
+    if (fromCount > 0) {
+        nFrom = fromCount;
+        for (size_t i = 0; i < fromCount; ++i) from[i] = m_edges[fromRefs[i].edge].to;
+    }
+    if (toCount > 0) {
+        nTo = toCount;
+        for (size_t j = 0; j < toCount; ++j) to[j] = edgeTail(toRefs[j].edge);
+    }
+
+    for (size_t i = 0; i < nFrom; ++i) {
+        for (size_t j = 0; j < nTo; ++j) {
+            const NodeIndex a = from[i], b = to[j];
+            if (a == b) return true;
+            if (reach.weakComponents[a] == reach.weakComponents[b] && reach.components[a] >= reach.components[b]) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
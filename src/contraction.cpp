@@ -0,0 +1,601 @@
+#include "contraction.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <thread>
+
+#include "binary_io.hpp"
+#include "weight_overrides.hpp"
+
+namespace {
+
+using NodeIndex = RoutingGraph::NodeIndex;
+using EdgeIndex = RoutingGraph::EdgeIndex;
+using Arc = ContractionHierarchy::Arc;
+
+constexpr double INF = std::numeric_limits<double>::infinity();
+// Witness searches give up after this many settled nodes and keep the
+// shortcut: an unneeded shortcut costs less than an exhaustive search.
+constexpr size_t WITNESS_SETTLE_LIMIT = 1000;
+// Priorities only estimate the shortcuts, and are recomputed for every
+// neighbour of every contracted node, so their searches stop sooner. At 20
+// they overcounted enough to skew the order (4% more shortcuts on Karachi);
+// the full 1000 counts better still but orders worse for queries.
+constexpr size_t ESTIMATE_SETTLE_LIMIT = 100;
+
+size_t threadCount(size_t requested, size_t jobs) {
+    size_t threads = requested ? requested : std::max(1u, std::thread::hardware_concurrency());
+    return std::max<size_t>(1, std::min(threads, jobs));
+}
+
+// Runs job(worker, i) for i in [0, count) on up to `threads` threads;
+// worker < threadCount(threads, count) names the thread.
+template <typename Job>
+void parallelFor(size_t count, size_t threads, Job job) {
+    threads = threadCount(threads, count);
+    if (threads == 1) {
+        for (size_t i = 0; i < count; ++i) job(0, i);
+        return;
+    }
+    std::atomic<size_t> next{0};
+    std::vector<std::thread> pool;
+    for (size_t t = 0; t < threads; ++t) {
+        pool.emplace_back([&, t] {
+            for (size_t i = next++; i < count; i = next++) job(t, i);
+        });
+    }
+    for (auto& th : pool) th.join();
+}
+
+bool queueGreater(const SearchWorkspace::QueueItem& a, const SearchWorkspace::QueueItem& b) {
+    return a.key > b.key;
+}
+
+void push(SearchWorkspace& ws, double g, uint32_t state, uint32_t from) {
+    ws.touch(state, g, from);
+    ws.heap.push_back({g, g, state});
+    std::push_heap(ws.heap.begin(), ws.heap.end(), queueGreater);
+}
+
+SearchWorkspace::QueueItem pop(SearchWorkspace& ws) {
+    std::pop_heap(ws.heap.begin(), ws.heap.end(), queueGreater);
+    const SearchWorkspace::QueueItem item = ws.heap.back();
+    ws.heap.pop_back();
+    return item;
+}
+
+// Arc while contracting, with the number of graph edges it stands for.
+struct OverlayArc : Arc {
+    uint32_t hops;
+};
+
+struct Shortcut {
+    NodeIndex from;
+    NodeIndex to;
+    double cost;
+    uint32_t hops;
+};
+
+// The graph while it is being contracted: arcs between the nodes left, each
+// pair at most once per direction (the cheapest).
+struct Overlay {
+    std::vector<std::vector<OverlayArc>> out; // OverlayArc::other: head
+    std::vector<std::vector<OverlayArc>> in;  // OverlayArc::other: tail
+    std::vector<uint8_t> contracting;         // in this round's independent set
+
+    static void addArc(std::vector<OverlayArc>& arcs, const OverlayArc& arc) {
+        for (OverlayArc& a : arcs) {
+            if (a.other != arc.other) continue;
+            if (arc.cost < a.cost) a = arc;
+            return;
+        }
+        arcs.push_back(arc);
+    }
+
+    static void removeArcs(std::vector<OverlayArc>& arcs, NodeIndex other) {
+        arcs.erase(std::remove_if(arcs.begin(), arcs.end(), [&](const OverlayArc& a) { return a.other == other; }),
+                   arcs.end());
+    }
+
+    // A witness for u -> v -> w: a path avoiding v that is strictly cheaper
+    // or, if it also avoids this round's other nodes, no dearer. Ties through
+    // a node contracted alongside v could vanish with it; a strictly cheaper
+    // path means u -> v -> w is on no shortest path at all.
+    static bool witnessed(const SearchWorkspace& ws, NodeIndex w, double cost) {
+        return ws.touched(w) && (ws.gScore[w] < cost || (ws.gScore[w] == cost && ws.parent[w] == 0));
+    }
+
+    // Dijkstra from source without `via` until every target is witnessed,
+    // costs pass maxCost, or the settle limit. ws.parent holds 1 where the
+    // best path found passes this round's nodes, 0 where it does not.
+    void witnessSearch(NodeIndex source, NodeIndex via, const std::vector<OverlayArc>& targets, double viaCost,
+                       double maxCost, size_t settleLimit, SearchWorkspace& ws) const {
+        ws.reset(out.size());
+        push(ws, 0.0, source, 0);
+        size_t settled = 0, next = 0;
+        while (!ws.heap.empty() && settled < settleLimit) {
+            const SearchWorkspace::QueueItem item = pop(ws);
+            const NodeIndex u = item.state;
+            if (item.g > ws.gScore[u]) continue; // stale entry
+            if (item.g > maxCost) break;
+            ++settled;
+            // a witness, once found, stays one: skip past the witnessed targets
+            while (next < targets.size() &&
+                   (targets[next].other == source || witnessed(ws, targets[next].other, viaCost + targets[next].cost)))
+                ++next;
+            if (next == targets.size()) break;
+            for (const OverlayArc& a : out[u]) {
+                if (a.other == via) continue;
+                const double g = item.g + a.cost;
+                if (g > maxCost) continue;
+                const uint32_t throughRound = ws.parent[u] | contracting[a.other];
+                if (!ws.touched(a.other) || g < ws.gScore[a.other]) push(ws, g, a.other, throughRound);
+                else if (g == ws.gScore[a.other] && !throughRound) ws.parent[a.other] = 0;
+            }
+        }
+    }
+
+    // Shortcuts contracting v needs: u -> v -> w unless witnessed.
+    void shortcutsFor(NodeIndex v, size_t settleLimit, SearchWorkspace& ws, std::vector<Shortcut>& shortcuts,
+                      size_t& searches) const {
+        shortcuts.clear();
+        for (const OverlayArc& from : in[v]) {
+            double maxCost = 0.0;
+            for (const OverlayArc& to : out[v]) {
+                if (to.other != from.other) maxCost = std::max(maxCost, from.cost + to.cost);
+            }
+            if (maxCost == 0.0) continue;
+            witnessSearch(from.other, v, out[v], from.cost, maxCost, settleLimit, ws);
+            ++searches;
+            for (const OverlayArc& to : out[v]) {
+                if (to.other == from.other) continue;
+                const double cost = from.cost + to.cost;
+                if (!witnessed(ws, to.other, cost))
+                    shortcuts.push_back({from.other, to.other, cost, from.hops + to.hops});
+            }
+        }
+    }
+};
+
+// Deterministic scramble of a node index.
+uint32_t mix(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7feb352dU;
+    x ^= x >> 15;
+    x *= 0x846ca68bU;
+    x ^= x >> 16;
+    return x;
+}
+
+uint64_t fnv(uint64_t h, const void* data, size_t size) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        h ^= p[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+} // namespace
+
+std::shared_ptr<const ContractionHierarchy> ContractionHierarchy::build(const RoutingGraph& graph, Profile profile,
+                                                                        Metric metric, size_t threads,
+                                                                        BuildStats* stats) {
+    const auto t0 = std::chrono::steady_clock::now();
+    const size_t n = graph.coreNodeCount();
+    Overlay overlay;
+    overlay.out.resize(n);
+    overlay.in.resize(n);
+    overlay.contracting.assign(n, 0);
+    for (NodeIndex u = 0; u < n; ++u) {
+        for (const auto& edge : graph.edges(u)) {
+            if (!edge.allows(profile) || edge.to == u) continue;
+            const EdgeIndex e = graph.edgeIndex(edge);
+            const double cost = graph.cost(e, metric, profile);
+            Overlay::addArc(overlay.out[u], {{edge.to, RoutingGraph::INVALID_NODE, e, cost}, 1});
+            Overlay::addArc(overlay.in[edge.to], {{u, RoutingGraph::INVALID_NODE, e, cost}, 1});
+        }
+    }
+
+    const size_t workers = threadCount(threads, n);
+    std::vector<SearchWorkspace> workspaces(workers);
+    std::vector<std::vector<Shortcut>> scratch(workers);
+    std::vector<size_t> searches(workers, 0);
+
+    // level (one above the highest contracted neighbour) plus the arcs and
+    // the graph edges contraction would add, each relative to what it removes;
+    // ratios keep dense late nodes from all looking equally bad
+    std::vector<double> priority(n, 0.0);
+    std::vector<uint32_t> level(n, 0);
+    auto updatePriority = [&](size_t worker, NodeIndex v) {
+        const std::vector<Shortcut>& added = scratch[worker];
+        overlay.shortcutsFor(v, ESTIMATE_SETTLE_LIMIT, workspaces[worker], scratch[worker], searches[worker]);
+        const double removedArcs = double(overlay.in[v].size() + overlay.out[v].size());
+        double removedHops = 0.0, addedHops = 0.0;
+        for (const OverlayArc& a : overlay.in[v]) removedHops += a.hops;
+        for (const OverlayArc& a : overlay.out[v]) removedHops += a.hops;
+        for (const Shortcut& s : added) addedHops += s.hops;
+        priority[v] = level[v];
+        if (removedArcs > 0.0) priority[v] += added.size() / removedArcs + addedHops / removedHops;
+    };
+    parallelFor(n, threads, [&](size_t worker, size_t v) { updatePriority(worker, static_cast<NodeIndex>(v)); });
+    // ties broken by a hash, not the id: ids run along ways, so an id order
+    // would leave one local minimum per stretch of equal priorities
+    auto before = [&](NodeIndex a, NodeIndex b) {
+        if (priority[a] != priority[b]) return priority[a] < priority[b];
+        const uint32_t ha = mix(a), hb = mix(b);
+        return ha < hb || (ha == hb && a < b);
+    };
+
+    std::shared_ptr<ContractionHierarchy> ch(new ContractionHierarchy());
+    ch->m_profile = profile;
+    ch->m_metric = metric;
+    ch->m_edgeCount = graph.edgeCount();
+    ch->m_rank.assign(n, 0);
+    std::vector<std::vector<Arc>> up(n), down(n);
+
+    std::vector<NodeIndex> remaining(n);
+    for (NodeIndex v = 0; v < n; ++v) remaining[v] = v;
+    std::vector<uint8_t> chosen, dirty(n, 0);
+    std::vector<NodeIndex> round, touched;
+    std::vector<std::vector<Shortcut>> shortcuts;
+    uint32_t nextRank = 0;
+    size_t rounds = 0, shortcutCount = 0;
+    while (!remaining.empty()) {
+        ++rounds;
+        // independent set: nodes ahead of every neighbour still in the graph
+        chosen.assign(remaining.size(), 0);
+        parallelFor(remaining.size(), threads, [&](size_t, size_t i) {
+            const NodeIndex v = remaining[i];
+            for (const Arc& a : overlay.out[v]) {
+                if (!before(v, a.other)) return;
+            }
+            for (const Arc& a : overlay.in[v]) {
+                if (!before(v, a.other)) return;
+            }
+            chosen[i] = 1;
+        });
+        round.clear();
+        for (size_t i = 0; i < remaining.size(); ++i) {
+            if (chosen[i]) round.push_back(remaining[i]);
+        }
+        for (NodeIndex v : round) overlay.contracting[v] = 1;
+
+        // see Overlay::witnessed(): two nodes of the set must not merely tie
+        // as each other's witnesses
+        shortcuts.resize(round.size());
+        parallelFor(round.size(), threads, [&](size_t worker, size_t i) {
+            overlay.shortcutsFor(round[i], WITNESS_SETTLE_LIMIT, workspaces[worker], shortcuts[i], searches[worker]);
+        });
+
+        // merged in node order, so the result does not depend on the threads
+        touched.clear();
+        for (size_t i = 0; i < round.size(); ++i) {
+            const NodeIndex v = round[i];
+            ch->m_rank[v] = nextRank++;
+            up[v].assign(overlay.out[v].begin(), overlay.out[v].end());
+            down[v].assign(overlay.in[v].begin(), overlay.in[v].end());
+            for (const Shortcut& s : shortcuts[i]) {
+                Overlay::addArc(overlay.out[s.from], {{s.to, v, RoutingGraph::INVALID_EDGE, s.cost}, s.hops});
+                Overlay::addArc(overlay.in[s.to], {{s.from, v, RoutingGraph::INVALID_EDGE, s.cost}, s.hops});
+            }
+            shortcutCount += shortcuts[i].size();
+            for (const Arc& a : up[v]) {
+                Overlay::removeArcs(overlay.in[a.other], v);
+                level[a.other] = std::max(level[a.other], level[v] + 1);
+                touched.push_back(a.other);
+            }
+            for (const Arc& a : down[v]) {
+                Overlay::removeArcs(overlay.out[a.other], v);
+                level[a.other] = std::max(level[a.other], level[v] + 1);
+                touched.push_back(a.other);
+            }
+            overlay.out[v] = {};
+            overlay.in[v] = {};
+        }
+        remaining.erase(std::remove_if(remaining.begin(), remaining.end(),
+                                       [&](NodeIndex v) { return overlay.contracting[v] != 0; }),
+                        remaining.end());
+        for (NodeIndex v : round) overlay.contracting[v] = 0;
+
+        // neighbours of the contracted nodes get new arcs: reprioritize them
+        std::vector<NodeIndex> update;
+        for (NodeIndex w : touched) {
+            if (!dirty[w]) {
+                dirty[w] = 1;
+                update.push_back(w);
+            }
+        }
+        std::sort(update.begin(), update.end());
+        for (NodeIndex w : update) dirty[w] = 0;
+        parallelFor(update.size(), threads, [&](size_t worker, size_t i) { updatePriority(worker, update[i]); });
+    }
+
+    for (NodeIndex v = 0; v < n; ++v) {
+        ch->m_up.insert(ch->m_up.end(), up[v].begin(), up[v].end());
+        ch->m_upOffsets.push_back(static_cast<uint32_t>(ch->m_up.size()));
+        ch->m_down.insert(ch->m_down.end(), down[v].begin(), down[v].end());
+        ch->m_downOffsets.push_back(static_cast<uint32_t>(ch->m_down.size()));
+    }
+    if (stats) {
+        stats->rounds = rounds;
+        stats->shortcuts = shortcutCount;
+        stats->witnessSearches = 0;
+        for (size_t s : searches) stats->witnessSearches += s;
+        stats->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    }
+    return ch;
+}
+
+uint64_t ContractionHierarchy::checksum() const {
+    uint64_t h = 14695981039346656037ULL;
+    h = fnv(h, m_rank.data(), m_rank.size() * sizeof(uint32_t));
+    for (const std::vector<Arc>* arcs : {&m_up, &m_down}) {
+        for (const Arc& a : *arcs) {
+            h = fnv(h, &a.other, sizeof(a.other));
+            h = fnv(h, &a.middle, sizeof(a.middle));
+            h = fnv(h, &a.edge, sizeof(a.edge));
+            h = fnv(h, &a.cost, sizeof(a.cost));
+        }
+    }
+    return h;
+}
+
+// Hierarchy file layout (native endianness): "RTCHIER1", u8 profile, u8
+// metric, u64 graph edge count, then m_rank, m_upOffsets, m_up, m_downOffsets
+// and m_down as u64 length + raw elements.
+static const char HIERARCHY_MAGIC[8] = {'R','T','C','H','I','E','R','1'};
+
+bool ContractionHierarchy::save(const std::string& filename) const {
+    std::ofstream out(filename, std::ios::binary);
+    if (!out) {
+        std::cerr << "Failed to open hierarchy file for writing: " << filename << "\n";
+        return false;
+    }
+    const uint8_t profile = static_cast<uint8_t>(m_profile);
+    const uint8_t metric = static_cast<uint8_t>(m_metric);
+    out.write(HIERARCHY_MAGIC, sizeof(HIERARCHY_MAGIC));
+    out.write(reinterpret_cast<const char*>(&profile), sizeof(profile));
+    out.write(reinterpret_cast<const char*>(&metric), sizeof(metric));
+    out.write(reinterpret_cast<const char*>(&m_edgeCount), sizeof(m_edgeCount));
+    writeArray(out, m_rank);
+    writeArray(out, m_upOffsets);
+    writeArray(out, m_up);
+    writeArray(out, m_downOffsets);
+    writeArray(out, m_down);
+    return static_cast<bool>(out);
+}
+
+std::shared_ptr<const ContractionHierarchy> ContractionHierarchy::load(const RoutingGraph& graph,
+                                                                       const std::string& filename) {
+    std::ifstream in(filename, std::ios::binary);
+    if (!in) {
+        std::cerr << "Failed to open hierarchy file: " << filename << "\n";
+        return nullptr;
+    }
+
+    char magic[sizeof(HIERARCHY_MAGIC)];
+    if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, HIERARCHY_MAGIC, sizeof(magic)) != 0) {
+        std::cerr << "Not a route_tracer hierarchy file: " << filename << "\n";
+        return nullptr;
+    }
+
+    std::shared_ptr<ContractionHierarchy> ch(new ContractionHierarchy());
+    uint8_t profile = 0, metric = 0;
+    bool ok = in.read(reinterpret_cast<char*>(&profile), sizeof(profile)) &&
+              in.read(reinterpret_cast<char*>(&metric), sizeof(metric)) &&
+              in.read(reinterpret_cast<char*>(&ch->m_edgeCount), sizeof(ch->m_edgeCount)) &&
+              readArray(in, ch->m_rank) && readArray(in, ch->m_upOffsets) && readArray(in, ch->m_up) &&
+              readArray(in, ch->m_downOffsets) && readArray(in, ch->m_down);
+    ch->m_profile = static_cast<Profile>(profile);
+    ch->m_metric = static_cast<Metric>(metric);
+
+    // every arc must point at a node and, unpacked, at an edge of a graph this size
+    const size_t n = ch->m_rank.size();
+    auto offsetsOk = [&](const std::vector<uint32_t>& offsets, const std::vector<Arc>& arcs) {
+        return offsets.size() == n + 1 && offsets[0] == 0 && offsets.back() == arcs.size() &&
+               std::is_sorted(offsets.begin(), offsets.end());
+    };
+    auto arcsOk = [&](const std::vector<Arc>& arcs) {
+        return std::all_of(arcs.begin(), arcs.end(), [&](const Arc& a) {
+            return a.other < n && (a.middle == RoutingGraph::INVALID_NODE ? a.edge < ch->m_edgeCount : a.middle < n);
+        });
+    };
+    ok = ok && profile < PROFILE_COUNT && metric <= static_cast<uint8_t>(Metric::Duration) &&
+         offsetsOk(ch->m_upOffsets, ch->m_up) && offsetsOk(ch->m_downOffsets, ch->m_down) && arcsOk(ch->m_up) &&
+         arcsOk(ch->m_down);
+    if (!ok) {
+        std::cerr << "Truncated or corrupt hierarchy file: " << filename << "\n";
+        return nullptr;
+    }
+    if (n != graph.coreNodeCount() || ch->m_edgeCount != graph.edgeCount()) {
+        std::cerr << "Hierarchy file " << filename << " was made for another graph\n";
+        return nullptr;
+    }
+    return ch;
+}
+
+bool ContractionHierarchy::answers(const RoutingGraph& graph, const SearchOptions& options) const {
+    const bool timed = options.traffic && options.metric == Metric::Duration && followsTraffic(options.profile);
+    return m_rank.size() == graph.coreNodeCount() && m_edgeCount == graph.edgeCount() &&
+           options.profile == m_profile && options.metric == m_metric && !usesTurnSearch(graph, options) && !timed &&
+           (!options.overrides || options.overrides->overriddenEdges() == 0);
+}
+
+Route ContractionHierarchy::route(const RoutingGraph& graph, NodeIndex start, NodeIndex goal,
+                                  SearchWorkspace& forward, SearchWorkspace& backward) const {
+    Route result{{}, INF};
+    if (start >= graph.nodeCount() || goal >= graph.nodeCount()) return result;
+    if (start == goal) return {{start}, 0.0};
+
+    // a shape node enters the hierarchy at the ends of the edges it lies on
+    RoutingGraph::ShapeRef from[2], to[2];
+    const size_t fromCount = graph.shapeRefs(start, from, m_profile);
+    const size_t toCount = graph.shapeRefs(goal, to, m_profile);
+    auto fromCost = [&](size_t k) {
+        return graph.cost(from[k].edge, m_metric, m_profile) -
+               graph.shape(from[k].edge)[from[k].index].cost(m_metric, m_profile);
+    };
+    auto toCost = [&](size_t k) { return graph.shape(to[k].edge)[to[k].index].cost(m_metric, m_profile); };
+
+    forward.reset(m_rank.size());
+    backward.reset(m_rank.size());
+    if (graph.isCore(start)) push(forward, 0.0, start, RoutingGraph::INVALID_STATE);
+    for (size_t k = 0; k < fromCount; ++k) {
+        const NodeIndex head = graph.edge(from[k].edge).to;
+        if (!forward.touched(head) || fromCost(k) < forward.gScore[head])
+            push(forward, fromCost(k), head, RoutingGraph::INVALID_STATE);
+    }
+    if (graph.isCore(goal)) push(backward, 0.0, goal, RoutingGraph::INVALID_STATE);
+    for (size_t k = 0; k < toCount; ++k) {
+        const NodeIndex tail = graph.edgeTail(to[k].edge);
+        if (!backward.touched(tail) || toCost(k) < backward.gScore[tail])
+            push(backward, toCost(k), tail, RoutingGraph::INVALID_STATE);
+    }
+
+    // both on one edge, start first
+    double best = INF;
+    size_t direct = SIZE_MAX;
+    for (size_t i = 0; i < fromCount; ++i) {
+        for (size_t j = 0; j < toCount; ++j) {
+            if (from[i].edge != to[j].edge || from[i].index >= to[j].index) continue;
+            const double cost = toCost(j) - graph.shape(from[i].edge)[from[i].index].cost(m_metric, m_profile);
+            if (cost < best) {
+                best = cost;
+                direct = i * 2 + j;
+            }
+        }
+    }
+
+    // upward searches; a side stops once its queue cannot beat the best meeting
+    NodeIndex meet = RoutingGraph::INVALID_NODE;
+    for (;;) {
+        const bool f = !forward.heap.empty() && forward.heap.front().key < best;
+        const bool b = !backward.heap.empty() && backward.heap.front().key < best;
+        if (!f && !b) break;
+        const bool useForward = f && (!b || forward.heap.front().key <= backward.heap.front().key);
+        SearchWorkspace& ws = useForward ? forward : backward;
+        const SearchWorkspace& other = useForward ? backward : forward;
+        const SearchWorkspace::QueueItem item = pop(ws);
+        const NodeIndex u = item.state;
+        if (item.g > ws.gScore[u]) continue; // stale entry
+        ++ws.nodesExplored;
+        if (other.touched(u) && item.g + other.gScore[u] < best) {
+            best = item.g + other.gScore[u];
+            meet = u;
+        }
+        // stall: a higher node already reaches u more cheaply, so no
+        // shortest path continues upwards from here
+        bool stalled = false;
+        for (const Arc& a : useForward ? downArcs(u) : upArcs(u)) {
+            if (ws.touched(a.other) && ws.gScore[a.other] + a.cost < item.g) {
+                stalled = true;
+                break;
+            }
+        }
+        if (stalled) continue;
+        const ArcRange arcs = useForward ? upArcs(u) : downArcs(u);
+        const Arc* base = useForward ? m_up.data() : m_down.data();
+        for (const Arc& a : arcs) {
+            const double g = item.g + a.cost;
+            if (!ws.touched(a.other) || g < ws.gScore[a.other])
+                push(ws, g, a.other, static_cast<uint32_t>(&a - base));
+        }
+    }
+    if (best == INF) return result;
+    result.cost = best;
+    if (meet == RoutingGraph::INVALID_NODE) {
+        const size_t i = direct / 2, j = direct % 2;
+        result.path.push_back(start);
+        const RoutingGraph::ShapeRange s = graph.shape(to[j].edge);
+        for (size_t p = from[i].index + 1; p <= to[j].index; ++p) result.path.push_back(s[p].node);
+        return result;
+    }
+
+    // the arcs of both halves in travel order
+    struct Step {
+        NodeIndex from;
+        NodeIndex to;
+        const Arc* arc;
+    };
+    auto owner = [](const std::vector<uint32_t>& offsets, uint32_t index) {
+        return static_cast<NodeIndex>(std::upper_bound(offsets.begin(), offsets.end(), index) - offsets.begin() - 1);
+    };
+    std::vector<Step> steps;
+    NodeIndex first = meet;
+    while (forward.parent[first] != RoutingGraph::INVALID_STATE) {
+        const uint32_t index = forward.parent[first];
+        const NodeIndex tail = owner(m_upOffsets, index);
+        steps.push_back({tail, first, &m_up[index]});
+        first = tail;
+    }
+    std::reverse(steps.begin(), steps.end());
+    NodeIndex last = meet;
+    while (backward.parent[last] != RoutingGraph::INVALID_STATE) {
+        const uint32_t index = backward.parent[last];
+        const NodeIndex head = owner(m_downOffsets, index);
+        steps.push_back({last, head, &m_down[index]});
+        last = head;
+    }
+
+    // the cheapest seed edges that reach first and leave last
+    size_t seed = SIZE_MAX, leave = SIZE_MAX;
+    if (!graph.isCore(start)) {
+        for (size_t k = 0; k < fromCount; ++k) {
+            if (graph.edge(from[k].edge).to == first && (seed == SIZE_MAX || fromCost(k) < fromCost(seed))) seed = k;
+        }
+    }
+    if (!graph.isCore(goal)) {
+        for (size_t k = 0; k < toCount; ++k) {
+            if (graph.edgeTail(to[k].edge) == last && (leave == SIZE_MAX || toCost(k) < toCost(leave))) leave = k;
+        }
+    }
+
+    result.path.push_back(start);
+    auto appendEdge = [&](EdgeIndex e, size_t fromIndex, size_t until) {
+        const RoutingGraph::ShapeRange s = graph.shape(e);
+        for (size_t i = fromIndex; i < s.size() && i <= until; ++i) result.path.push_back(s[i].node);
+        if (until == SIZE_MAX) result.path.push_back(graph.edge(e).to);
+    };
+    if (seed != SIZE_MAX) appendEdge(from[seed].edge, from[seed].index + 1, SIZE_MAX);
+    // a shortcut a -> b skipping m is the arcs a -> m and m -> b, both stored at m
+    std::vector<Step> stack(steps.rbegin(), steps.rend());
+    while (!stack.empty()) {
+        const Step step = stack.back();
+        stack.pop_back();
+        if (step.arc->middle == RoutingGraph::INVALID_NODE) {
+            appendEdge(step.arc->edge, 0, SIZE_MAX);
+            continue;
+        }
+        const NodeIndex m = step.arc->middle;
+        const Arc* in = nullptr;
+        const Arc* out = nullptr;
+        for (const Arc& a : downArcs(m)) {
+            if (a.other == step.from) in = &a;
+        }
+        for (const Arc& a : upArcs(m)) {
+            if (a.other == step.to) out = &a;
+        }
+        if (!in || !out) return {{}, INF};
+        stack.push_back({m, step.to, out});
+        stack.push_back({step.from, m, in});
+    }
+    if (leave != SIZE_MAX) appendEdge(to[leave].edge, 0, to[leave].index);
+    return result;
+}
+
+static std::shared_ptr<const ContractionHierarchy> g_currentHierarchy;
+
+std::shared_ptr<const ContractionHierarchy> currentHierarchy() {
+    return std::atomic_load(&g_currentHierarchy);
+}
+
+void publishHierarchy(std::shared_ptr<const ContractionHierarchy> hierarchy) {
+    std::atomic_store(&g_currentHierarchy, std::move(hierarchy));
+}
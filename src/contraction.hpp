@@ -0,0 +1,110 @@
+#ifndef CONTRACTION_HPP
+#define CONTRACTION_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "a_star.hpp"
+#include "routing_graph.hpp"
+
+// Contraction hierarchy over the core nodes of a RoutingGraph for one profile
+// and metric: every node gets a rank, and shortcuts stand in for the shortest
+// paths through lower-ranked nodes, so a query only searches upwards from both
+// ends. Static weights only: it ignores turn restrictions, traffic and
+// WeightOverrides, so it answers the searches that !usesTurnSearch() and carry
+// neither. That always leaves bicycle and foot; car and motorbike qualify only
+// on graphs without restrictions for them.
+//
+// Contraction runs in rounds. Each round takes the nodes whose priority (level
+// plus the arcs and edges contracting them would add, relative to those it
+// removes) is lower than every remaining neighbour's, an independent set, and
+// contracts them on all threads at once, each thread running its witness
+// searches in its own SearchWorkspace. The shortcuts are merged in node order,
+// so the hierarchy does not depend on the thread count.
+//
+// 'preprocess --ch' saves one next to the graph file and 'serve --ch' loads
+// and publishes it; /route then answers the queries it covers from it.
+class ContractionHierarchy {
+public:
+    using NodeIndex = RoutingGraph::NodeIndex;
+    using EdgeIndex = RoutingGraph::EdgeIndex;
+
+    // CH edge; stored at its lower-ranked end (see upArcs() / downArcs()).
+    struct Arc {
+        NodeIndex other;  // the higher-ranked end
+        NodeIndex middle; // node a shortcut skips, INVALID_NODE for a graph edge
+        EdgeIndex edge;   // that graph edge, INVALID_EDGE for a shortcut
+        double cost;
+    };
+
+    struct ArcRange {
+        const Arc* first;
+        const Arc* last;
+        const Arc* begin() const { return first; }
+        const Arc* end() const { return last; }
+        size_t size() const { return static_cast<size_t>(last - first); }
+    };
+
+    struct BuildStats {
+        size_t rounds = 0;
+        size_t shortcuts = 0;
+        size_t witnessSearches = 0;
+        double seconds = 0.0;
+    };
+
+    // threads 0: one per core.
+    static std::shared_ptr<const ContractionHierarchy> build(const RoutingGraph& graph, Profile profile, Metric metric,
+                                                             size_t threads = 0, BuildStats* stats = nullptr);
+
+    Profile profile() const { return m_profile; }
+    Metric metric() const { return m_metric; }
+    uint32_t rank(NodeIndex u) const { return m_rank[u]; }
+    // u -> other with rank(other) > rank(u)
+    ArcRange upArcs(NodeIndex u) const { return {m_up.data() + m_upOffsets[u], m_up.data() + m_upOffsets[u + 1]}; }
+    // other -> u with rank(other) > rank(u)
+    ArcRange downArcs(NodeIndex u) const {
+        return {m_down.data() + m_downOffsets[u], m_down.data() + m_downOffsets[u + 1]};
+    }
+    size_t arcCount() const { return m_up.size() + m_down.size(); }
+    // FNV-1a over ranks and arcs, to compare builds.
+    uint64_t checksum() const;
+
+    // Hierarchy file, only valid for the graph it was built from; load()
+    // rejects files made for another graph.
+    bool save(const std::string& filename) const;
+    static std::shared_ptr<const ContractionHierarchy> load(const RoutingGraph& graph, const std::string& filename);
+
+    // True if route() answers searches on graph with these options as astar()
+    // would: built for graph, same profile and metric, a node-based search,
+    // no traffic and no overrides in effect.
+    bool answers(const RoutingGraph& graph, const SearchOptions& options) const;
+
+    // Cheapest route from start to goal (any graph nodes, shape nodes
+    // included), as astar() would find it for these profile and metric:
+    // bidirectional upward Dijkstra with stall-on-demand, then shortcuts
+    // unpacked into graph nodes.
+    // Empty path and infinite cost if unreachable, or if the arcs of a
+    // shortcut are missing (a hierarchy that does not belong to graph).
+    Route route(const RoutingGraph& graph, NodeIndex start, NodeIndex goal, SearchWorkspace& forward,
+                SearchWorkspace& backward) const;
+
+private:
+    ContractionHierarchy() = default;
+
+    Profile m_profile = Profile::Car;
+    Metric m_metric = Metric::Duration;
+    uint64_t m_edgeCount = 0; // of the graph, to reject mismatched files
+    std::vector<uint32_t> m_rank;
+    std::vector<uint32_t> m_upOffsets{0};
+    std::vector<Arc> m_up;
+    std::vector<uint32_t> m_downOffsets{0};
+    std::vector<Arc> m_down;
+};
+
+// Process-wide hierarchy slot next to currentGraph(); empty means none.
+std::shared_ptr<const ContractionHierarchy> currentHierarchy();
+void publishHierarchy(std::shared_ptr<const ContractionHierarchy> hierarchy);
+
+#endif
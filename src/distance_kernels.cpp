@@ -0,0 +1,306 @@
+#include "distance_kernels.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define ROUTE_TRACER_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+constexpr double FIXED_TO_RAD = PI_CONST / 180.0 / COORD_SCALE;
+constexpr double HALF_PI = PI_CONST / 2.0;
+
+// sin(x) Taylor terms up to x^15, highest first: under 1e-11 relative error on [-pi/2, pi/2].
+constexpr double SIN_COEFFS[] = {
+    -1.0 / 1307674368000.0, 1.0 / 6227020800.0, -1.0 / 39916800.0, 1.0 / 362880.0,
+    -1.0 / 5040.0, 1.0 / 120.0, -1.0 / 6.0, 1.0
+};
+
+// asin(s) series up to s^11, highest first. Used for s <= ASIN_POLY_LIMIT
+// (arcs up to ~1280 km); longer arcs fall back to haversine().
+constexpr double ASIN_COEFFS[] = {
+    63.0 / 2816.0, 35.0 / 1152.0, 5.0 / 112.0, 3.0 / 40.0, 1.0 / 6.0, 1.0
+};
+constexpr double ASIN_POLY_LIMIT = 0.1;
+
+void haversineScalar(const FixedCoord* a, const FixedCoord* b, size_t n, double* out) {
+    for (size_t i = 0; i < n; ++i) out[i] = haversine(a[i], b[i]);
+}
+
+size_t nearestScalar(const float* x, const float* y, const float* z, size_t n,
+                     float qx, float qy, float qz, size_t first = 0,
+                     float bestDist = std::numeric_limits<float>::infinity(), size_t best = 0) {
+    for (size_t i = first; i < n; ++i) {
+        float dx = x[i] - qx, dy = y[i] - qy, dz = z[i] - qz;
+        float d = dx * dx + dy * dy + dz * dz;
+        if (d < bestDist) {
+            bestDist = d;
+            best = i;
+        }
+    }
+    return best;
+}
+
+#ifdef ROUTE_TRACER_X86_SIMD
+
+// ---- AVX2 + FMA, 4 doubles / 8 floats per step ----
+
+__attribute__((target("avx2,fma")))
+inline __m256d polyAvx2(const double* coeffs, size_t count, __m256d x2) {
+    __m256d p = _mm256_set1_pd(coeffs[0]);
+    for (size_t i = 1; i < count; ++i) p = _mm256_fmadd_pd(p, x2, _mm256_set1_pd(coeffs[i]));
+    return p;
+}
+
+__attribute__((target("avx2,fma")))
+inline __m256d sinAvx2(__m256d x) {
+    return _mm256_mul_pd(polyAvx2(SIN_COEFFS, 8, _mm256_mul_pd(x, x)), x);
+}
+
+// Splits four packed FixedCoords into latitude and longitude radians.
+__attribute__((target("avx2,fma")))
+inline void loadCoordsAvx2(const FixedCoord* c, __m256d& lat, __m256d& lon) {
+    const __m256i split = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+    const __m256d k = _mm256_set1_pd(FIXED_TO_RAD);
+    __m256i v = _mm256_permutevar8x32_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(c)), split);
+    lat = _mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(v)), k);
+    lon = _mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(v, 1)), k);
+}
+
+__attribute__((target("avx2,fma")))
+void haversineAvx2(const FixedCoord* a, const FixedCoord* b, size_t n, double* out) {
+    const __m256d signBit = _mm256_set1_pd(-0.0);
+    const __m256d half = _mm256_set1_pd(0.5);
+    const __m256d halfPi = _mm256_set1_pd(HALF_PI);
+    const __m256d pi = _mm256_set1_pd(PI_CONST);
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d limit = _mm256_set1_pd(ASIN_POLY_LIMIT);
+    const __m256d diameter = _mm256_set1_pd(2.0 * EARTH_RADIUS_M);
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d lat1, lon1, lat2, lon2;
+        loadCoordsAvx2(a + i, lat1, lon1);
+        loadCoordsAvx2(b + i, lat2, lon2);
+
+        __m256d sLat = sinAvx2(_mm256_mul_pd(_mm256_sub_pd(lat2, lat1), half));
+        // sin^2 has period pi, so fold |dLon/2| into [0, pi/2]
+        __m256d t = _mm256_andnot_pd(signBit, _mm256_mul_pd(_mm256_sub_pd(lon2, lon1), half));
+        __m256d sLon = sinAvx2(_mm256_min_pd(t, _mm256_sub_pd(pi, t)));
+        __m256d cos1 = sinAvx2(_mm256_sub_pd(halfPi, _mm256_andnot_pd(signBit, lat1)));
+        __m256d cos2 = sinAvx2(_mm256_sub_pd(halfPi, _mm256_andnot_pd(signBit, lat2)));
+
+        __m256d h = _mm256_fmadd_pd(_mm256_mul_pd(cos1, cos2), _mm256_mul_pd(sLon, sLon),
+                                    _mm256_mul_pd(sLat, sLat));
+        __m256d s = _mm256_sqrt_pd(_mm256_min_pd(_mm256_max_pd(h, zero), one));
+        __m256d arc = _mm256_mul_pd(polyAvx2(ASIN_COEFFS, 6, _mm256_mul_pd(s, s)), s);
+        _mm256_storeu_pd(out + i, _mm256_mul_pd(arc, diameter));
+
+        int far = _mm256_movemask_pd(_mm256_cmp_pd(s, limit, _CMP_GT_OQ));
+        for (int lane = 0; far != 0; ++lane, far >>= 1) {
+            if (far & 1) out[i + lane] = haversine(a[i + lane], b[i + lane]);
+        }
+    }
+    haversineScalar(a + i, b + i, n - i, out + i);
+}
+
+__attribute__((target("avx2,fma")))
+size_t nearestAvx2(const float* x, const float* y, const float* z, size_t n, float qx, float qy, float qz) {
+    const __m256 vx = _mm256_set1_ps(qx), vy = _mm256_set1_ps(qy), vz = _mm256_set1_ps(qz);
+    __m256 bestDist = _mm256_set1_ps(std::numeric_limits<float>::infinity());
+    __m256i bestIdx = _mm256_setzero_si256();
+    __m256i idx = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i step = _mm256_set1_epi32(8);
+
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(x + i), vx);
+        __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(y + i), vy);
+        __m256 dz = _mm256_sub_ps(_mm256_loadu_ps(z + i), vz);
+        __m256 d = _mm256_fmadd_ps(dz, dz, _mm256_fmadd_ps(dy, dy, _mm256_mul_ps(dx, dx)));
+        __m256 closer = _mm256_cmp_ps(d, bestDist, _CMP_LT_OQ);
+        bestDist = _mm256_blendv_ps(bestDist, d, closer);
+        bestIdx = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(bestIdx), _mm256_castsi256_ps(idx), closer));
+        idx = _mm256_add_epi32(idx, step);
+    }
+
+    alignas(32) float dists[8];
+    alignas(32) uint32_t idxs[8];
+    _mm256_store_ps(dists, bestDist);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(idxs), bestIdx);
+    float best = std::numeric_limits<float>::infinity();
+    size_t bestI = 0;
+    for (int lane = 0; lane < 8; ++lane) {
+        if (dists[lane] < best || (dists[lane] == best && idxs[lane] < bestI)) {
+            best = dists[lane];
+            bestI = idxs[lane];
+        }
+    }
+    return nearestScalar(x, y, z, n, qx, qy, qz, i, best, bestI);
+}
+
+// ---- SSE2, 2 doubles / 4 floats per step ----
+
+__attribute__((target("sse2")))
+inline __m128d polySse2(const double* coeffs, size_t count, __m128d x2) {
+    __m128d p = _mm_set1_pd(coeffs[0]);
+    for (size_t i = 1; i < count; ++i) p = _mm_add_pd(_mm_mul_pd(p, x2), _mm_set1_pd(coeffs[i]));
+    return p;
+}
+
+__attribute__((target("sse2")))
+inline __m128d sinSse2(__m128d x) {
+    return _mm_mul_pd(polySse2(SIN_COEFFS, 8, _mm_mul_pd(x, x)), x);
+}
+
+__attribute__((target("sse2")))
+inline void loadCoordsSse2(const FixedCoord* c, __m128d& lat, __m128d& lon) {
+    const __m128d k = _mm_set1_pd(FIXED_TO_RAD);
+    __m128i v = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(c)), _MM_SHUFFLE(3, 1, 2, 0));
+    lat = _mm_mul_pd(_mm_cvtepi32_pd(v), k);
+    lon = _mm_mul_pd(_mm_cvtepi32_pd(_mm_unpackhi_epi64(v, v)), k);
+}
+
+__attribute__((target("sse2")))
+void haversineSse2(const FixedCoord* a, const FixedCoord* b, size_t n, double* out) {
+    const __m128d signBit = _mm_set1_pd(-0.0);
+    const __m128d half = _mm_set1_pd(0.5);
+    const __m128d halfPi = _mm_set1_pd(HALF_PI);
+    const __m128d pi = _mm_set1_pd(PI_CONST);
+    const __m128d zero = _mm_setzero_pd();
+    const __m128d one = _mm_set1_pd(1.0);
+    const __m128d limit = _mm_set1_pd(ASIN_POLY_LIMIT);
+    const __m128d diameter = _mm_set1_pd(2.0 * EARTH_RADIUS_M);
+
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128d lat1, lon1, lat2, lon2;
+        loadCoordsSse2(a + i, lat1, lon1);
+        loadCoordsSse2(b + i, lat2, lon2);
+
+        __m128d sLat = sinSse2(_mm_mul_pd(_mm_sub_pd(lat2, lat1), half));
+        __m128d t = _mm_andnot_pd(signBit, _mm_mul_pd(_mm_sub_pd(lon2, lon1), half));
+        __m128d sLon = sinSse2(_mm_min_pd(t, _mm_sub_pd(pi, t)));
+        __m128d cos1 = sinSse2(_mm_sub_pd(halfPi, _mm_andnot_pd(signBit, lat1)));
+        __m128d cos2 = sinSse2(_mm_sub_pd(halfPi, _mm_andnot_pd(signBit, lat2)));
+
+        __m128d h = _mm_add_pd(_mm_mul_pd(sLat, sLat),
+                               _mm_mul_pd(_mm_mul_pd(cos1, cos2), _mm_mul_pd(sLon, sLon)));
+        __m128d s = _mm_sqrt_pd(_mm_min_pd(_mm_max_pd(h, zero), one));
+        __m128d arc = _mm_mul_pd(polySse2(ASIN_COEFFS, 6, _mm_mul_pd(s, s)), s);
+        _mm_storeu_pd(out + i, _mm_mul_pd(arc, diameter));
+
+        int far = _mm_movemask_pd(_mm_cmpgt_pd(s, limit));
+        for (int lane = 0; far != 0; ++lane, far >>= 1) {
+            if (far & 1) out[i + lane] = haversine(a[i + lane], b[i + lane]);
+        }
+    }
+    haversineScalar(a + i, b + i, n - i, out + i);
+}
+
+__attribute__((target("sse2")))
+size_t nearestSse2(const float* x, const float* y, const float* z, size_t n, float qx, float qy, float qz) {
+    const __m128 vx = _mm_set1_ps(qx), vy = _mm_set1_ps(qy), vz = _mm_set1_ps(qz);
+    __m128 bestDist = _mm_set1_ps(std::numeric_limits<float>::infinity());
+    __m128 bestIdx = _mm_setzero_ps(); // lane indices, bit-cast to float for blending
+    __m128i idx = _mm_setr_epi32(0, 1, 2, 3);
+    const __m128i step = _mm_set1_epi32(4);
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 dx = _mm_sub_ps(_mm_loadu_ps(x + i), vx);
+        __m128 dy = _mm_sub_ps(_mm_loadu_ps(y + i), vy);
+        __m128 dz = _mm_sub_ps(_mm_loadu_ps(z + i), vz);
+        __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+        __m128 closer = _mm_cmplt_ps(d, bestDist);
+        bestDist = _mm_or_ps(_mm_and_ps(closer, d), _mm_andnot_ps(closer, bestDist));
+        bestIdx = _mm_or_ps(_mm_and_ps(closer, _mm_castsi128_ps(idx)), _mm_andnot_ps(closer, bestIdx));
+        idx = _mm_add_epi32(idx, step);
+    }
+
+    alignas(16) float dists[4];
+    alignas(16) uint32_t idxs[4];
+    _mm_store_ps(dists, bestDist);
+    _mm_store_si128(reinterpret_cast<__m128i*>(idxs), _mm_castps_si128(bestIdx));
+    float best = std::numeric_limits<float>::infinity();
+    size_t bestI = 0;
+    for (int lane = 0; lane < 4; ++lane) {
+        if (dists[lane] < best || (dists[lane] == best && idxs[lane] < bestI)) {
+            best = dists[lane];
+            bestI = idxs[lane];
+        }
+    }
+    return nearestScalar(x, y, z, n, qx, qy, qz, i, best, bestI);
+}
+
+#endif // ROUTE_TRACER_X86_SIMD
+
+SimdLevel& levelSlot() {
+    static SimdLevel level = detectedSimdLevel();
+    return level;
+}
+
+} // namespace
+
+SimdLevel detectedSimdLevel() {
+#ifdef ROUTE_TRACER_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return SimdLevel::AVX2;
+    if (__builtin_cpu_supports("sse2")) return SimdLevel::SSE2;
+#endif
+    return SimdLevel::Scalar;
+}
+
+SimdLevel activeSimdLevel() {
+    return levelSlot();
+}
+
+void setSimdLevel(SimdLevel level) {
+    levelSlot() = std::min(level, detectedSimdLevel());
+}
+
+const char* simdLevelName(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::AVX2: return "avx2";
+        case SimdLevel::SSE2: return "sse2";
+        default: return "scalar";
+    }
+}
+
+void haversineBatch(const FixedCoord* a, const FixedCoord* b, size_t n, double* out) {
+#ifdef ROUTE_TRACER_X86_SIMD
+    switch (activeSimdLevel()) {
+        case SimdLevel::AVX2: return haversineAvx2(a, b, n, out);
+        case SimdLevel::SSE2: return haversineSse2(a, b, n, out);
+        default: break;
+    }
+#endif
+    haversineScalar(a, b, n, out);
+}
+
+void projectToUnitSphere(const FixedCoord* coords, size_t n, float* x, float* y, float* z) {
+    for (size_t i = 0; i < n; ++i) {
+        double lat = coords[i].lat * FIXED_TO_RAD;
+        double lon = coords[i].lon * FIXED_TO_RAD;
+        x[i] = static_cast<float>(std::cos(lat) * std::cos(lon));
+        y[i] = static_cast<float>(std::cos(lat) * std::sin(lon));
+        z[i] = static_cast<float>(std::sin(lat));
+    }
+}
+
+size_t nearestByChord(const float* x, const float* y, const float* z, size_t n,
+                      float qx, float qy, float qz) {
+#ifdef ROUTE_TRACER_X86_SIMD
+    switch (activeSimdLevel()) {
+        case SimdLevel::AVX2: return nearestAvx2(x, y, z, n, qx, qy, qz);
+        case SimdLevel::SSE2: return nearestSse2(x, y, z, n, qx, qy, qz);
+        default: break;
+    }
+#endif
+    return nearestScalar(x, y, z, n, qx, qy, qz);
+}
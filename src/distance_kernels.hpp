@@ -0,0 +1,44 @@
+#ifndef DISTANCE_KERNELS_HPP
+#define DISTANCE_KERNELS_HPP
+
+#include <cmath>
+#include <cstddef>
+
+#include "geo.hpp"
+
+// Batch distance kernels with AVX2 / SSE2 / scalar implementations. The best
+// level the CPU supports is picked at first use; setSimdLevel() can force a
+// lower one (benchmarks, debugging).
+enum class SimdLevel { Scalar, SSE2, AVX2 };
+
+SimdLevel detectedSimdLevel();
+SimdLevel activeSimdLevel();
+// Clamped to detectedSimdLevel(). Not thread-safe; call before starting queries.
+void setSimdLevel(SimdLevel level);
+const char* simdLevelName(SimdLevel level);
+
+// out[i] = great-circle meters between a[i] and b[i]. Uses polynomial sin/asin,
+// within 1e-9 relative of haversine() for any pair.
+void haversineBatch(const FixedCoord* a, const FixedCoord* b, size_t n, double* out);
+
+// Points on the unit sphere, one float per axis per point (structure of arrays).
+// Chord length between two such points never exceeds their great-circle
+// distance / EARTH_RADIUS_M and orders pairs the same way.
+void projectToUnitSphere(const FixedCoord* coords, size_t n, float* x, float* y, float* z);
+
+// Index of the point closest to (qx, qy, qz) by chord length; n must be > 0.
+// Ties go to the lowest index.
+size_t nearestByChord(const float* x, const float* y, const float* z, size_t n,
+                      float qx, float qy, float qz);
+
+// Float rounding of the unit vectors moves a chord by well under a meter;
+// subtracting this keeps chordLowerBound() a strict lower bound.
+constexpr double CHORD_MARGIN_M = 1.5;
+
+// Great-circle lower bound in meters from unit-vector differences.
+inline double chordLowerBound(float dx, float dy, float dz) {
+    double chord = EARTH_RADIUS_M * std::sqrt(static_cast<double>(dx * dx + dy * dy + dz * dz));
+    return chord > CHORD_MARGIN_M ? chord - CHORD_MARGIN_M : 0.0;
+}
+
+#endif
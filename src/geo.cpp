@@ -0,0 +1,18 @@
+#include "geo.hpp"
+
+#include <cmath>
+
+double haversine(double lat1, double lon1, double lat2, double lon2) {
+    // Returns distance in meters
+    double dLat = deg2rad(lat2 - lat1);
+    double dLon = deg2rad(lon2 - lon1);
+    double a = std::sin(dLat / 2.0) * std::sin(dLat / 2.0) +
+               std::cos(deg2rad(lat1)) * std::cos(deg2rad(lat2)) *
+               std::sin(dLon / 2.0) * std::sin(dLon / 2.0);
+    double c = 2.0 * std::atan2(std::sqrt(a), std::sqrt(1.0 - a));
+    return EARTH_RADIUS_M * c;
+}
+
+double haversine(FixedCoord a, FixedCoord b) {
+    return haversine(toDegrees(a.lat), toDegrees(a.lon), toDegrees(b.lat), toDegrees(b.lon));
+}
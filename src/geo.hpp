@@ -0,0 +1,29 @@
+#ifndef GEO_HPP
+#define GEO_HPP
+
+#include <cmath>
+#include <cstdint>
+
+constexpr double PI_CONST = 3.14159265358979323846;
+constexpr double EARTH_RADIUS_M = 6371000.0; // mean Earth radius in meters
+
+// Fixed-point coordinates in 1e-7 degree units (about 1 cm), the precision
+// osmium::Location stores natively, so nothing is lost converting from OSM.
+constexpr int32_t COORD_SCALE = 10000000;
+
+struct FixedCoord {
+    int32_t lat;
+    int32_t lon;
+};
+
+inline double deg2rad(double deg) { return deg * PI_CONST / 180.0; }
+
+inline int32_t toFixed(double deg) { return static_cast<int32_t>(std::lround(deg * COORD_SCALE)); }
+inline double toDegrees(int32_t fixed) { return fixed / static_cast<double>(COORD_SCALE); }
+inline FixedCoord toFixedCoord(double lat, double lon) { return {toFixed(lat), toFixed(lon)}; }
+
+// Great-circle distance in meters
+double haversine(double lat1, double lon1, double lat2, double lon2);
+double haversine(FixedCoord a, FixedCoord b);
+
+#endif
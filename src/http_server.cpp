@@ -0,0 +1,428 @@
+#include "http_server.hpp"
+
+#include <iostream>
+#include <unordered_map>
+#include <cstring>
+#include <cerrno>
+#include <cctype>
+#include <string_view>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr size_t MAX_HEADER_BYTES = 64 * 1024;
+constexpr size_t MAX_BODY_BYTES = 4 * 1024 * 1024;
+// Unsent response bytes past which a connection is not read or parsed
+// until EPOLLOUT drains them: a client that pipelines requests without
+// reading the answers cannot grow our buffers without bound.
+constexpr size_t MAX_PENDING_OUT_BYTES = 1024 * 1024;
+// Unparsed bytes a connection reads ahead; a whole request (headers, blank
+// line, body) always fits.
+constexpr size_t MAX_PENDING_IN_BYTES = MAX_HEADER_BYTES + 4 + MAX_BODY_BYTES;
+constexpr int EPOLL_BATCH = 256;
+constexpr int EPOLL_TIMEOUT_MS = 200; // how often idle workers re-check the stop flag
+
+struct Connection {
+    std::string in;
+    std::string out;
+    size_t outPos = 0;
+    bool closeAfterWrite = false;
+    bool wantWrite = false;
+    bool readPaused = false;
+
+    bool backlogged() const { return out.size() - outPos > MAX_PENDING_OUT_BYTES; }
+};
+
+const char* statusText(int status) {
+    switch (status) {
+        case 200: return "OK";
+        case 400: return "Bad Request";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 413: return "Payload Too Large";
+        case 431: return "Request Header Fields Too Large";
+        case 500: return "Internal Server Error";
+        case 501: return "Not Implemented";
+        default:  return "Unknown";
+    }
+}
+
+int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+std::string percentDecode(const char* s, size_t n) {
+    std::string out;
+    out.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        if (s[i] == '+') {
+            out.push_back(' ');
+        } else if (s[i] == '%' && i + 2 < n && hexValue(s[i + 1]) >= 0 && hexValue(s[i + 2]) >= 0) {
+            out.push_back(static_cast<char>(hexValue(s[i + 1]) * 16 + hexValue(s[i + 2])));
+            i += 2;
+        } else {
+            out.push_back(s[i]);
+        }
+    }
+    return out;
+}
+
+void parseQuery(std::string_view qs, HttpRequest& req) {
+    size_t pos = 0;
+    while (pos < qs.size()) {
+        size_t amp = qs.find('&', pos);
+        if (amp == std::string_view::npos) amp = qs.size();
+        size_t eq = qs.find('=', pos);
+        if (eq == std::string_view::npos || eq > amp) eq = amp;
+        if (eq > pos) {
+            std::string key = percentDecode(qs.data() + pos, eq - pos);
+            std::string value = eq < amp ? percentDecode(qs.data() + eq + 1, amp - eq - 1) : std::string();
+            req.query.emplace_back(std::move(key), std::move(value));
+        }
+        pos = amp + 1;
+    }
+}
+
+bool iequals(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (std::tolower(static_cast<unsigned char>(a[i])) != std::tolower(static_cast<unsigned char>(b[i]))) return false;
+    }
+    return true;
+}
+
+void appendResponse(std::string& out, const HttpResponse& res, bool keepAlive) {
+    out += "HTTP/1.1 ";
+    out += std::to_string(res.status);
+    out += ' ';
+    out += statusText(res.status);
+    out += "\r\nContent-Type: ";
+    out += res.contentType;
+    out += "\r\nContent-Length: ";
+    out += std::to_string(res.body.size());
+    out += keepAlive ? "\r\nConnection: keep-alive\r\n\r\n" : "\r\nConnection: close\r\n\r\n";
+    out += res.body;
+}
+
+void appendError(std::string& out, int status) {
+    HttpResponse res;
+    res.status = status;
+    res.body = std::string("{\"error\":\"") + statusText(status) + "\"}";
+    appendResponse(out, res, false);
+}
+
+enum class ParseResult { Complete, NeedMore, Error };
+
+// Parses one request from the front of buf. On success, consumed is the number of bytes used.
+ParseResult parseRequest(std::string_view buf, HttpRequest& req, size_t& consumed, int& errorStatus) {
+    size_t headerEnd = buf.find("\r\n\r\n");
+    if (headerEnd == std::string_view::npos) {
+        if (buf.size() > MAX_HEADER_BYTES) { errorStatus = 431; return ParseResult::Error; }
+        return ParseResult::NeedMore;
+    }
+    if (headerEnd > MAX_HEADER_BYTES) { errorStatus = 431; return ParseResult::Error; }
+
+    size_t lineEnd = buf.find("\r\n");
+    size_t sp1 = buf.find(' ');
+    size_t sp2 = sp1 == std::string_view::npos ? std::string_view::npos : buf.find(' ', sp1 + 1);
+    if (sp1 == std::string_view::npos || sp2 == std::string_view::npos || sp2 > lineEnd) {
+        errorStatus = 400;
+        return ParseResult::Error;
+    }
+
+    req.method.assign(buf.substr(0, sp1));
+    req.query.clear();
+    std::string_view target = buf.substr(sp1 + 1, sp2 - sp1 - 1);
+    std::string_view version = buf.substr(sp2 + 1, lineEnd - sp2 - 1);
+    req.keepAlive = version != "HTTP/1.0";
+
+    size_t q = target.find('?');
+    req.path = percentDecode(target.data(), q == std::string_view::npos ? target.size() : q);
+    if (q != std::string_view::npos) parseQuery(target.substr(q + 1), req);
+
+    size_t contentLength = 0;
+    bool haveLength = false;
+    size_t pos = lineEnd + 2;
+    while (pos < headerEnd) {
+        size_t eol = buf.find("\r\n", pos);
+        size_t colon = buf.find(':', pos);
+        if (colon != std::string_view::npos && colon < eol) {
+            size_t vs = colon + 1;
+            while (vs < eol && (buf[vs] == ' ' || buf[vs] == '\t')) ++vs;
+            std::string_view name = buf.substr(pos, colon - pos);
+            std::string_view value = buf.substr(vs, eol - vs);
+            while (!value.empty() && (value.back() == ' ' || value.back() == '\t')) value.remove_suffix(1);
+            if (iequals(name, "content-length")) {
+                // digits only; a repeat must agree, or a proxy in front may
+                // have framed the body differently (request smuggling)
+                size_t length = 0;
+                bool valid = !value.empty() && value.size() <= 19;
+                for (char c : value) {
+                    if (c < '0' || c > '9') valid = false;
+                    else length = length * 10 + static_cast<size_t>(c - '0');
+                }
+                if (!valid || (haveLength && length != contentLength)) {
+                    errorStatus = 400;
+                    return ParseResult::Error;
+                }
+                contentLength = length;
+                haveLength = true;
+            } else if (iequals(name, "transfer-encoding")) {
+                // chunked bodies are not supported; guessing the framing is worse
+                errorStatus = 501;
+                return ParseResult::Error;
+            } else if (iequals(name, "connection")) {
+                if (iequals(value, "close")) req.keepAlive = false;
+                else if (iequals(value, "keep-alive")) req.keepAlive = true;
+            }
+        }
+        pos = eol + 2;
+    }
+
+    if (contentLength > MAX_BODY_BYTES) { errorStatus = 413; return ParseResult::Error; }
+    size_t total = headerEnd + 4 + contentLength;
+    if (buf.size() < total) return ParseResult::NeedMore;
+
+    req.body.assign(buf.substr(headerEnd + 4, contentLength));
+    consumed = total;
+    return ParseResult::Complete;
+}
+
+} // namespace
+
+const std::string* HttpRequest::param(const std::string& key) const {
+    for (const auto& kv : query) {
+        if (kv.first == key) return &kv.second;
+    }
+    return nullptr;
+}
+
+HttpServer::HttpServer(std::string host, uint16_t port, size_t workers, Handler handler)
+    : m_host(std::move(host)), m_port(port), m_workers(workers ? workers : 1), m_handler(std::move(handler)) {}
+
+HttpServer::~HttpServer() {
+    for (int fd : m_listenFds) close(fd);
+}
+
+int HttpServer::openListener() const {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(m_port);
+    if (inet_pton(AF_INET, m_host.c_str(), &addr.sin_addr) != 1) {
+        std::cerr << "Invalid listen address: " << m_host << "\n";
+        close(fd);
+        return -1;
+    }
+
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(fd, 1024) != 0) {
+        std::cerr << "Failed to listen on " << m_host << ":" << m_port << ": " << std::strerror(errno) << "\n";
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+bool HttpServer::run() {
+    for (size_t i = 0; i < m_workers; ++i) {
+        int fd = openListener();
+        if (fd < 0) return false;
+        m_listenFds.push_back(fd);
+    }
+
+    std::clog << "Listening on http://" << m_host << ":" << m_port
+              << " with " << m_workers << " worker(s)\n";
+
+    std::vector<std::thread> threads;
+    threads.reserve(m_workers);
+    for (int fd : m_listenFds) threads.emplace_back(&HttpServer::workerLoop, this, fd);
+    for (auto& t : threads) t.join();
+    return true;
+}
+
+void HttpServer::workerLoop(int listenFd) {
+    int ep = epoll_create1(EPOLL_CLOEXEC);
+    if (ep < 0) {
+        std::cerr << "epoll_create1 failed: " << std::strerror(errno) << "\n";
+        return;
+    }
+
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = listenFd;
+    epoll_ctl(ep, EPOLL_CTL_ADD, listenFd, &ev);
+
+    std::unordered_map<int, Connection> conns;
+    epoll_event events[EPOLL_BATCH];
+    char readBuf[16 * 1024];
+    HttpRequest req;
+    HttpResponse res;
+
+    auto closeConn = [&](int fd) {
+        epoll_ctl(ep, EPOLL_CTL_DEL, fd, nullptr);
+        close(fd);
+        conns.erase(fd);
+    };
+
+    auto updateInterest = [&](int fd, Connection& c, bool wantWrite) {
+        const bool paused = c.backlogged();
+        if (c.wantWrite == wantWrite && c.readPaused == paused) return;
+        c.wantWrite = wantWrite;
+        c.readPaused = paused;
+        epoll_event mod{};
+        mod.events = paused ? 0 : EPOLLIN | EPOLLRDHUP;
+        if (wantWrite) mod.events |= EPOLLOUT;
+        mod.data.fd = fd;
+        epoll_ctl(ep, EPOLL_CTL_MOD, fd, &mod);
+    };
+
+    // Returns false if the connection was closed.
+    auto flush = [&](int fd, Connection& c) {
+        while (c.outPos < c.out.size()) {
+            ssize_t n = send(fd, c.out.data() + c.outPos, c.out.size() - c.outPos, MSG_NOSIGNAL);
+            if (n > 0) {
+                c.outPos += static_cast<size_t>(n);
+            } else if (n < 0 && errno == EINTR) {
+                continue;
+            } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                if (c.outPos >= MAX_PENDING_OUT_BYTES) {
+                    // a slow reader never drains out completely: drop what was sent
+                    c.out.erase(0, c.outPos);
+                    c.outPos = 0;
+                }
+                updateInterest(fd, c, true);
+                return true;
+            } else {
+                closeConn(fd);
+                return false;
+            }
+        }
+        c.out.clear();
+        c.outPos = 0;
+        if (c.closeAfterWrite) {
+            closeConn(fd);
+            return false;
+        }
+        updateInterest(fd, c, false);
+        return true;
+    };
+
+    while (!m_stop.load(std::memory_order_relaxed)) {
+        int n = epoll_wait(ep, events, EPOLL_BATCH, EPOLL_TIMEOUT_MS);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "epoll_wait failed: " << std::strerror(errno) << "\n";
+            break;
+        }
+
+        for (int i = 0; i < n; ++i) {
+            int fd = events[i].data.fd;
+
+            if (fd == listenFd) {
+                for (;;) {
+                    int cfd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                    if (cfd < 0) break; // EAGAIN, or a transient error we retry on the next wakeup
+                    int one = 1;
+                    setsockopt(cfd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+                    epoll_event cev{};
+                    cev.events = EPOLLIN | EPOLLRDHUP;
+                    cev.data.fd = cfd;
+                    epoll_ctl(ep, EPOLL_CTL_ADD, cfd, &cev);
+                    conns[cfd];
+                }
+                continue;
+            }
+
+            auto it = conns.find(fd);
+            if (it == conns.end()) continue;
+            Connection& c = it->second;
+
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                closeConn(fd);
+                continue;
+            }
+
+            if (events[i].events & EPOLLOUT) {
+                if (!flush(fd, c)) continue;
+                // drained: carry on with requests read ahead while paused
+            } else if (!(events[i].events & (EPOLLIN | EPOLLRDHUP))) {
+                continue;
+            }
+
+            bool peerClosed = false;
+            while (!c.backlogged() && c.in.size() < MAX_PENDING_IN_BYTES) {
+                ssize_t r = recv(fd, readBuf, sizeof(readBuf), 0);
+                if (r > 0) {
+                    c.in.append(readBuf, static_cast<size_t>(r));
+                } else if (r == 0) {
+                    peerClosed = true;
+                    break;
+                } else if (errno == EINTR) {
+                    continue;
+                } else {
+                    if (errno != EAGAIN && errno != EWOULDBLOCK) peerClosed = true;
+                    break;
+                }
+            }
+
+            // Answer every complete request in the buffer (pipelining), in order,
+            // sending whenever the answers pass the high-water mark; if the socket
+            // will not take them, EPOLLOUT brings us back to the rest.
+            size_t offset = 0;
+            bool open = true;
+            while (!c.closeAfterWrite) {
+                if (c.backlogged() && (!(open = flush(fd, c)) || c.backlogged())) break;
+                size_t consumed = 0;
+                int errorStatus = 400;
+                std::string_view pending(c.in.data() + offset, c.in.size() - offset);
+                ParseResult pr = parseRequest(pending, req, consumed, errorStatus);
+                if (pr == ParseResult::NeedMore) break;
+                if (pr == ParseResult::Error) {
+                    appendError(c.out, errorStatus);
+                    c.closeAfterWrite = true;
+                    break;
+                }
+                offset += consumed;
+
+                res = HttpResponse();
+                try {
+                    m_handler(req, res);
+                } catch (const std::exception& e) {
+                    res = HttpResponse();
+                    res.status = 500;
+                    res.body = "{\"error\":\"internal\"}";
+                    std::cerr << "Handler error: " << e.what() << "\n";
+                }
+                appendResponse(c.out, res, req.keepAlive);
+                if (!req.keepAlive) c.closeAfterWrite = true;
+            }
+            if (!open) continue;
+            if (offset > 0) c.in.erase(0, offset);
+
+            if (peerClosed && c.out.empty()) {
+                closeConn(fd);
+                continue;
+            }
+            if (peerClosed) c.closeAfterWrite = true;
+            if (!c.out.empty()) flush(fd, c);
+        }
+    }
+
+    for (auto& kv : conns) close(kv.first);
+    close(ep);
+}
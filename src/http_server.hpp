@@ -0,0 +1,59 @@
+#ifndef HTTP_SERVER_HPP
+#define HTTP_SERVER_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+struct HttpRequest {
+    std::string method;
+    std::string path;
+    std::vector<std::pair<std::string, std::string>> query; // percent-decoded
+    std::string body;
+    bool keepAlive = true;
+
+    // Returns nullptr when the parameter is absent.
+    const std::string* param(const std::string& key) const;
+};
+
+struct HttpResponse {
+    int status = 200;
+    std::string contentType = "application/json";
+    std::string body;
+};
+
+// Minimal HTTP/1.1 server: one epoll loop per worker thread, each with its own
+// SO_REUSEPORT listener so the kernel spreads connections and no request ever
+// crosses threads. Supports keep-alive and pipelined requests (responses are
+// queued in request order). The handler runs on the worker thread, so
+// thread_local state in the handler is per-worker state.
+class HttpServer {
+public:
+    using Handler = std::function<void(const HttpRequest&, HttpResponse&)>;
+
+    HttpServer(std::string host, uint16_t port, size_t workers, Handler handler);
+    ~HttpServer();
+
+    // Binds all listeners and blocks until stop() is called. Returns false if binding fails.
+    bool run();
+
+    // Safe to call from a signal handler.
+    void stop() { m_stop.store(true, std::memory_order_relaxed); }
+
+private:
+    std::string m_host;
+    uint16_t m_port;
+    size_t m_workers;
+    Handler m_handler;
+    std::atomic<bool> m_stop{false};
+    std::vector<int> m_listenFds;
+
+    int openListener() const;
+    void workerLoop(int listenFd);
+};
+
+#endif
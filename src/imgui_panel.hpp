@@ -1,6 +1,9 @@
 #ifndef IMGUI_PANEL_HPP
 #define IMGUI_PANEL_HPP
 
+#include <cmath>
+#include <string>
+
 #include "imgui.h"
 #include "windower.hpp"
 
@@ -42,9 +45,26 @@ inline void ShowRouteTracerPanel(Windower& win) {
         ImGui::Spacing();
     }
 
+    if (win.m_route && win.m_routeStart != RoutingGraph::INVALID_NODE) {
+        if (!win.m_route->done()) ImGui::Text("Routing...");
+        else if (std::isinf(win.m_route->cost())) ImGui::Text("No route");
+        else ImGui::Text("Route: %.0f s, %zu nodes expanded", win.m_route->cost() / 10.0, win.m_route->nodesExplored());
+        ImGui::TextDisabled("Drag with the right mouse button to move the end");
+        ImGui::Spacing();
+    }
+
     ImGui::TextColored(ImVec4(0.9f, 0.5f, 0.2f, 1.0f), "🔍 Search Road");
-    ImGui::InputText("Road Name", win.m_searchBuffer, IM_ARRAYSIZE(win.m_searchBuffer));
+    if (ImGui::InputText("Road Name", win.m_searchBuffer, IM_ARRAYSIZE(win.m_searchBuffer))) win.m_searchRequested = true;
     if (ImGui::Button("Search")) win.m_searchRequested = true;
+    if (win.m_searchSession) {
+        const auto& results = win.m_searchSession->results();
+        for (int i = 0; i < static_cast<int>(results.size()); ++i) {
+            const auto& match = results[i];
+            std::string label = std::string(match.name) + "  (" +
+                std::string(highwayName(win.m_map->roads.road(match.road).cls)) + ")##" + std::to_string(i);
+            if (ImGui::Selectable(label.c_str(), win.m_selectedResult == i)) win.selectSearchResult(i);
+        }
+    }
 
     ImGui::TextColored(ImVec4(0.5f, 0.7f, 1.0f, 1.0f), "🎨 Path Color");
     ImGui::ColorEdit3("Path Color", win.m_pathColor);
@@ -0,0 +1,158 @@
+#include "isochrone.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+constexpr double INF = std::numeric_limits<double>::infinity();
+constexpr double METERS_PER_DEGREE = EARTH_RADIUS_M * PI_CONST / 180.0;
+
+// Node costs on a regular lat/lon grid; vertex (row, col) sits at
+// (lat0 + row * dLat, lon0 + col * dLon). The outermost ring of vertices never
+// gets a value, so every contour closes inside the grid.
+struct CostGrid {
+    double lat0, lon0, dLat, dLon;
+    size_t rows, cols;
+    std::vector<double> values;
+
+    double at(size_t r, size_t c) const { return values[r * cols + c]; }
+};
+
+CostGrid splat(const RoutingGraph& graph, const std::vector<double>& costs, double maxLimit, double cellMeters) {
+    CostGrid grid{0, 0, 0, 0, 0, 0, {}};
+    double minLat = INF, maxLat = -INF, minLon = INF, maxLon = -INF;
+    for (RoutingGraph::NodeIndex u = 0; u < costs.size(); ++u) {
+        if (costs[u] > maxLimit) continue;
+        minLat = std::min(minLat, graph.lat(u));
+        maxLat = std::max(maxLat, graph.lat(u));
+        minLon = std::min(minLon, graph.lon(u));
+        maxLon = std::max(maxLon, graph.lon(u));
+    }
+    if (minLat > maxLat) return grid;
+
+    grid.dLat = cellMeters / METERS_PER_DEGREE;
+    grid.dLon = grid.dLat / std::max(0.01, std::cos(deg2rad((minLat + maxLat) / 2.0)));
+    // two cells of padding: nodes touch the corners of their own cell, and the border stays empty
+    grid.lat0 = minLat - 2.0 * grid.dLat;
+    grid.lon0 = minLon - 2.0 * grid.dLon;
+    grid.rows = static_cast<size_t>((maxLat - grid.lat0) / grid.dLat) + 4;
+    grid.cols = static_cast<size_t>((maxLon - grid.lon0) / grid.dLon) + 4;
+    grid.values.assign(grid.rows * grid.cols, INF);
+
+    for (RoutingGraph::NodeIndex u = 0; u < costs.size(); ++u) {
+        if (costs[u] > maxLimit) continue;
+        const size_t r = static_cast<size_t>((graph.lat(u) - grid.lat0) / grid.dLat);
+        const size_t c = static_cast<size_t>((graph.lon(u) - grid.lon0) / grid.dLon);
+        for (size_t dr = 0; dr < 2; ++dr) {
+            for (size_t dc = 0; dc < 2; ++dc) {
+                double& v = grid.values[(r + dr) * grid.cols + c + dc];
+                v = std::min(v, costs[u]);
+            }
+        }
+    }
+    return grid;
+}
+
+// Cell edges are numbered so that neighbouring cells agree: horizontal edge
+// (r, c)-(r, c+1) is 2 * (r * cols + c), vertical edge (r, c)-(r+1, c) is that + 1.
+size_t edgeId(const CostGrid& g, size_t r, size_t c, bool vertical) { return 2 * (r * g.cols + c) + vertical; }
+
+FixedCoord crossing(const CostGrid& g, size_t edge, double limit) {
+    const size_t vertex = edge / 2;
+    const size_t r = vertex / g.cols, c = vertex % g.cols;
+    const bool vertical = edge & 1;
+    const double a = g.at(r, c);
+    const double b = vertical ? g.at(r + 1, c) : g.at(r, c + 1);
+    // where the cost along the edge reaches the limit; halfway next to an unreached vertex
+    double t = 0.5;
+    if (a != INF && b != INF && a != b) t = std::min(1.0, std::max(0.0, (limit - a) / (b - a)));
+    const double lat = g.lat0 + (r + (vertical ? t : 0.0)) * g.dLat;
+    const double lon = g.lon0 + (c + (vertical ? 0.0 : t)) * g.dLon;
+    return toFixedCoord(lat, lon);
+}
+
+std::vector<std::vector<FixedCoord>> contour(const CostGrid& g, double limit) {
+    // one segment per cell side pair the limit crosses, as edge ids
+    std::vector<std::pair<size_t, size_t>> segments;
+    for (size_t r = 0; r + 1 < g.rows; ++r) {
+        for (size_t c = 0; c + 1 < g.cols; ++c) {
+            const bool in00 = g.at(r, c) <= limit, in01 = g.at(r, c + 1) <= limit;
+            const bool in11 = g.at(r + 1, c + 1) <= limit, in10 = g.at(r + 1, c) <= limit;
+            const int mask = in00 | (in01 << 1) | (in11 << 2) | (in10 << 3);
+            if (mask == 0 || mask == 15) continue;
+
+            const size_t bottom = edgeId(g, r, c, false), top = edgeId(g, r + 1, c, false);
+            const size_t left = edgeId(g, r, c, true), right = edgeId(g, r, c + 1, true);
+            switch (mask) {
+                case 1: case 14: segments.push_back({left, bottom}); break;
+                case 2: case 13: segments.push_back({bottom, right}); break;
+                case 3: case 12: segments.push_back({left, right}); break;
+                case 4: case 11: segments.push_back({right, top}); break;
+                case 6: case 9: segments.push_back({bottom, top}); break;
+                case 7: case 8: segments.push_back({left, top}); break;
+                // saddles: keep the two reached corners apart
+                case 5:
+                    segments.push_back({left, bottom});
+                    segments.push_back({right, top});
+                    break;
+                case 10:
+                    segments.push_back({bottom, right});
+                    segments.push_back({left, top});
+                    break;
+            }
+        }
+    }
+
+    // every crossed edge borders exactly two cells, so segments chain into rings
+    std::vector<std::pair<size_t, uint32_t>> ends; // (edge id, segment)
+    ends.reserve(segments.size() * 2);
+    for (uint32_t i = 0; i < segments.size(); ++i) {
+        ends.push_back({segments[i].first, i});
+        ends.push_back({segments[i].second, i});
+    }
+    std::sort(ends.begin(), ends.end());
+    auto otherSegment = [&](size_t edge, uint32_t from) {
+        auto it = std::lower_bound(ends.begin(), ends.end(), std::make_pair(edge, uint32_t(0)));
+        for (; it != ends.end() && it->first == edge; ++it) {
+            if (it->second != from) return it->second;
+        }
+        return from;
+    };
+
+    std::vector<std::vector<FixedCoord>> rings;
+    std::vector<bool> used(segments.size(), false);
+    for (uint32_t first = 0; first < segments.size(); ++first) {
+        if (used[first]) continue;
+        std::vector<FixedCoord> ring{crossing(g, segments[first].first, limit)};
+        uint32_t seg = first;
+        size_t edge = segments[first].first;
+        while (!used[seg]) {
+            used[seg] = true;
+            edge = segments[seg].first == edge ? segments[seg].second : segments[seg].first;
+            ring.push_back(crossing(g, edge, limit));
+            seg = otherSegment(edge, seg);
+        }
+        rings.push_back(std::move(ring));
+    }
+    return rings;
+}
+
+} // namespace
+
+std::vector<Isochrone> traceIsochrones(const RoutingGraph& graph, const std::vector<double>& costs,
+                                       const std::vector<double>& limits, double cellMeters) {
+    std::vector<Isochrone> result;
+    if (limits.empty() || cellMeters <= 0.0) return result;
+    const double maxLimit = *std::max_element(limits.begin(), limits.end());
+    const CostGrid grid = splat(graph, costs, maxLimit, cellMeters);
+
+    for (double limit : limits) {
+        Isochrone iso{limit, 0, {}};
+        for (double c : costs) iso.reachedNodes += c <= limit;
+        if (!grid.values.empty()) iso.lines = contour(grid, limit);
+        result.push_back(std::move(iso));
+    }
+    return result;
+}
@@ -0,0 +1,25 @@
+#ifndef ISOCHRONE_HPP
+#define ISOCHRONE_HPP
+
+#include <vector>
+
+#include "geo.hpp"
+#include "routing_graph.hpp"
+
+// Boundary of everything within one cost limit of the sources of a oneToAll()
+// run. Lines are closed rings (first point repeated at the end); islands of
+// reachable road and unreachable holes each get their own ring.
+struct Isochrone {
+    double limit;       // search cost: meters or deciseconds
+    size_t reachedNodes;
+    std::vector<std::vector<FixedCoord>> lines;
+};
+
+// Traces one Isochrone per limit. Reached nodes are spread onto a grid of
+// cellMeters cells (each node lowers the four corners of its cell) and
+// marching squares follows where the grid crosses the limit, so gaps between
+// roads narrower than a cell are filled in.
+std::vector<Isochrone> traceIsochrones(const RoutingGraph& graph, const std::vector<double>& costs,
+                                       const std::vector<double>& limits, double cellMeters = 150.0);
+
+#endif
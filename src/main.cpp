@@ -3,6 +3,7 @@
 #include <GLFW/glfw3.h>
 
 #include "map_data.hpp"
+#include "road_search.hpp"
 #include "a_star.hpp"
 
 #include "windower.hpp"
@@ -16,7 +17,8 @@ int main(void)
 
     Renderer renderer;
 
-    Map map = parseMap("res/data/karachi.osm.pbf");
+    std::shared_ptr<const RoutingGraph> graph;
+    Map map = parseMap("res/data/karachi.osm.pbf", &graph);
     
     if (!map.vertices.empty() && !map.indices.empty()) {
         renderer.setVertices(map.vertices);
@@ -28,6 +30,9 @@ int main(void)
     }
 
     Windower windower(renderer, 800, 640);
+    RoadSearchIndex roadSearch(map.roads);
+    windower.setRoadSearch(map, roadSearch);
+    if (graph) windower.setRouting(map, *graph);
     windower.run();
 
 }
\ No newline at end of file
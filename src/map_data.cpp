@@ -1,4 +1,8 @@
 #include "map_data.hpp"
+#include "osm_graph_handler.hpp"
+#include "geo.hpp"
+#include "osm_tags.hpp"
+#include "road_catalog.hpp"
 
 // Map_Data.cpp (modified to include node lat/lon output)
 
@@ -13,66 +17,180 @@
 #include <osmium/osm/way.hpp>
 #include <unordered_set>
 #include <unordered_map>
+#include <memory_resource>
 #include <chrono>
 #include <iomanip>
 #include <sstream>
 #include <limits>
 #include <cmath>
 #include <algorithm>
+#include <cstring>
+#include <thread>
+
+namespace {
+
+constexpr size_t PARALLEL_MIN_ITEMS = 1 << 16;
+constexpr size_t HISTOGRAM_BINS = 4096;
+
+size_t chunkCount(size_t n) {
+    if (n < PARALLEL_MIN_ITEMS) return 1;
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Runs body(begin, end, chunk) on chunkCount(n) contiguous slices of [0, n), one thread each.
+template <typename Body>
+void parallelChunks(size_t n, Body body) {
+    const size_t chunks = chunkCount(n);
+    const size_t step = (n + chunks - 1) / chunks;
+    std::vector<std::thread> workers;
+    for (size_t c = 1; c < chunks; ++c) {
+        size_t begin = std::min(n, c * step), end = std::min(n, begin + step);
+        workers.emplace_back(body, begin, end, c);
+    }
+    body(0, std::min(n, step), size_t(0));
+    for (auto& w : workers) w.join();
+}
+
+// Web Mercator (x = lon, y = ln(tan(pi/4 + lat/2))) in radians, written straight
+// into the x/y slots of the interleaved xyz vertex array.
+void projectVertices(const std::vector<FixedCoord>& coords, std::vector<float>& vertices) {
+    vertices.assign(coords.size() * 3, 0.0f);
+    parallelChunks(coords.size(), [&](size_t begin, size_t end, size_t) {
+        const double deg2rad = M_PI / 180.0;
+        for (size_t i = begin; i < end; ++i) {
+            double lon_rad = toDegrees(coords[i].lon) * deg2rad;
+            double sin_lat = std::sin(toDegrees(coords[i].lat) * deg2rad);
+            vertices[i * 3 + 0] = static_cast<float>(lon_rad);
+            vertices[i * 3 + 1] = static_cast<float>(0.5 * std::log((1.0 + sin_lat) / (1.0 - sin_lat)));
+        }
+    });
+}
+
+// Exact p-quantiles (index floor(p * (n - 1)) of the sorted values, like
+// nth_element) of the x and y columns of an xyz vertex array, without copying it:
+// one parallel min/max pass, one parallel histogram pass, then nth_element only
+// over the few values that share a bin with the wanted rank.
+void axisPercentiles(const std::vector<float>& vertices, double pLo, double pHi,
+                     float& xLo, float& xHi, float& yLo, float& yHi) {
+    const size_t n = vertices.size() / 3;
+    const size_t chunks = chunkCount(n);
+
+    std::vector<float> minV(chunks * 2, std::numeric_limits<float>::max());
+    std::vector<float> maxV(chunks * 2, std::numeric_limits<float>::lowest());
+    parallelChunks(n, [&](size_t begin, size_t end, size_t c) {
+        for (size_t i = begin; i < end; ++i) {
+            for (size_t axis = 0; axis < 2; ++axis) {
+                float v = vertices[i * 3 + axis];
+                minV[c * 2 + axis] = std::min(minV[c * 2 + axis], v);
+                maxV[c * 2 + axis] = std::max(maxV[c * 2 + axis], v);
+            }
+        }
+    });
+    float lo[2], hi[2], scale[2];
+    for (size_t axis = 0; axis < 2; ++axis) {
+        lo[axis] = minV[axis];
+        hi[axis] = maxV[axis];
+        for (size_t c = 1; c < chunks; ++c) {
+            lo[axis] = std::min(lo[axis], minV[c * 2 + axis]);
+            hi[axis] = std::max(hi[axis], maxV[c * 2 + axis]);
+        }
+        scale[axis] = hi[axis] > lo[axis] ? HISTOGRAM_BINS / (hi[axis] - lo[axis]) : 0.0f;
+    }
+    auto binOf = [&](size_t axis, float v) {
+        return std::min(HISTOGRAM_BINS - 1, static_cast<size_t>((v - lo[axis]) * scale[axis]));
+    };
+
+    std::vector<uint32_t> counts(chunks * 2 * HISTOGRAM_BINS, 0);
+    parallelChunks(n, [&](size_t begin, size_t end, size_t c) {
+        uint32_t* local = counts.data() + c * 2 * HISTOGRAM_BINS;
+        for (size_t i = begin; i < end; ++i) {
+            ++local[binOf(0, vertices[i * 3 + 0])];
+            ++local[HISTOGRAM_BINS + binOf(1, vertices[i * 3 + 1])];
+        }
+    });
+
+    // which bin holds rank k, and k's position inside that bin
+    auto locate = [&](size_t axis, size_t k, size_t& bin, size_t& rank) {
+        size_t before = 0;
+        for (bin = 0; bin < HISTOGRAM_BINS; ++bin) {
+            size_t inBin = 0;
+            for (size_t c = 0; c < chunks; ++c) inBin += counts[(c * 2 + axis) * HISTOGRAM_BINS + bin];
+            if (k < before + inBin) break;
+            before += inBin;
+        }
+        rank = k - before;
+    };
+
+    const size_t ranks[2] = {
+        static_cast<size_t>(std::floor(pLo * (n - 1))),
+        static_cast<size_t>(std::floor(pHi * (n - 1)))
+    };
+    float* results[2][2] = {{&xLo, &xHi}, {&yLo, &yHi}};
+    for (size_t axis = 0; axis < 2; ++axis) {
+        for (size_t r = 0; r < 2; ++r) {
+            size_t bin, rank;
+            locate(axis, ranks[r], bin, rank);
+            std::vector<float> members;
+            for (size_t i = 0; i < n; ++i) {
+                float v = vertices[i * 3 + axis];
+                if (binOf(axis, v) == bin) members.push_back(v);
+            }
+            std::nth_element(members.begin(), members.begin() + rank, members.end());
+            *results[axis][r] = members[rank];
+        }
+    }
+}
 
-struct Road {
-    std::string name;
-    std::string type;
-    std::vector<std::vector<osmium::object_id_type>> segments; // Each "Way" is one segment
-};
+} // namespace
 
 class MyHandler : public osmium::handler::Handler {
 public:
-    std::map<std::pair<std::string, std::string>, Road> mergedRoads;
-    std::unordered_map<osmium::object_id_type, std::pair<double, double>> node_coords;
+    RoadCatalog roads; // named major roads; each way is one segment
+    // every node of the file, kept until parsing is done: arena-backed instead
+    // of one heap allocation each
+    std::pmr::monotonic_buffer_resource node_arena;
+    std::pmr::unordered_map<osmium::object_id_type, FixedCoord> node_coords{&node_arena};
 
     void node(const osmium::Node& node) {
         if (node.location().valid()) {
-            node_coords[node.id()] = { node.location().lat(), node.location().lon() };
+            node_coords[node.id()] = { node.location().y(), node.location().x() };
         }
     }
 
     void way(const osmium::Way& way) {
-        const char* highway = way.tags()["highway"];
+        const HighwayClass cls = classifyHighway(way.tags()["highway"]);
         const char* name = way.tags()["name"];
 
-        static const std::unordered_set<std::string> major_roads = {
-            "motorway", "trunk", "primary", "secondary", "tertiary"
-        };
-
-        if (highway && name && major_roads.count(highway)) {
-            std::pair<std::string, std::string> key(name, highway);
-
-            std::vector<osmium::object_id_type> nodes;
+        if (name && isMajorRoad(cls)) {
+            RoadCatalog::RoadId road = roads.road(name, cls);
+            roads.beginSegment(road);
             for (const auto& node_ref : way.nodes()) {
-                nodes.push_back(node_ref.ref());
+                roads.appendNode(node_ref.ref());
             }
 
-            auto& road = mergedRoads[key];
-            if (road.name.empty()) {
-                road.name = name;
-                road.type = highway;
+            // name:ur, name:en, alt_name, ... so the search box finds every spelling
+            for (const auto& tag : way.tags()) {
+                const char* key = tag.key();
+                if (std::strncmp(key, "name:", 5) == 0 || std::strcmp(key, "alt_name") == 0 ||
+                    std::strcmp(key, "old_name") == 0 || std::strcmp(key, "official_name") == 0 ||
+                    std::strcmp(key, "short_name") == 0) {
+                    roads.addAlias(road, tag.value());
+                }
             }
-            road.segments.push_back(nodes);
         }
     }
 
     void printMergedData(std::ostream& out) const {
-        for (const auto& entry : mergedRoads) {
-            const auto& road = entry.second;
+        for (RoadCatalog::RoadId r = 0; r < roads.roadCount(); ++r) {
+            const auto& road = roads.road(r);
 
-            out << "Road: " << road.name
-                << " | Type: " << road.type
-                << " | Segments: " << road.segments.size()
+            out << "Road: " << roads.name(r)
+                << " | Type: " << highwayName(road.cls)
+                << " | Segments: " << road.segmentCount
                 << "\n";
 
-            for (size_t i = 0; i < road.segments.size(); ++i) {
-                const auto& seg = road.segments[i];
+            for (size_t i = 0; i < road.segmentCount; ++i) {
+                const auto seg = roads.segment(r, i);
                 if (!seg.empty()) {
                     out << "  Segment " << (i + 1)
                         << " → Nodes: " << seg.front()
@@ -83,7 +201,7 @@ public:
                         auto it = node_coords.find(nid);
                         if (it != node_coords.end()) {
                             out << "     Node " << nid << " [lat: " << std::fixed << std::setprecision(7)
-                                << it->second.first << ", lon: " << it->second.second << "]\n";
+                                << toDegrees(it->second.lat) << ", lon: " << toDegrees(it->second.lon) << "]\n";
                         } else {
                             out << "     Node " << nid << " [lat/lon: unknown]\n";
                         }
@@ -105,7 +223,7 @@ public:
                             auto it = node_coords.find(nid);
                             if (it != node_coords.end()) {
                                 out << "       " << nid << " [lat: " << std::fixed << std::setprecision(7)
-                                    << it->second.first << ", lon: " << it->second.second << "]\n";
+                                    << toDegrees(it->second.lat) << ", lon: " << toDegrees(it->second.lon) << "]\n";
                             } else {
                                 out << "       " << nid << " [lat/lon: unknown]\n";
                             }
@@ -118,7 +236,7 @@ public:
     }
 };
 
-Map parseMap(const std::string& filepath) {
+Map parseMap(const std::string& filepath, std::shared_ptr<const RoutingGraph>* graph) {
     const std::string input_file = "res/data/karachi.osm.pbf";
     Map out;
 
@@ -126,43 +244,43 @@ Map parseMap(const std::string& filepath) {
         osmium::io::Reader reader(input_file);
         MyHandler handler;
 
-        osmium::apply(reader, handler);
+        if (graph) {
+            // one pass for both: decoding the file is most of the load time
+            OsmGraphHandler routing;
+            osmium::apply(reader, handler, routing);
+            *graph = routing.finish();
+        } else {
+            osmium::apply(reader, handler);
+        }
         reader.close();
+        handler.roads.finalize();
+        handler.roads.stitchSegments();
 
         if (handler.node_coords.empty()) {
             std::cerr << "No node coordinates parsed from map file.\n";
             return out;
         }
 
-        // Compute bounding box
-        double minLat = std::numeric_limits<double>::max();
-        double maxLat = std::numeric_limits<double>::lowest();
-        double minLon = std::numeric_limits<double>::max();
-        double maxLon = std::numeric_limits<double>::lowest();
-
-        for (const auto& kv : handler.node_coords) {
-            double lat = kv.second.first;
-            double lon = kv.second.second;
-            minLat = std::min(minLat, lat);
-            maxLat = std::max(maxLat, lat);
-            minLon = std::min(minLon, lon);
-            maxLon = std::max(maxLon, lon);
-        }
-
-        double latRange = (maxLat - minLat);
-        double lonRange = (maxLon - minLon);
-        if (latRange == 0) latRange = 1.0;
-        if (lonRange == 0) lonRange = 1.0;
-
         // Map node id -> vertex index
         std::unordered_map<osmium::object_id_type, unsigned int> node_index;
+        // coordinates of each vertex, projected in bulk once every segment is collected
+        std::vector<FixedCoord> vertex_coords;
+        // candidate segments into out.indices, filtered after projection
+        struct Candidate {
+            size_t offset;
+            size_t count;
+            RoadCatalog::RoadId road;
+        };
+        std::vector<Candidate> candidates;
 
         // Build vertices and indices (line segments)
-        for (const auto& entry : handler.mergedRoads) {
-            const auto& road = entry.second;
-            for (const auto& seg : road.segments) {
+        for (RoadCatalog::RoadId r = 0; r < handler.roads.roadCount(); ++r) {
+            for (size_t s = 0; s < handler.roads.road(r).segmentCount; ++s) {
+                const auto seg = handler.roads.segment(r, s);
                 if (seg.size() < 2) continue;
 
+                // Add indices for this segment as a contiguous run so we can draw GL_LINE_STRIP per segment
+                size_t startOffset = out.indices.size();
                 for (size_t i = 0; i < seg.size(); ++i) {
                     osmium::object_id_type nid = seg[i];
                     auto it = node_index.find(nid);
@@ -170,53 +288,15 @@ Map parseMap(const std::string& filepath) {
                         auto coordIt = handler.node_coords.find(nid);
                         if (coordIt == handler.node_coords.end()) continue; // skip unknown nodes
 
-                        double lat = coordIt->second.first;
-                        double lon = coordIt->second.second;
-
-                        // Project to Web Mercator for better visual layout
-                        const double deg2rad = M_PI / 180.0;
-                        double lon_rad = lon * deg2rad;
-                        double lat_rad = lat * deg2rad;
-
-                        // Web Mercator projection (x = lon, y = ln(tan(pi/4 + lat/2)))
-                        double x_merc = lon_rad;
-                        double y_merc = 0.5 * std::log((1.0 + std::sin(lat_rad)) / (1.0 - std::sin(lat_rad)));
-
-                        float z = 0.0f;
-
-                        // store mercator coords temporarily in vertices for later normalization
-                        unsigned int idx = static_cast<unsigned int>(out.vertices.size() / 3);
-                        out.vertices.push_back(static_cast<float>(x_merc));
-                        out.vertices.push_back(static_cast<float>(y_merc));
-                        out.vertices.push_back(z);
-
-                        node_index[nid] = idx;
+                        unsigned int idx = static_cast<unsigned int>(vertex_coords.size());
+                        vertex_coords.push_back(coordIt->second);
+                        it = node_index.emplace(nid, idx).first;
                     }
+                    out.indices.push_back(it->second);
                 }
-
-                // Add indices for this segment as a contiguous run so we can draw GL_LINE_STRIP per segment
-                size_t startOffset = out.indices.size();
-                size_t added = 0;
-                for (size_t i = 0; i < seg.size(); ++i) {
-                    auto itIdx = node_index.find(seg[i]);
-                    if (itIdx == node_index.end()) continue;
-                    out.indices.push_back(itIdx->second);
-                    ++added;
-                }
+                size_t added = out.indices.size() - startOffset;
                 if (added >= 2) {
-                    // compute approx segment extent to filter tiny segments
-                    float x0 = out.vertices[out.indices[startOffset] * 3 + 0];
-                    float y0 = out.vertices[out.indices[startOffset] * 3 + 1];
-                    float x1 = out.vertices[out.indices[startOffset + added - 1] * 3 + 0];
-                    float y1 = out.vertices[out.indices[startOffset + added - 1] * 3 + 1];
-                    float extent = std::hypot(x1 - x0, y1 - y0);
-                    const float MIN_SEG_EXTENT = 1e-6f; // filter threshold (in mercator units)
-                    if (extent >= MIN_SEG_EXTENT) {
-                        out.segmentOffsets.push_back(startOffset);
-                        out.segmentLengths.push_back(added);
-                    } else {
-                        out.indices.resize(startOffset);
-                    }
+                    candidates.push_back({startOffset, added, r});
                 } else {
                     // rollback if segment has fewer than 2 valid points
                     out.indices.resize(startOffset);
@@ -224,33 +304,47 @@ Map parseMap(const std::string& filepath) {
             }
         }
 
-        std::cout << "Parsed map: vertices=" << (out.vertices.size()/3) << " indices=" << out.indices.size() << "\n";
+        projectVertices(vertex_coords, out.vertices);
+
+        // drop tiny segments (bounding box diagonal), compacting indices in place; the
+        // end points alone would drop stitched chains that close on themselves
+        const float MIN_SEG_EXTENT = 1e-6f; // filter threshold (in mercator units)
+        // candidates come in road order, so each road's drawn segments stay contiguous
+        out.roadSegments.assign(handler.roads.roadCount() + 1, 0);
+        size_t kept = 0;
+        for (const auto& c : candidates) {
+            float minX = std::numeric_limits<float>::max(), minY = minX;
+            float maxX = std::numeric_limits<float>::lowest(), maxY = maxX;
+            for (size_t k = c.offset; k < c.offset + c.count; ++k) {
+                const float* v = &out.vertices[out.indices[k] * 3];
+                minX = std::min(minX, v[0]);
+                maxX = std::max(maxX, v[0]);
+                minY = std::min(minY, v[1]);
+                maxY = std::max(maxY, v[1]);
+            }
+            float extent = std::hypot(maxX - minX, maxY - minY);
+            if (extent < MIN_SEG_EXTENT) continue;
+            std::copy(out.indices.begin() + c.offset, out.indices.begin() + c.offset + c.count,
+                      out.indices.begin() + kept);
+            out.segmentOffsets.push_back(kept);
+            out.segmentLengths.push_back(c.count);
+            ++out.roadSegments[c.road + 1];
+            kept += c.count;
+        }
+        out.indices.resize(kept);
+        for (size_t r = 0; r < handler.roads.roadCount(); ++r) out.roadSegments[r + 1] += out.roadSegments[r];
+
+        std::cout << "Parsed map: vertices=" << (out.vertices.size()/3) << " indices=" << out.indices.size()
+                  << " segments=" << out.segmentOffsets.size()
+                  << " roads=" << handler.roads.roadCount()
+                  << " (" << handler.roads.memoryBytes() / 1024 << " KiB road catalog)\n";
+        out.roads = std::move(handler.roads);
 
         // Normalize mercator coordinates to NDC [-1,1] while preserving aspect ratio
         if (!out.vertices.empty()) {
-            // collect coordinates
-            std::vector<float> xs;
-            std::vector<float> ys;
-            xs.reserve(out.vertices.size() / 3);
-            ys.reserve(out.vertices.size() / 3);
-            for (size_t i = 0; i < out.vertices.size(); i += 3) {
-                xs.push_back(out.vertices[i]);
-                ys.push_back(out.vertices[i+1]);
-            }
-
             // compute robust percentiles (5%-95%) to ignore outliers
-            auto percentile = [&](std::vector<float>& v, double p) {
-                if (v.empty()) return 0.0f;
-                size_t idx = static_cast<size_t>(std::floor(p * (v.size() - 1)));
-                std::vector<float> tmp = v;
-                std::nth_element(tmp.begin(), tmp.begin() + idx, tmp.end());
-                return tmp[idx];
-            };
-
-            float x_lo = percentile(xs, 0.05);
-            float x_hi = percentile(xs, 0.95);
-            float y_lo = percentile(ys, 0.05);
-            float y_hi = percentile(ys, 0.95);
+            float x_lo, x_hi, y_lo, y_hi;
+            axisPercentiles(out.vertices, 0.05, 0.95, x_lo, x_hi, y_lo, y_hi);
 
             float midX = (x_lo + x_hi) * 0.5f;
             float midY = (y_lo + y_hi) * 0.5f;
@@ -258,23 +352,39 @@ Map parseMap(const std::string& filepath) {
             float rangeY = y_hi - y_lo;
             float scale = std::max(rangeX, rangeY);
             if (scale == 0.0f) scale = 1.0f;
+            out.viewMidX = midX;
+            out.viewMidY = midY;
+            out.viewScale = scale;
 
             // normalize to [-1,1]
-            for (size_t i = 0; i < out.vertices.size(); i += 3) {
-                float x = out.vertices[i];
-                float y = out.vertices[i+1];
-                float nx = (x - midX) * (2.0f / scale);
-                float ny = (y - midY) * (2.0f / scale);
-                out.vertices[i] = nx;
-                out.vertices[i+1] = ny;
-            }
+            parallelChunks(out.vertices.size() / 3, [&](size_t begin, size_t end, size_t) {
+                for (size_t i = begin * 3; i < end * 3; i += 3) {
+                    out.vertices[i] = (out.vertices[i] - midX) * (2.0f / scale);
+                    out.vertices[i+1] = (out.vertices[i+1] - midY) * (2.0f / scale);
+                }
+            });
         }
 
-        
-
     } catch (const std::exception& e) {
         std::cerr << "ERROR: " << e.what() << "\n";
     }
 
     return out;
+}
+
+void toViewCoords(const Map& map, double lat, double lon, float& x, float& y) {
+    const double deg2rad = M_PI / 180.0;
+    const double sinLat = std::sin(lat * deg2rad);
+    const float mx = static_cast<float>(lon * deg2rad);
+    const float my = static_cast<float>(0.5 * std::log((1.0 + sinLat) / (1.0 - sinLat)));
+    x = (mx - map.viewMidX) * (2.0f / map.viewScale);
+    y = (my - map.viewMidY) * (2.0f / map.viewScale);
+}
+
+void fromViewCoords(const Map& map, float x, float y, double& lat, double& lon) {
+    const double rad2deg = 180.0 / M_PI;
+    const double mx = x * (map.viewScale / 2.0) + map.viewMidX;
+    const double my = y * (map.viewScale / 2.0) + map.viewMidY;
+    lon = mx * rad2deg;
+    lat = std::atan(std::sinh(my)) * rad2deg;
 }
\ No newline at end of file
@@ -15,13 +15,33 @@
 #include <iomanip>
 #include <sstream>
 
+#include "road_catalog.hpp"
+#include "routing_graph.hpp"
+
 struct Map {
 	std::vector<float> vertices;
 	std::vector<unsigned int> indices;
 	std::vector<size_t> segmentOffsets;
 	std::vector<size_t> segmentLengths;
+
+	// named roads; the drawn segments of road r are
+	// segmentOffsets[roadSegments[r]] .. segmentOffsets[roadSegments[r + 1] - 1]
+	RoadCatalog roads;
+	std::vector<size_t> roadSegments;
+
+	// vertices are ((mercator - mid) * 2 / scale), see toViewCoords()
+	float viewMidX = 0.0f;
+	float viewMidY = 0.0f;
+	float viewScale = 1.0f;
 };
 
-Map parseMap(const std::string& filepath);
+// Also builds the RoutingGraph into *graph from the same pass over the file,
+// when given (nullptr on read errors).
+Map parseMap(const std::string& filepath, std::shared_ptr<const RoutingGraph>* graph = nullptr);
+
+// Position of (lat, lon) in the same normalized space as map.vertices, for overlays.
+void toViewCoords(const Map& map, double lat, double lon, float& x, float& y);
+// Inverse of toViewCoords(), e.g. for the map position under the mouse.
+void fromViewCoords(const Map& map, float x, float y, double& lat, double& lon);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,37 @@
+#ifndef OSM_GRAPH_HANDLER_HPP
+#define OSM_GRAPH_HANDLER_HPP
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+#include <osmium/handler.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/way.hpp>
+
+#include "geo.hpp"
+#include "routing_graph.hpp"
+
+// The osmium handler RoutingGraph::fromOsm() reads a file with. Callers that
+// read the file for something else anyway (parseMap()) pass it alongside
+// their own handler to osmium::apply(), then call finish().
+class OsmGraphHandler : public osmium::handler::Handler {
+public:
+    void node(const osmium::Node& node);
+    void way(const osmium::Way& way);
+    void relation(const osmium::Relation& rel);
+
+    // Builds the graph from everything seen so far and logs a summary.
+    std::shared_ptr<const RoutingGraph> finish();
+
+private:
+    RoutingGraph::Builder m_builder;
+    // per-way scratch: consecutive node pairs and their lengths, measured in one batch
+    std::vector<std::pair<int64_t, int64_t>> m_segmentIds;
+    std::vector<FixedCoord> m_segmentFrom;
+    std::vector<FixedCoord> m_segmentTo;
+    std::vector<double> m_segmentLengths;
+};
+
+#endif
@@ -0,0 +1,144 @@
+#ifndef OSM_TAGS_HPP
+#define OSM_TAGS_HPP
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+// Allocation-free classification of the OSM tag values the ingest handlers
+// look at. Raw const char* values from osmium map to enums through sorted
+// constexpr tables; nothing here builds a std::string.
+
+enum class HighwayClass : uint8_t {
+    None, // no highway tag
+    Other, // a highway value we do not know
+    Motorway, Trunk, Primary, Secondary, Tertiary, Unclassified, Residential,
+    Service, LivingStreet, MotorwayLink, TrunkLink, PrimaryLink, SecondaryLink, TertiaryLink,
+    Footway, Path, Cycleway, Steps, Pedestrian, Track, Bridleway, Corridor
+};
+
+namespace osm_tags_detail {
+
+struct HighwayEntry {
+    std::string_view value;
+    HighwayClass cls;
+};
+
+// sorted by value for binary search (checked below)
+constexpr std::array<HighwayEntry, 22> HIGHWAY_TABLE = {{
+    {"bridleway", HighwayClass::Bridleway},
+    {"corridor", HighwayClass::Corridor},
+    {"cycleway", HighwayClass::Cycleway},
+    {"footway", HighwayClass::Footway},
+    {"living_street", HighwayClass::LivingStreet},
+    {"motorway", HighwayClass::Motorway},
+    {"motorway_link", HighwayClass::MotorwayLink},
+    {"path", HighwayClass::Path},
+    {"pedestrian", HighwayClass::Pedestrian},
+    {"primary", HighwayClass::Primary},
+    {"primary_link", HighwayClass::PrimaryLink},
+    {"residential", HighwayClass::Residential},
+    {"secondary", HighwayClass::Secondary},
+    {"secondary_link", HighwayClass::SecondaryLink},
+    {"service", HighwayClass::Service},
+    {"steps", HighwayClass::Steps},
+    {"tertiary", HighwayClass::Tertiary},
+    {"tertiary_link", HighwayClass::TertiaryLink},
+    {"track", HighwayClass::Track},
+    {"trunk", HighwayClass::Trunk},
+    {"trunk_link", HighwayClass::TrunkLink},
+    {"unclassified", HighwayClass::Unclassified},
+}};
+
+constexpr bool isSorted() {
+    for (size_t i = 1; i < HIGHWAY_TABLE.size(); ++i) {
+        if (!(HIGHWAY_TABLE[i - 1].value < HIGHWAY_TABLE[i].value)) return false;
+    }
+    return true;
+}
+static_assert(isSorted(), "HIGHWAY_TABLE must be sorted by value");
+
+} // namespace osm_tags_detail
+
+constexpr HighwayClass classifyHighway(const char* value) {
+    if (!value) return HighwayClass::None;
+    const std::string_view v(value);
+    size_t lo = 0, hi = osm_tags_detail::HIGHWAY_TABLE.size();
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        int c = osm_tags_detail::HIGHWAY_TABLE[mid].value.compare(v);
+        if (c == 0) return osm_tags_detail::HIGHWAY_TABLE[mid].cls;
+        if (c < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    return HighwayClass::Other;
+}
+static_assert(classifyHighway("residential") == HighwayClass::Residential, "lookup");
+static_assert(classifyHighway("motorway_junction") == HighwayClass::Other, "lookup");
+
+// Highway value as it appears in OSM; "" for None / Other.
+constexpr std::string_view highwayName(HighwayClass cls) {
+    for (const auto& e : osm_tags_detail::HIGHWAY_TABLE) {
+        if (e.cls == cls) return e.value;
+    }
+    return {};
+}
+
+// Classes used for motor vehicle routing (trunk_link is left out, as before).
+constexpr bool isDrivable(HighwayClass cls) {
+    switch (cls) {
+        case HighwayClass::Motorway: case HighwayClass::Trunk: case HighwayClass::Primary:
+        case HighwayClass::Secondary: case HighwayClass::Tertiary: case HighwayClass::Unclassified:
+        case HighwayClass::Residential: case HighwayClass::Service: case HighwayClass::LivingStreet:
+        case HighwayClass::MotorwayLink: case HighwayClass::PrimaryLink:
+        case HighwayClass::SecondaryLink: case HighwayClass::TertiaryLink:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Classes the viewer draws as named roads.
+constexpr bool isMajorRoad(HighwayClass cls) {
+    return cls == HighwayClass::Motorway || cls == HighwayClass::Trunk || cls == HighwayClass::Primary ||
+           cls == HighwayClass::Secondary || cls == HighwayClass::Tertiary;
+}
+
+// Typical urban free-flow speeds (km/h), used when a way has no usable maxspeed.
+constexpr double defaultSpeedKmh(HighwayClass cls) {
+    switch (cls) {
+        case HighwayClass::Motorway: return 100;
+        case HighwayClass::Trunk: return 80;
+        case HighwayClass::Primary: return 60;
+        case HighwayClass::Secondary: return 50;
+        case HighwayClass::Tertiary: return 40;
+        case HighwayClass::Unclassified: return 30;
+        case HighwayClass::Residential: return 25;
+        case HighwayClass::Service: return 15;
+        case HighwayClass::LivingStreet: return 10;
+        case HighwayClass::MotorwayLink: return 60;
+        case HighwayClass::PrimaryLink: return 45;
+        case HighwayClass::SecondaryLink: return 40;
+        case HighwayClass::TertiaryLink: return 30;
+        default: return 25;
+    }
+}
+
+enum class Oneway : uint8_t { No, Forward, Reverse };
+
+// Combines oneway=* and junction=roundabout.
+constexpr Oneway classifyOneway(const char* oneway, const char* junction) {
+    if (oneway) {
+        const std::string_view v(oneway);
+        if (v == "yes" || v == "true" || v == "1") return Oneway::Forward;
+        if (v == "-1") return Oneway::Reverse;
+    }
+    if (junction && std::string_view(junction) == "roundabout") return Oneway::Forward;
+    return Oneway::No;
+}
+
+constexpr bool tagIs(const char* value, std::string_view expected) {
+    return value && std::string_view(value) == expected;
+}
+
+#endif
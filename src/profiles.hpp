@@ -0,0 +1,132 @@
+#ifndef PROFILES_HPP
+#define PROFILES_HPP
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+#include "osm_tags.hpp"
+
+// Travel modes served from one shared graph. Every edge carries a bitmask of
+// the profiles allowed on it and one travel time per profile.
+enum class Profile : uint8_t { Car, Motorbike, Bicycle, Foot };
+
+constexpr size_t PROFILE_COUNT = 4;
+constexpr uint8_t ALL_PROFILES = (1u << PROFILE_COUNT) - 1;
+
+constexpr uint8_t profileBit(Profile p) { return static_cast<uint8_t>(1u << static_cast<uint8_t>(p)); }
+constexpr size_t profileSlot(Profile p) { return static_cast<size_t>(p); }
+
+// km/h per profile; 0 means the profile may not use the edge.
+using ProfileSpeeds = std::array<double, PROFILE_COUNT>;
+
+constexpr std::string_view profileName(Profile p) {
+    switch (p) {
+        case Profile::Car: return "car";
+        case Profile::Motorbike: return "motorbike";
+        case Profile::Bicycle: return "bicycle";
+        default: return "foot";
+    }
+}
+
+// Accepts the names above, plus "rickshaw", "bike" and "walk".
+constexpr bool parseProfile(std::string_view name, Profile& profile) {
+    if (name == "car") profile = Profile::Car;
+    else if (name == "motorbike" || name == "rickshaw") profile = Profile::Motorbike;
+    else if (name == "bicycle" || name == "bike") profile = Profile::Bicycle;
+    else if (name == "foot" || name == "walk") profile = Profile::Foot;
+    else return false;
+    return true;
+}
+
+// Highway classes a profile uses when no access tag says otherwise. Motorbikes
+// and rickshaws are barred from motorways in Pakistan, as are bicycles and
+// pedestrians.
+constexpr bool allowsHighway(Profile p, HighwayClass cls) {
+    const bool motorway = cls == HighwayClass::Motorway || cls == HighwayClass::MotorwayLink;
+    switch (p) {
+        case Profile::Car:
+            return isDrivable(cls);
+        case Profile::Motorbike:
+            return isDrivable(cls) && !motorway;
+        case Profile::Bicycle:
+            return (isDrivable(cls) && !motorway) || cls == HighwayClass::Cycleway ||
+                   cls == HighwayClass::Path || cls == HighwayClass::Track;
+        default:
+            return cls != HighwayClass::None && cls != HighwayClass::Other && !motorway;
+    }
+}
+
+// Access keys from most to least specific, padded with nullptr.
+constexpr std::array<const char*, 4> accessKeys(Profile p) {
+    switch (p) {
+        case Profile::Car: return {"motorcar", "motor_vehicle", "vehicle", "access"};
+        case Profile::Motorbike: return {"motorcycle", "motor_vehicle", "vehicle", "access"};
+        case Profile::Bicycle: return {"bicycle", "vehicle", "access", nullptr};
+        default: return {"foot", "access", nullptr, nullptr};
+    }
+}
+
+enum class Access : uint8_t { Unspecified, Allowed, Denied };
+
+// Only "no" denies: private and destination roads stay routable, as before.
+constexpr Access classifyAccess(const char* value) {
+    if (!value) return Access::Unspecified;
+    const std::string_view v(value);
+    if (v == "no") return Access::Denied;
+    if (v == "yes" || v == "designated" || v == "permissive") return Access::Allowed;
+    return Access::Unspecified;
+}
+
+// Whether profile p may use a way of class cls. The most specific access key
+// present decides; only the profile's own key (bicycle=yes on a footway) can
+// open a class the profile does not use by default.
+template <typename Tags>
+bool profileAllowed(Profile p, HighwayClass cls, const Tags& tags) {
+    if (cls == HighwayClass::None || cls == HighwayClass::Other) return false;
+    const auto keys = accessKeys(p);
+    for (size_t k = 0; k < keys.size() && keys[k]; ++k) {
+        const Access a = classifyAccess(tags[keys[k]]);
+        if (a == Access::Denied) return false;
+        if (a == Access::Allowed) return k == 0 || allowsHighway(p, cls);
+    }
+    return allowsHighway(p, cls);
+}
+
+// Direction a profile may travel a way in. Pedestrians walk one-way streets
+// both ways; cyclists do where oneway:bicycle=no or a contraflow lane says so.
+template <typename Tags>
+Oneway profileOneway(Profile p, const Tags& tags) {
+    if (p == Profile::Foot) return Oneway::No;
+    if (p == Profile::Bicycle) {
+        const char* cycleway = tags["cycleway"];
+        if (tagIs(tags["oneway:bicycle"], "no") ||
+            (cycleway && std::string_view(cycleway).substr(0, 8) == "opposite")) {
+            return Oneway::No;
+        }
+    }
+    return classifyOneway(tags["oneway"], tags["junction"]);
+}
+
+// Turn restrictions bind motor vehicles; cyclists are usually excepted and
+// pedestrians never bound.
+constexpr bool obeysTurnRestrictions(Profile p) { return p == Profile::Car || p == Profile::Motorbike; }
+
+// Whether congestion slows the profile down (see TrafficModel); cyclists and
+// pedestrians keep their speed.
+constexpr bool followsTraffic(Profile p) { return p == Profile::Car || p == Profile::Motorbike; }
+
+// Speed on a way of class cls whose car speed (maxspeed or class default) is carKmh.
+constexpr double profileSpeedKmh(Profile p, HighwayClass cls, double carKmh) {
+    switch (p) {
+        case Profile::Car: return carKmh;
+        // rickshaws and small motorbikes rarely go faster in city traffic
+        case Profile::Motorbike: return carKmh < 45.0 ? carKmh : 45.0;
+        case Profile::Bicycle:
+            return cls == HighwayClass::Track || cls == HighwayClass::Path ? 12.0 : 15.0;
+        default:
+            return cls == HighwayClass::Steps ? 2.0 : 5.0;
+    }
+}
+
+#endif
@@ -9,6 +9,7 @@ void Renderer::render() const
     glClear(GL_COLOR_BUFFER_BIT);
     glUseProgram(m_shaderProgram);
     glBindVertexArray(m_VAO);
+    if (m_uColorLoc >= 0) glUniform4f(m_uColorLoc, 0.91f, 0.44f, 0.11f, 1.0f);
     // If segment info is available, draw each segment as a line strip for continuous roads
     if (!m_segmentOffsets.empty() && m_segmentOffsets.size() == m_segmentLengths.size()) {
         for (size_t i = 0; i < m_segmentOffsets.size(); ++i) {
@@ -17,9 +18,55 @@ void Renderer::render() const
             if (len < 2) continue;
             glDrawElements(GL_LINE_STRIP, static_cast<GLsizei>(len), GL_UNSIGNED_INT, reinterpret_cast<const void*>(offset * sizeof(unsigned int)));
         }
+
+        if (!m_highlightSegments.empty()) {
+            if (m_uColorLoc >= 0) glUniform4f(m_uColorLoc, 0.2f, 0.9f, 1.0f, 1.0f);
+            glLineWidth(3.0f);
+            for (size_t i : m_highlightSegments) {
+                if (i >= m_segmentOffsets.size() || m_segmentLengths[i] < 2) continue;
+                glDrawElements(GL_LINE_STRIP, static_cast<GLsizei>(m_segmentLengths[i]), GL_UNSIGNED_INT,
+                               reinterpret_cast<const void*>(m_segmentOffsets[i] * sizeof(unsigned int)));
+            }
+            glLineWidth(1.5f);
+        }
     } else {
         glDrawElements(m_drawMode, static_cast<GLsizei>(m_indices.size()), GL_UNSIGNED_INT, 0);
     }
+
+    if (!m_overlayLengths.empty()) {
+        glBindVertexArray(m_overlayVAO);
+        glLineWidth(2.0f);
+        size_t first = 0;
+        for (size_t i = 0; i < m_overlayLengths.size(); ++i) {
+            if (m_uColorLoc >= 0) {
+                glUniform4f(m_uColorLoc, m_overlayColors[i * 4], m_overlayColors[i * 4 + 1],
+                            m_overlayColors[i * 4 + 2], m_overlayColors[i * 4 + 3]);
+            }
+            glDrawArrays(GL_LINE_STRIP, static_cast<GLint>(first), static_cast<GLsizei>(m_overlayLengths[i]));
+            first += m_overlayLengths[i];
+        }
+        glLineWidth(1.5f);
+        glBindVertexArray(m_VAO);
+    }
+}
+
+void Renderer::setOverlayLines(const std::vector<float>& xy, std::vector<size_t> lengths, std::vector<float> colors) {
+    if (m_overlayVAO == 0) {
+        glGenVertexArrays(1, &m_overlayVAO);
+        glGenBuffers(1, &m_overlayVBO);
+        glBindVertexArray(m_overlayVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, m_overlayVBO);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 2, (void*)0);
+        glEnableVertexAttribArray(0);
+    }
+    glBindVertexArray(m_overlayVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, m_overlayVBO);
+    glBufferData(GL_ARRAY_BUFFER, xy.size() * sizeof(float), xy.data(), GL_DYNAMIC_DRAW);
+    glBindVertexArray(m_VAO);
+
+    colors.resize(lengths.size() * 4, 1.0f);
+    m_overlayLengths = std::move(lengths);
+    m_overlayColors = std::move(colors);
 }
 
 void Renderer::defineGeometry() 
@@ -62,6 +109,7 @@ void Renderer::defineGeometry()
     // get uniform locations for camera and set defaults
     m_uOffsetLoc = glGetUniformLocation(m_shaderProgram, "u_offset");
     m_uScaleLoc = glGetUniformLocation(m_shaderProgram, "u_scale");
+    m_uColorLoc = glGetUniformLocation(m_shaderProgram, "u_color");
     if (m_uOffsetLoc >= 0) glUniform2f(m_uOffsetLoc, m_camOffsetX, m_camOffsetY);
     if (m_uScaleLoc >= 0) glUniform1f(m_uScaleLoc, m_camScale);
 
@@ -28,6 +28,12 @@ private:
     GLuint m_shaderProgram;
     GLint m_uOffsetLoc = -1;
     GLint m_uScaleLoc = -1;
+    GLint m_uColorLoc = -1;
+    std::vector<size_t> m_highlightSegments; // drawn on top, e.g. road search results
+    GLuint m_overlayVAO = 0;
+    GLuint m_overlayVBO = 0;
+    std::vector<size_t> m_overlayLengths;    // points per overlay line, e.g. isochrone rings
+    std::vector<float> m_overlayColors;      // rgba per overlay line
     float m_camOffsetX = 0.0f;
     float m_camOffsetY = 0.0f;
     float m_camScale = 1.0f;
@@ -60,6 +66,14 @@ public:
         }
     }
 
+    // Indices into the segment info to draw highlighted; empty clears the highlight.
+    void setHighlightSegments(std::vector<size_t> segments) { m_highlightSegments = std::move(segments); }
+
+    // Line strips drawn over the map: xy pairs in the map's vertex space (see
+    // toViewCoords()), lengths[i] points for line i, four rgba floats per line.
+    // Empty clears the overlay. Needs the GL context, so call after defineGeometry().
+    void setOverlayLines(const std::vector<float>& xy, std::vector<size_t> lengths, std::vector<float> colors);
+
     void setVertices(const std::vector<float>& arr) { m_vertices = arr; }
     void setIndices(const std::vector<unsigned int>& arr) { m_indices = arr; }
 
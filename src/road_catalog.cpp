@@ -0,0 +1,189 @@
+#include "road_catalog.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+namespace {
+
+// FNV-1a
+uint32_t hashString(std::string_view s) {
+    uint32_t h = 2166136261u;
+    for (char c : s) {
+        h ^= static_cast<unsigned char>(c);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+} // namespace
+
+StringPool::Id StringPool::intern(std::string_view s) {
+    if (m_slots.empty() || (size() + 1) * 2 > m_slots.size()) grow();
+
+    const uint32_t h = hashString(s);
+    const size_t mask = m_slots.size() - 1;
+    for (size_t i = h & mask;; i = (i + 1) & mask) {
+        Id id = m_slots[i];
+        if (id == EMPTY_SLOT) {
+            id = static_cast<Id>(size());
+            m_chars.insert(m_chars.end(), s.begin(), s.end());
+            m_offsets.push_back(static_cast<uint32_t>(m_chars.size()));
+            m_hashes.push_back(h);
+            m_slots[i] = id;
+            return id;
+        }
+        if (m_hashes[id] == h && view(id) == s) return id;
+    }
+}
+
+void StringPool::grow() {
+    std::vector<Id> slots(m_slots.empty() ? 64 : m_slots.size() * 2, EMPTY_SLOT);
+    const size_t mask = slots.size() - 1;
+    for (Id id = 0; id < size(); ++id) {
+        size_t i = m_hashes[id] & mask;
+        while (slots[i] != EMPTY_SLOT) i = (i + 1) & mask;
+        slots[i] = id;
+    }
+    m_slots.swap(slots);
+}
+
+size_t StringPool::memoryBytes() const {
+    return m_chars.capacity() + (m_offsets.capacity() + m_slots.capacity() + m_hashes.capacity()) * sizeof(uint32_t);
+}
+
+RoadCatalog::RoadId RoadCatalog::road(std::string_view name, HighwayClass cls) {
+    StringPool::Id nameId = m_strings.intern(name);
+    uint64_t key = (static_cast<uint64_t>(nameId) << 8) | static_cast<uint8_t>(cls);
+    auto it = m_index.find(key);
+    if (it != m_index.end()) return it->second;
+
+    RoadId id = static_cast<RoadId>(m_roads.size());
+    m_roads.push_back({nameId, cls, 0, 0, 0, 0});
+    m_index.emplace(key, id);
+    return id;
+}
+
+void RoadCatalog::beginSegment(RoadId road) {
+    if (!m_segments.empty()) m_segments.back().end = static_cast<uint32_t>(m_nodeRefs.size());
+    uint32_t at = static_cast<uint32_t>(m_nodeRefs.size());
+    m_segments.push_back({at, at});
+    m_segmentRoads.push_back(road);
+    ++m_roads[road].segmentCount;
+}
+
+void RoadCatalog::addAlias(RoadId road, std::string_view alias) {
+    StringPool::Id id = m_strings.intern(alias);
+    if (id != m_roads[road].name) m_aliases.push_back({road, id});
+}
+
+void RoadCatalog::finalize() {
+    if (!m_segments.empty()) m_segments.back().end = static_cast<uint32_t>(m_nodeRefs.size());
+
+    // counting sort of segments by road, keeping each road's segments in input order
+    uint32_t offset = 0;
+    for (Road& r : m_roads) {
+        r.firstSegment = offset;
+        offset += r.segmentCount;
+    }
+    std::vector<uint32_t> cursor(m_roads.size());
+    for (size_t i = 0; i < m_roads.size(); ++i) cursor[i] = m_roads[i].firstSegment;
+    std::vector<Segment> grouped(m_segments.size());
+    for (size_t i = 0; i < m_segments.size(); ++i) grouped[cursor[m_segmentRoads[i]]++] = m_segments[i];
+
+    m_segments.swap(grouped);
+
+    std::sort(m_aliases.begin(), m_aliases.end(), [](const Alias& a, const Alias& b) {
+        return a.road != b.road ? a.road < b.road : a.name < b.name;
+    });
+    m_aliases.erase(std::unique(m_aliases.begin(), m_aliases.end(), [](const Alias& a, const Alias& b) {
+        return a.road == b.road && a.name == b.name;
+    }), m_aliases.end());
+    m_aliases.shrink_to_fit();
+    for (uint32_t i = 0; i < m_aliases.size(); ++i) {
+        Road& r = m_roads[m_aliases[i].road];
+        if (r.aliasCount++ == 0) r.firstAlias = i;
+    }
+
+    m_segments.shrink_to_fit();
+    m_nodeRefs.shrink_to_fit();
+    std::vector<RoadId>().swap(m_segmentRoads);
+}
+
+void RoadCatalog::stitchSegments() {
+    std::vector<int64_t> nodeRefs;
+    nodeRefs.reserve(m_nodeRefs.size());
+    std::vector<Segment> segments;
+    segments.reserve(m_segments.size());
+
+    std::vector<std::pair<int64_t, uint32_t>> ends; // (end node, segment << 1 | 1 if it is the back)
+    std::vector<bool> used;
+    std::vector<int64_t> chain;
+
+    for (Road& road : m_roads) {
+        const uint32_t first = road.firstSegment;
+        const uint32_t count = road.segmentCount;
+        auto nodesOf = [&](uint32_t s) {
+            const Segment& seg = m_segments[first + s];
+            return NodeSpan{m_nodeRefs.data() + seg.begin, m_nodeRefs.data() + seg.end};
+        };
+
+        ends.clear();
+        for (uint32_t s = 0; s < count; ++s) {
+            NodeSpan nodes = nodesOf(s);
+            if (nodes.size() < 2) continue;
+            ends.push_back({nodes.front(), s << 1});
+            ends.push_back({nodes.back(), (s << 1) | 1});
+        }
+        std::sort(ends.begin(), ends.end());
+        used.assign(count, false);
+
+        // appends unused segments at chain.back() until none is left or the chain closes
+        auto extend = [&]() {
+            while (chain.front() != chain.back()) {
+                auto it = std::lower_bound(ends.begin(), ends.end(), std::make_pair(chain.back(), uint32_t(0)));
+                while (it != ends.end() && it->first == chain.back() && used[it->second >> 1]) ++it;
+                if (it == ends.end() || it->first != chain.back()) return;
+
+                uint32_t s = it->second >> 1;
+                used[s] = true;
+                NodeSpan nodes = nodesOf(s);
+                if (it->second & 1) {
+                    chain.insert(chain.end(), std::make_reverse_iterator(nodes.end() - 1),
+                                 std::make_reverse_iterator(nodes.begin()));
+                } else {
+                    chain.insert(chain.end(), nodes.begin() + 1, nodes.end());
+                }
+            }
+        };
+
+        const uint32_t firstOut = static_cast<uint32_t>(segments.size());
+        for (uint32_t s = 0; s < count; ++s) {
+            if (used[s]) continue;
+            used[s] = true;
+            NodeSpan nodes = nodesOf(s);
+            chain.assign(nodes.begin(), nodes.end());
+            if (nodes.size() >= 2) {
+                extend();
+                std::reverse(chain.begin(), chain.end());
+                extend();
+            }
+            uint32_t begin = static_cast<uint32_t>(nodeRefs.size());
+            nodeRefs.insert(nodeRefs.end(), chain.begin(), chain.end());
+            segments.push_back({begin, static_cast<uint32_t>(nodeRefs.size())});
+        }
+        road.firstSegment = firstOut;
+        road.segmentCount = static_cast<uint32_t>(segments.size()) - firstOut;
+    }
+
+    nodeRefs.shrink_to_fit();
+    segments.shrink_to_fit();
+    m_nodeRefs.swap(nodeRefs);
+    m_segments.swap(segments);
+}
+
+size_t RoadCatalog::memoryBytes() const {
+    return m_strings.memoryBytes() + m_roads.capacity() * sizeof(Road) +
+           m_index.size() * (sizeof(uint64_t) + sizeof(RoadId) + 2 * sizeof(void*)) +
+           m_nodeRefs.capacity() * sizeof(int64_t) + m_segments.capacity() * sizeof(Segment) +
+           m_segmentRoads.capacity() * sizeof(RoadId) + m_aliases.capacity() * sizeof(Alias);
+}
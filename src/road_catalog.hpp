@@ -0,0 +1,115 @@
+#ifndef ROAD_CATALOG_HPP
+#define ROAD_CATALOG_HPP
+
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "osm_tags.hpp"
+
+// Deduplicated strings in one character arena, addressed by 32-bit ids.
+class StringPool {
+public:
+    using Id = uint32_t;
+
+    // Id of s, adding it on first use.
+    Id intern(std::string_view s);
+    std::string_view view(Id id) const {
+        return {m_chars.data() + m_offsets[id], m_offsets[id + 1] - m_offsets[id]};
+    }
+    size_t size() const { return m_offsets.size() - 1; }
+    size_t memoryBytes() const;
+
+private:
+    static constexpr Id EMPTY_SLOT = UINT32_MAX;
+
+    std::vector<char> m_chars;
+    std::vector<uint32_t> m_offsets{0}; // size() + 1 entries
+    std::vector<Id> m_slots;            // open addressing, power-of-two size
+    std::vector<uint32_t> m_hashes;     // per id, so growing never rehashes strings
+
+    void grow();
+};
+
+// Named roads (one per (name, highway class) pair) and the OSM node lists of
+// the ways that make them up. Node ids of all segments live in one flat buffer;
+// segments are [begin, end) ranges into it.
+class RoadCatalog {
+public:
+    using RoadId = uint32_t;
+
+    struct Road {
+        StringPool::Id name;
+        HighwayClass cls;
+        uint32_t firstSegment = 0; // into segments, valid after finalize()
+        uint32_t segmentCount = 0;
+        uint32_t firstAlias = 0;   // into aliases, valid after finalize()
+        uint32_t aliasCount = 0;
+    };
+
+    struct NodeSpan {
+        const int64_t* first;
+        const int64_t* last;
+        const int64_t* begin() const { return first; }
+        const int64_t* end() const { return last; }
+        size_t size() const { return static_cast<size_t>(last - first); }
+        bool empty() const { return first == last; }
+        int64_t front() const { return *first; }
+        int64_t back() const { return *(last - 1); }
+        int64_t operator[](size_t i) const { return first[i]; }
+    };
+
+    // Road for (name, cls), created on first use.
+    RoadId road(std::string_view name, HighwayClass cls);
+
+    // Starts a new segment of road; its nodes follow through appendNode().
+    void beginSegment(RoadId road);
+    void appendNode(int64_t osmId) { m_nodeRefs.push_back(osmId); }
+
+    // Other names of road (name:ur, name:en, alt_name, ...); duplicates are ignored.
+    void addAlias(RoadId road, std::string_view alias);
+
+    // Groups segments and aliases by road. Call once after the last segment was added.
+    void finalize();
+
+    // Joins segments of the same road that share an end node into maximal
+    // polylines, reversing segments where needed. Call after finalize().
+    void stitchSegments();
+
+    size_t roadCount() const { return m_roads.size(); }
+    const Road& road(RoadId id) const { return m_roads[id]; }
+    std::string_view name(RoadId id) const { return m_strings.view(m_roads[id].name); }
+    std::string_view alias(RoadId id, size_t i) const {
+        return m_strings.view(m_aliases[m_roads[id].firstAlias + i].name);
+    }
+    NodeSpan segment(RoadId id, size_t i) const {
+        const Segment& s = m_segments[m_roads[id].firstSegment + i];
+        return {m_nodeRefs.data() + s.begin, m_nodeRefs.data() + s.end};
+    }
+
+    const StringPool& strings() const { return m_strings; }
+    StringPool& strings() { return m_strings; }
+    size_t memoryBytes() const;
+
+private:
+    struct Segment {
+        uint32_t begin;
+        uint32_t end;
+    };
+
+    struct Alias {
+        RoadId road;
+        StringPool::Id name;
+    };
+
+    StringPool m_strings;
+    std::vector<Road> m_roads;
+    std::unordered_map<uint64_t, RoadId> m_index; // name id << 8 | class
+    std::vector<int64_t> m_nodeRefs;
+    std::vector<Segment> m_segments;
+    std::vector<RoadId> m_segmentRoads; // owner of each segment until finalize()
+    std::vector<Alias> m_aliases;       // grouped by road after finalize()
+};
+
+#endif
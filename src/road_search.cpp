@@ -0,0 +1,239 @@
+#include "road_search.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+namespace {
+
+uint32_t packTrigram(unsigned char a, unsigned char b, unsigned char c) {
+    return (static_cast<uint32_t>(a) << 16) | (static_cast<uint32_t>(b) << 8) | c;
+}
+
+// Distinct trigrams of " text ", sorted.
+void trigramsOf(std::string_view text, std::vector<uint32_t>& out) {
+    out.clear();
+    if (text.empty()) return;
+    std::string padded;
+    padded.reserve(text.size() + 2);
+    padded += ' ';
+    padded += text;
+    padded += ' ';
+    for (size_t i = 0; i + 2 < padded.size(); ++i) {
+        out.push_back(packTrigram(padded[i], padded[i + 1], padded[i + 2]));
+    }
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+}
+
+float kindScore(RoadSearchIndex::MatchKind kind) {
+    switch (kind) {
+        case RoadSearchIndex::MatchKind::Exact: return 4.0f;
+        case RoadSearchIndex::MatchKind::Prefix: return 3.0f;
+        case RoadSearchIndex::MatchKind::WordPrefix: return 2.5f;
+        case RoadSearchIndex::MatchKind::Substring: return 2.0f;
+        default: return 0.0f;
+    }
+}
+
+} // namespace
+
+std::string RoadSearchIndex::normalize(std::string_view text) {
+    std::string out;
+    out.reserve(text.size());
+    bool pendingSpace = false;
+    for (unsigned char c : text) {
+        bool keep = c >= 0x80 || (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+        if (!keep) {
+            pendingSpace = !out.empty();
+            continue;
+        }
+        if (pendingSpace) out += ' ';
+        pendingSpace = false;
+        out += static_cast<char>(c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c);
+    }
+    return out;
+}
+
+RoadSearchIndex::RoadSearchIndex(const RoadCatalog& roads) : m_roads(roads) {
+    auto addEntry = [&](RoadCatalog::RoadId road, std::string_view name) {
+        std::string normalized = normalize(name);
+        if (normalized.empty()) return;
+        uint32_t begin = static_cast<uint32_t>(m_text.size());
+        m_text += normalized;
+        m_entries.push_back({road, begin, static_cast<uint32_t>(m_text.size()), name, 0});
+        m_text += '\n';
+    };
+    for (RoadCatalog::RoadId r = 0; r < roads.roadCount(); ++r) {
+        addEntry(r, roads.name(r));
+        for (size_t a = 0; a < roads.road(r).aliasCount; ++a) addEntry(r, roads.alias(r, a));
+    }
+
+    // suffix array over every position inside a name
+    m_suffixes.reserve(m_text.size());
+    for (const Entry& e : m_entries) {
+        for (uint32_t pos = e.textBegin; pos < e.textEnd; ++pos) m_suffixes.push_back(pos);
+    }
+    // '\n' sorts below every character a name can contain, so comparing raw
+    // text up to the first '\n' orders suffixes cut at the name's end
+    const char* text = m_text.data();
+    std::sort(m_suffixes.begin(), m_suffixes.end(), [text](uint32_t a, uint32_t b) {
+        while (text[a] == text[b] && text[a] != '\n') {
+            ++a;
+            ++b;
+        }
+        return static_cast<unsigned char>(text[a]) < static_cast<unsigned char>(text[b]);
+    });
+
+    // trigram -> entries, as sorted (trigram, entry) pairs turned into CSR
+    std::vector<std::pair<uint32_t, uint32_t>> pairs;
+    std::vector<uint32_t> grams;
+    for (uint32_t i = 0; i < m_entries.size(); ++i) {
+        Entry& e = m_entries[i];
+        trigramsOf(std::string_view(m_text).substr(e.textBegin, e.textEnd - e.textBegin), grams);
+        e.trigramCount = static_cast<uint32_t>(grams.size());
+        for (uint32_t g : grams) pairs.push_back({g, i});
+    }
+    std::sort(pairs.begin(), pairs.end());
+    m_trigramEntries.reserve(pairs.size());
+    for (size_t i = 0; i < pairs.size(); ++i) {
+        if (i == 0 || pairs[i].first != pairs[i - 1].first) {
+            m_trigramKeys.push_back(pairs[i].first);
+            m_trigramOffsets.push_back(static_cast<uint32_t>(i));
+        }
+        m_trigramEntries.push_back(pairs[i].second);
+    }
+    m_trigramOffsets.push_back(static_cast<uint32_t>(pairs.size()));
+}
+
+std::string_view RoadSearchIndex::suffix(uint32_t pos) const {
+    size_t end = m_text.find('\n', pos);
+    return std::string_view(m_text).substr(pos, end - pos);
+}
+
+const RoadSearchIndex::Entry& RoadSearchIndex::entryAt(uint32_t pos) const {
+    auto it = std::upper_bound(m_entries.begin(), m_entries.end(), pos,
+                               [](uint32_t p, const Entry& e) { return p < e.textBegin; });
+    return *(it - 1);
+}
+
+void RoadSearchIndex::narrow(std::string_view query, uint32_t& lo, uint32_t& hi) const {
+    auto first = m_suffixes.begin() + lo;
+    auto last = m_suffixes.begin() + hi;
+    first = std::lower_bound(first, last, query, [&](uint32_t pos, std::string_view q) {
+        return suffix(pos).substr(0, q.size()) < q;
+    });
+    last = std::upper_bound(first, last, query, [&](std::string_view q, uint32_t pos) {
+        return q < suffix(pos).substr(0, q.size());
+    });
+    lo = static_cast<uint32_t>(first - m_suffixes.begin());
+    hi = static_cast<uint32_t>(last - m_suffixes.begin());
+}
+
+std::vector<RoadSearchIndex::Match> RoadSearchIndex::collect(std::string_view query, uint32_t lo, uint32_t hi,
+                                                             size_t limit) const {
+    std::vector<Match> matches;
+    std::unordered_map<RoadCatalog::RoadId, size_t> byRoad;
+    auto offer = [&](const Entry& e, MatchKind kind, float score) {
+        // shorter names rank first among equally good matches
+        score -= 0.001f * std::min<uint32_t>(e.textEnd - e.textBegin, 500);
+        auto it = byRoad.find(e.road);
+        if (it == byRoad.end()) {
+            byRoad.emplace(e.road, matches.size());
+            matches.push_back({e.road, kind, score, e.name});
+        } else if (score > matches[it->second].score) {
+            matches[it->second] = {e.road, kind, score, e.name};
+        }
+    };
+
+    for (uint32_t i = lo; i < hi && i - lo < MAX_SUFFIX_HITS; ++i) {
+        uint32_t pos = m_suffixes[i];
+        const Entry& e = entryAt(pos);
+        MatchKind kind;
+        if (pos == e.textBegin) kind = e.textEnd - e.textBegin == query.size() ? MatchKind::Exact : MatchKind::Prefix;
+        else kind = m_text[pos - 1] == ' ' ? MatchKind::WordPrefix : MatchKind::Substring;
+        offer(e, kind, kindScore(kind));
+    }
+
+    // misspellings: share enough trigrams with the query
+    if (matches.size() < limit && query.size() >= 3) {
+        std::vector<uint32_t> grams;
+        trigramsOf(query, grams);
+        struct Postings {
+            const uint32_t* first;
+            const uint32_t* last;
+        };
+        std::vector<Postings> lists;
+        for (uint32_t g : grams) {
+            auto it = std::lower_bound(m_trigramKeys.begin(), m_trigramKeys.end(), g);
+            if (it == m_trigramKeys.end() || *it != g) continue;
+            size_t k = static_cast<size_t>(it - m_trigramKeys.begin());
+            lists.push_back({m_trigramEntries.data() + m_trigramOffsets[k], m_trigramEntries.data() + m_trigramOffsets[k + 1]});
+        }
+
+        // Dice = 2s / (q + t) with t >= s, so reaching MIN_FUZZY_SCORE takes
+        // s >= q * MIN / (2 - MIN) shared trigrams. Such an entry must sit in one
+        // of the (lists - minShared + 1) shortest lists; the common ones are only
+        // probed for those candidates.
+        const size_t minShared = std::max<size_t>(
+            1, static_cast<size_t>(std::ceil(grams.size() * MIN_FUZZY_SCORE / (2.0f - MIN_FUZZY_SCORE))));
+        if (lists.size() >= minShared) {
+            std::sort(lists.begin(), lists.end(), [](const Postings& a, const Postings& b) {
+                return a.last - a.first < b.last - b.first;
+            });
+            const size_t probe = lists.size() - minShared + 1;
+            std::vector<uint32_t> candidates;
+            for (size_t i = 0; i < probe; ++i) candidates.insert(candidates.end(), lists[i].first, lists[i].last);
+            std::sort(candidates.begin(), candidates.end());
+
+            for (size_t i = 0; i < candidates.size();) {
+                uint32_t entry = candidates[i];
+                size_t shared = 0;
+                while (i < candidates.size() && candidates[i] == entry) ++shared, ++i;
+                for (size_t l = probe; l < lists.size(); ++l) shared += std::binary_search(lists[l].first, lists[l].last, entry);
+                const Entry& e = m_entries[entry];
+                float dice = 2.0f * shared / static_cast<float>(grams.size() + e.trigramCount);
+                if (dice >= MIN_FUZZY_SCORE) offer(e, MatchKind::Fuzzy, dice);
+            }
+        }
+    }
+
+    auto better = [&](const Match& a, const Match& b) {
+        if (a.score != b.score) return a.score > b.score;
+        HighwayClass ca = m_roads.road(a.road).cls, cb = m_roads.road(b.road).cls;
+        if (ca != cb) return ca < cb; // motorway before trunk before primary ...
+        return a.name < b.name;
+    };
+    const size_t keep = std::min(limit, matches.size());
+    std::partial_sort(matches.begin(), matches.begin() + keep, matches.end(), better);
+    matches.resize(keep);
+    return matches;
+}
+
+std::vector<RoadSearchIndex::Match> RoadSearchIndex::search(std::string_view query, size_t limit) const {
+    std::string q = normalize(query);
+    if (q.empty()) return {};
+    uint32_t lo = 0, hi = static_cast<uint32_t>(m_suffixes.size());
+    narrow(q, lo, hi);
+    return collect(q, lo, hi, limit);
+}
+
+const std::vector<RoadSearchIndex::Match>& RoadSearchIndex::Session::update(std::string_view query, size_t limit) {
+    std::string q = normalize(query);
+    if (q.empty()) {
+        m_query.clear();
+        m_results.clear();
+        return m_results;
+    }
+
+    // typing more characters can only shrink the previous suffix range
+    bool extends = !m_query.empty() && q.size() >= m_query.size() && q.compare(0, m_query.size(), m_query) == 0;
+    if (!extends) {
+        m_lo = 0;
+        m_hi = static_cast<uint32_t>(m_index.m_suffixes.size());
+    }
+    m_index.narrow(q, m_lo, m_hi);
+    m_query = std::move(q);
+    m_results = m_index.collect(m_query, m_lo, m_hi, limit);
+    return m_results;
+}
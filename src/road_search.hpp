@@ -0,0 +1,79 @@
+#ifndef ROAD_SEARCH_HPP
+#define ROAD_SEARCH_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "road_catalog.hpp"
+
+// Road-name lookup for the viewer's search box. Every name and alias of a
+// RoadCatalog is normalized (ASCII lower case, punctuation folded to single
+// spaces, non-ASCII bytes such as Urdu script kept as they are) into one text
+// buffer. A suffix array over that buffer answers prefix and substring queries
+// with two binary searches; a trigram index catches misspellings.
+class RoadSearchIndex {
+public:
+    enum class MatchKind : uint8_t { Exact, Prefix, WordPrefix, Substring, Fuzzy };
+
+    struct Match {
+        RoadCatalog::RoadId road;
+        MatchKind kind;
+        float score;           // higher is better
+        std::string_view name; // the name or alias that matched
+    };
+
+    // roads must outlive the index.
+    explicit RoadSearchIndex(const RoadCatalog& roads);
+
+    // Up to limit roads matching query, best first, one entry per road.
+    std::vector<Match> search(std::string_view query, size_t limit = 20) const;
+
+    // Search-as-you-type. Remembers the suffix range of the previous query, so a
+    // keystroke that extends it only narrows that range.
+    class Session {
+    public:
+        explicit Session(const RoadSearchIndex& index) : m_index(index) {}
+        const std::vector<Match>& update(std::string_view query, size_t limit = 20);
+        const std::vector<Match>& results() const { return m_results; }
+
+    private:
+        const RoadSearchIndex& m_index;
+        std::string m_query; // normalized
+        uint32_t m_lo = 0;
+        uint32_t m_hi = 0;
+        std::vector<Match> m_results;
+    };
+
+    static std::string normalize(std::string_view text);
+
+private:
+    struct Entry {
+        RoadCatalog::RoadId road;
+        uint32_t textBegin; // normalized name is m_text[textBegin, textEnd)
+        uint32_t textEnd;
+        std::string_view name;
+        uint32_t trigramCount;
+    };
+
+    // Suffixes examined per query; keeps a one-letter query within a frame.
+    static constexpr size_t MAX_SUFFIX_HITS = 4096;
+    static constexpr float MIN_FUZZY_SCORE = 0.35f;
+
+    const RoadCatalog& m_roads;
+    std::string m_text;              // normalized names, each followed by '\n'
+    std::vector<Entry> m_entries;    // in m_text order
+    std::vector<uint32_t> m_suffixes; // positions in m_text, sorted by suffix (cut at the name's end)
+    std::vector<uint32_t> m_trigramKeys;    // sorted distinct trigrams
+    std::vector<uint32_t> m_trigramOffsets; // m_trigramKeys.size() + 1 entries into m_trigramEntries
+    std::vector<uint32_t> m_trigramEntries;
+
+    std::string_view suffix(uint32_t pos) const;
+    const Entry& entryAt(uint32_t pos) const;
+    // Narrows [lo, hi) of m_suffixes to the suffixes starting with query.
+    void narrow(std::string_view query, uint32_t& lo, uint32_t& hi) const;
+    std::vector<Match> collect(std::string_view query, uint32_t lo, uint32_t hi, size_t limit) const;
+};
+
+#endif
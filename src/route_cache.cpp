@@ -0,0 +1,180 @@
+#include "route_cache.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "weight_overrides.hpp"
+
+namespace {
+
+// unordered_map node, bucket slot and the entry's share of vector slack
+constexpr size_t INDEX_OVERHEAD = 64;
+
+uint64_t mix(uint64_t h, uint64_t v) {
+    h ^= v + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    return h;
+}
+
+uint64_t bitsOf(double d) {
+    uint64_t bits;
+    std::memcpy(&bits, &d, sizeof(bits));
+    return bits;
+}
+
+// Zigzag varints of the difference to the previous node (0 before the first).
+void encodePath(const std::vector<RoutingGraph::NodeIndex>& path, std::vector<uint8_t>& out) {
+    out.clear();
+    int64_t previous = 0;
+    for (RoutingGraph::NodeIndex n : path) {
+        const int64_t delta = static_cast<int64_t>(n) - previous;
+        previous = n;
+        uint64_t zigzag = (static_cast<uint64_t>(delta) << 1) ^ static_cast<uint64_t>(delta >> 63);
+        while (zigzag >= 0x80) {
+            out.push_back(static_cast<uint8_t>(zigzag | 0x80));
+            zigzag >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(zigzag));
+    }
+    out.shrink_to_fit();
+}
+
+void decodePath(const std::vector<uint8_t>& in, size_t nodes, std::vector<RoutingGraph::NodeIndex>& path) {
+    path.clear();
+    path.reserve(nodes);
+    int64_t previous = 0;
+    for (size_t i = 0; i < in.size();) {
+        uint64_t zigzag = 0;
+        for (int shift = 0;; shift += 7) {
+            const uint8_t byte = in[i++];
+            zigzag |= uint64_t(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) break;
+        }
+        previous += static_cast<int64_t>(zigzag >> 1) ^ -static_cast<int64_t>(zigzag & 1);
+        path.push_back(static_cast<RoutingGraph::NodeIndex>(previous));
+    }
+}
+
+} // namespace
+
+bool RouteCache::makeKey(RoutingGraph::NodeIndex start, RoutingGraph::NodeIndex goal, const SearchOptions& options,
+                         Key& key) {
+    if (options.traffic && options.metric == Metric::Duration && followsTraffic(options.profile)) return false;
+    key.start = start;
+    key.goal = goal;
+    key.weightsGeneration = options.overrides ? options.overrides->generation() : 0;
+    // penalties only change Duration searches
+    const bool timed = options.metric == Metric::Duration;
+    key.uturnPenalty = timed ? options.uturnPenalty : 0.0;
+    key.crossTrafficPenalty = timed ? options.crossTrafficPenalty : 0.0;
+    key.profile = options.profile;
+    key.metric = options.metric;
+    key.leftHandTraffic = options.leftHandTraffic;
+    return true;
+}
+
+size_t RouteCache::KeyHash::operator()(const Key& k) const {
+    uint64_t h = mix(0, (uint64_t(k.start) << 32) | k.goal);
+    h = mix(h, k.weightsGeneration);
+    h = mix(h, bitsOf(k.uturnPenalty));
+    h = mix(h, bitsOf(k.crossTrafficPenalty));
+    h = mix(h, (uint64_t(k.profile) << 16) | (uint64_t(k.metric) << 8) | uint64_t(k.leftHandTraffic));
+    // finalizer, so both halves of h are well mixed
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return static_cast<size_t>(h);
+}
+
+size_t RouteCache::Entry::bytes() const {
+    return sizeof(Entry) + path.capacity() + INDEX_OVERHEAD;
+}
+
+RouteCache::RouteCache(size_t capacityBytes, size_t shards)
+    : m_shardCapacity(capacityBytes / std::max<size_t>(1, shards)) {
+    for (size_t s = 0; s < std::max<size_t>(1, shards); ++s) m_shards.push_back(std::make_unique<Shard>());
+}
+
+bool RouteCache::lookup(const Key& key, std::vector<RoutingGraph::NodeIndex>& path) {
+    Shard& shard = shardOf(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.index.find(key);
+    if (it == shard.index.end()) {
+        ++shard.misses;
+        return false;
+    }
+    Entry& e = shard.entries[it->second];
+    e.referenced = true;
+    ++shard.hits;
+    decodePath(e.path, e.nodes, path);
+    return true;
+}
+
+void RouteCache::insert(const Key& key, const std::vector<RoutingGraph::NodeIndex>& path) {
+    Entry entry;
+    entry.key = key;
+    entry.nodes = path.size();
+    encodePath(path, entry.path); // outside the lock
+    const size_t bytes = entry.bytes();
+    if (bytes > m_shardCapacity) return;
+
+    Shard& shard = shardOf(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.index.find(key);
+    if (it != shard.index.end()) evict(shard, it->second);
+    // sweep: referenced entries get another round, the first unreferenced one goes
+    while (shard.bytes + bytes > m_shardCapacity) {
+        if (shard.hand >= shard.entries.size()) shard.hand = 0;
+        Entry& e = shard.entries[shard.hand];
+        if (e.referenced) {
+            e.referenced = false;
+            ++shard.hand;
+        } else {
+            evict(shard, shard.hand);
+            ++shard.evictions;
+        }
+    }
+    shard.index.emplace(key, shard.entries.size());
+    shard.bytes += bytes;
+    shard.pathNodes += entry.nodes;
+    shard.entries.push_back(std::move(entry));
+    ++shard.insertions;
+}
+
+// Removes entries[at]; the last entry takes its place.
+void RouteCache::evict(Shard& shard, size_t at) {
+    Entry& e = shard.entries[at];
+    shard.bytes -= e.bytes();
+    shard.pathNodes -= e.nodes;
+    shard.index.erase(e.key);
+    if (at + 1 != shard.entries.size()) {
+        e = std::move(shard.entries.back());
+        shard.index[e.key] = at;
+    }
+    shard.entries.pop_back();
+}
+
+void RouteCache::clear() {
+    for (auto& shard : m_shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        shard->entries.clear();
+        shard->index.clear();
+        shard->hand = 0;
+        shard->bytes = 0;
+        shard->pathNodes = 0;
+    }
+}
+
+RouteCache::Stats RouteCache::stats() const {
+    Stats stats;
+    for (const auto& shard : m_shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        stats.hits += shard->hits;
+        stats.misses += shard->misses;
+        stats.insertions += shard->insertions;
+        stats.evictions += shard->evictions;
+        stats.entries += shard->entries.size();
+        stats.bytes += shard->bytes;
+        stats.pathNodes += shard->pathNodes;
+    }
+    return stats;
+}
@@ -0,0 +1,95 @@
+#ifndef ROUTE_CACHE_HPP
+#define ROUTE_CACHE_HPP
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "a_star.hpp"
+#include "routing_graph.hpp"
+
+// Answers to repeated route queries (the same depot to the same popular
+// destinations), kept in front of astar() for one graph. Keys hold everything
+// an exact search depends on, the overrides generation included, so a weight
+// update leaves the older entries unreachable and eviction drops them first.
+//
+// Entries are spread over shards by key hash, each under its own mutex, and
+// evicted CLOCK-style when a shard runs out of bytes. Paths are stored as
+// varint deltas between consecutive node indices, mostly a byte or two a node.
+class RouteCache {
+public:
+    struct Key {
+        RoutingGraph::NodeIndex start;
+        RoutingGraph::NodeIndex goal;
+        uint64_t weightsGeneration; // 0: no overrides
+        double uturnPenalty;
+        double crossTrafficPenalty;
+        Profile profile;
+        Metric metric;
+        bool leftHandTraffic;
+
+        bool operator==(const Key& o) const {
+            return start == o.start && goal == o.goal && weightsGeneration == o.weightsGeneration &&
+                   uturnPenalty == o.uturnPenalty && crossTrafficPenalty == o.crossTrafficPenalty &&
+                   profile == o.profile && metric == o.metric && leftHandTraffic == o.leftHandTraffic;
+        }
+    };
+
+    // Key of an exact search with options; false if the answer depends on more
+    // than a key holds (the departure time, under traffic), so is not cached.
+    static bool makeKey(RoutingGraph::NodeIndex start, RoutingGraph::NodeIndex goal, const SearchOptions& options,
+                        Key& key);
+
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t insertions = 0;
+        uint64_t evictions = 0;
+        size_t entries = 0;
+        size_t bytes = 0;     // estimated, entries and index included
+        size_t pathNodes = 0; // over all entries, to compare with bytes
+        double hitRate() const { return hits + misses ? double(hits) / double(hits + misses) : 0.0; }
+    };
+
+    explicit RouteCache(size_t capacityBytes, size_t shards = 16);
+
+    // The cached path for key (empty: unreachable) into path; false on a miss.
+    bool lookup(const Key& key, std::vector<RoutingGraph::NodeIndex>& path);
+    // Caches path for key, replacing any earlier entry. Paths too large for a
+    // shard are not kept.
+    void insert(const Key& key, const std::vector<RoutingGraph::NodeIndex>& path);
+    void clear();
+    Stats stats() const;
+
+private:
+    struct KeyHash {
+        size_t operator()(const Key& k) const;
+    };
+    struct Entry {
+        Key key;
+        std::vector<uint8_t> path;
+        size_t nodes = 0;
+        bool referenced = false; // looked up since the clock hand last passed
+        size_t bytes() const;
+    };
+    struct Shard {
+        mutable std::mutex mutex;
+        std::vector<Entry> entries;
+        std::unordered_map<Key, size_t, KeyHash> index; // key -> position in entries
+        size_t hand = 0;
+        size_t bytes = 0;
+        size_t pathNodes = 0;
+        uint64_t hits = 0, misses = 0, insertions = 0, evictions = 0;
+    };
+
+    // high hash bits pick the shard, low ones the bucket within it
+    Shard& shardOf(const Key& key) { return *m_shards[(KeyHash()(key) >> 32) % m_shards.size()]; }
+    static void evict(Shard& shard, size_t at);
+
+    std::vector<std::unique_ptr<Shard>> m_shards;
+    size_t m_shardCapacity;
+};
+
+#endif
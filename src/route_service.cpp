@@ -0,0 +1,630 @@
+#include "route_service.hpp"
+#include "a_star.hpp"
+#include "contraction.hpp"
+#include "geo.hpp"
+#include "route_cache.hpp"
+#include "tour.hpp"
+#include "traffic.hpp"
+#include "weight_overrides.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+using NodeIndex = RoutingGraph::NodeIndex;
+
+constexpr size_t MAX_TABLE_POINTS = 100;
+constexpr size_t MAX_TRIP_POINTS = 50;
+constexpr size_t MAX_ALTERNATIVES = 3;
+
+// The route cache belongs to one graph; a request on a newly published graph
+// starts a fresh one. 64 MB unless setRouteCacheCapacity() says otherwise.
+struct GraphCache {
+    std::weak_ptr<const RoutingGraph> graph; // keeps the control block, so no other graph compares equal
+    RouteCache cache;
+    GraphCache(const std::shared_ptr<const RoutingGraph>& g, size_t bytes) : graph(g), cache(bytes) {}
+};
+std::atomic<size_t> g_cacheBytes{size_t(64) << 20};
+std::shared_ptr<GraphCache> g_graphCache;
+std::atomic<size_t> g_tripThreads{0}; // per /trip request, 0: one per core
+
+// The cache for graph, or nullptr if caching is off or graph is no longer
+// the published one.
+std::shared_ptr<GraphCache> cacheFor(const std::shared_ptr<const RoutingGraph>& graph) {
+    const size_t bytes = g_cacheBytes.load();
+    if (bytes == 0) return nullptr;
+    std::shared_ptr<GraphCache> cache = std::atomic_load(&g_graphCache);
+    if (cache && !cache->graph.owner_before(graph) && !graph.owner_before(cache->graph)) return cache;
+    if (graph != currentGraph()) return nullptr;
+    // racing requests may both start one; the last stored wins
+    cache = std::make_shared<GraphCache>(graph, bytes);
+    std::atomic_store(&g_graphCache, cache);
+    return cache;
+}
+
+void appendNumber(std::string& out, double v, const char* fmt) {
+    if (!std::isfinite(v)) {
+        out += "null";
+        return;
+    }
+    char buf[32];
+    int n = std::snprintf(buf, sizeof(buf), fmt, v);
+    out.append(buf, static_cast<size_t>(n));
+}
+
+void setError(HttpResponse& res, int status, const char* message) {
+    res.status = status;
+    res.body = std::string("{\"error\":\"") + message + "\"}";
+}
+
+bool parseLatLon(const std::string& s, double& lat, double& lon) {
+    char* end = nullptr;
+    lat = std::strtod(s.c_str(), &end);
+    if (end == s.c_str() || *end != ',') return false;
+    const char* rest = end + 1;
+    lon = std::strtod(rest, &end);
+    return end != rest && *end == '\0';
+}
+
+bool parseNodeId(const std::string* s, int64_t& id) {
+    if (!s || s->empty()) return false;
+    char* end = nullptr;
+    id = std::strtoll(s->c_str(), &end, 10);
+    return *end == '\0';
+}
+
+bool parsePenalty(const std::string* s, double& seconds) {
+    if (!s) return true;
+    char* end = nullptr;
+    seconds = std::strtod(s->c_str(), &end);
+    return !s->empty() && *end == '\0' && seconds >= 0.0 && seconds <= 3600.0;
+}
+
+bool parseProfileParam(const HttpRequest& req, Profile& profile, HttpResponse& res) {
+    const std::string* p = req.param("profile");
+    if (p && !parseProfile(*p, profile)) {
+        setError(res, 400, "profile must be car, motorbike, bicycle or foot");
+        return false;
+    }
+    return true;
+}
+
+// metric=, profile=, uturn_penalty= and cross_penalty= (seconds), and depart=hh:mm when options
+// has traffic. Sets a 400 and returns false on bad input.
+bool parseSearchOptions(const HttpRequest& req, SearchOptions& options, HttpResponse& res) {
+    if (const std::string* m = req.param("metric")) {
+        if (!parseMetric(*m, options.metric)) {
+            setError(res, 400, "metric must be duration or distance");
+            return false;
+        }
+    }
+    if (!parseProfileParam(req, options.profile, res)) return false;
+    if (!parsePenalty(req.param("uturn_penalty"), options.uturnPenalty) ||
+        !parsePenalty(req.param("cross_penalty"), options.crossTrafficPenalty)) {
+        setError(res, 400, "penalties must be seconds between 0 and 3600");
+        return false;
+    }
+    uint32_t depart = 0;
+    const std::string* d = req.param("depart");
+    if (d && !parseTimeOfDay(*d, depart)) {
+        setError(res, 400, "depart must be hh:mm");
+        return false;
+    }
+    if (options.traffic) options.departure = d ? depart : localTimeOfDay();
+    return true;
+}
+
+// weight, max_settled and max_ms; bounded is set if any was given.
+bool parseBudget(const HttpRequest& req, SearchBudget& budget, bool& bounded, HttpResponse& res) {
+    const std::string* weight = req.param("weight");
+    const std::string* settled = req.param("max_settled");
+    const std::string* ms = req.param("max_ms");
+    bounded = weight || settled || ms;
+    char* end = nullptr;
+    if (weight) {
+        budget.heuristicWeight = std::strtod(weight->c_str(), &end);
+        if (weight->empty() || *end != '\0' || !(budget.heuristicWeight >= 1.0) || budget.heuristicWeight > 10.0) {
+            setError(res, 400, "weight must be between 1 and 10");
+            return false;
+        }
+    }
+    if (settled) {
+        budget.maxSettled = std::strtoull(settled->c_str(), &end, 10);
+        if (settled->empty() || *end != '\0' || budget.maxSettled == 0) {
+            setError(res, 400, "max_settled must be a positive integer");
+            return false;
+        }
+    }
+    if (ms) {
+        const double value = std::strtod(ms->c_str(), &end);
+        if (ms->empty() || *end != '\0' || !(value > 0.0) || value > 60000.0) {
+            setError(res, 400, "max_ms must be between 0 and 60000");
+            return false;
+        }
+        budget.maxTime = std::chrono::microseconds(static_cast<int64_t>(value * 1000.0));
+    }
+    return true;
+}
+
+void appendCoordinates(std::string& out, const RoutingGraph& graph, const std::vector<NodeIndex>& path) {
+    out += '[';
+    for (size_t i = 0; i < path.size(); ++i) {
+        if (i > 0) out += ',';
+        out += '[';
+        appendNumber(out, graph.lat(path[i]), "%.7f");
+        out += ',';
+        appendNumber(out, graph.lon(path[i]), "%.7f");
+        out += ']';
+    }
+    out += ']';
+}
+
+// live: the traffic and overrides snapshot of this request. Plain exact
+// queries go through cache when there is one, and are answered from
+// hierarchy when it covers them.
+void handleRoute(const RoutingGraph& graph, const SearchOptions& live, RouteCache* cache,
+                 const ContractionHierarchy* hierarchy, const HttpRequest& req, HttpResponse& res) {
+    thread_local SearchWorkspace ws;
+    thread_local SearchWorkspace backward;
+
+    SearchOptions options = live;
+    if (!parseSearchOptions(req, options, res)) return;
+    const Metric metric = options.metric;
+    SearchBudget budget;
+    bool bounded = false;
+    if (!parseBudget(req, budget, bounded, res)) return;
+
+    AlternativeOptions alternatives;
+    alternatives.count = 0;
+    if (const std::string* k = req.param("alternatives")) {
+        char* end = nullptr;
+        alternatives.count = std::strtoul(k->c_str(), &end, 10);
+        if (k->empty() || *end != '\0' || alternatives.count > MAX_ALTERNATIVES) {
+            setError(res, 400, "alternatives must be 0 to 3");
+            return;
+        }
+    }
+
+    NodeIndex start = RoutingGraph::INVALID_NODE, goal = RoutingGraph::INVALID_NODE;
+    const std::string* from = req.param("from");
+    const std::string* to = req.param("to");
+    if (from && to) {
+        double slat, slon, glat, glon;
+        if (!parseLatLon(*from, slat, slon) || !parseLatLon(*to, glat, glon)) {
+            setError(res, 400, "from/to must be lat,lon");
+            return;
+        }
+        start = graph.nearestNode(slat, slon, options.profile);
+        goal = graph.nearestNode(glat, glon, options.profile);
+    } else {
+        int64_t startId, goalId;
+        if (!parseNodeId(req.param("start"), startId) || !parseNodeId(req.param("goal"), goalId)) {
+            setError(res, 400, "expected from=lat,lon&to=lat,lon or start=<id>&goal=<id>");
+            return;
+        }
+        start = graph.indexOf(startId);
+        goal = graph.indexOf(goalId);
+    }
+
+    if (start == RoutingGraph::INVALID_NODE || goal == RoutingGraph::INVALID_NODE) {
+        setError(res, 404, "unknown node");
+        return;
+    }
+
+    std::vector<NodeIndex> path;
+    std::vector<Route> routes;
+    SearchResult result;
+    bool cached = false;
+    if (alternatives.count > 0) {
+        routes = alternativeRoutes(graph, start, goal, ws, backward, options, alternatives);
+        if (!routes.empty()) path = routes[0].path;
+        ws.nodesExplored += backward.nodesExplored;
+    } else if (bounded) {
+        result = astar(graph, start, goal, ws, options, budget);
+        path = std::move(result.path);
+    } else {
+        RouteCache::Key key;
+        const bool cacheable = cache && RouteCache::makeKey(start, goal, options, key);
+        cached = cacheable && cache->lookup(key, path);
+        if (!cached && hierarchy && hierarchy->answers(graph, options)) {
+            path = hierarchy->route(graph, start, goal, ws, backward).path;
+            ws.nodesExplored += backward.nodesExplored;
+            if (cacheable) cache->insert(key, path);
+        } else if (!cached) {
+            path = astar(graph, start, goal, ws, options);
+            if (cacheable) cache->insert(key, path);
+        }
+    }
+
+    std::string& out = res.body;
+    out.reserve(64 + path.size() * 48);
+    out += "{\"start\":";
+    out += std::to_string(graph.osmId(start));
+    out += ",\"goal\":";
+    out += std::to_string(graph.osmId(goal));
+    out += ",\"profile\":\"";
+    out += profileName(options.profile);
+    out += "\",\"found\":";
+    out += path.empty() || result.status == SearchStatus::Partial ? "false" : "true";
+    if (bounded && alternatives.count == 0) {
+        // a partial route ends short of the goal; lower_bound is in search units
+        out += ",\"status\":\"";
+        out += statusName(result.status);
+        out += "\",\"lower_bound\":";
+        appendNumber(out, result.lowerBound, "%.1f");
+    }
+
+    const double INF = std::numeric_limits<double>::infinity();
+    PathLength length =
+        measurePath(graph, path, metric, options.profile, options.traffic, options.departure, options.overrides);
+    out += ",\"distance_m\":";
+    appendNumber(out, path.empty() ? INF : length.meters, "%.3f");
+    out += ",\"duration_s\":";
+    appendNumber(out, path.empty() ? INF : length.seconds, "%.1f");
+    if (options.overrides) {
+        out += ",\"weights_generation\":";
+        out += std::to_string(options.overrides->generation());
+    }
+    out += ",\"cached\":";
+    out += cached ? "true" : "false";
+    out += ",\"explored\":";
+    out += std::to_string(cached ? 0 : ws.nodesExplored);
+    out += ",\"nodes\":[";
+    for (size_t i = 0; i < path.size(); ++i) {
+        if (i > 0) out += ',';
+        out += std::to_string(graph.osmId(path[i]));
+    }
+    out += "],\"coordinates\":";
+    appendCoordinates(out, graph, path);
+    if (alternatives.count > 0) {
+        out += ",\"alternatives\":[";
+        for (size_t i = 1; i < routes.size(); ++i) {
+            if (i > 1) out += ',';
+            PathLength alt = measurePath(graph, routes[i].path, metric, options.profile, options.traffic,
+                                         options.departure, options.overrides);
+            out += "{\"distance_m\":";
+            appendNumber(out, alt.meters, "%.3f");
+            out += ",\"duration_s\":";
+            appendNumber(out, alt.seconds, "%.1f");
+            out += ",\"coordinates\":";
+            appendCoordinates(out, graph, routes[i].path);
+            out += '}';
+        }
+        out += ']';
+    }
+    out += '}';
+}
+
+void handleNearest(const RoutingGraph& graph, const HttpRequest& req, HttpResponse& res) {
+    const std::string* latStr = req.param("lat");
+    const std::string* lonStr = req.param("lon");
+    if (!latStr || !lonStr) {
+        setError(res, 400, "expected lat=..&lon=..");
+        return;
+    }
+    char* end1 = nullptr;
+    char* end2 = nullptr;
+    double qlat = std::strtod(latStr->c_str(), &end1);
+    double qlon = std::strtod(lonStr->c_str(), &end2);
+    if (*end1 != '\0' || *end2 != '\0') {
+        setError(res, 400, "lat/lon must be numbers");
+        return;
+    }
+
+    Profile profile = Profile::Car;
+    if (!parseProfileParam(req, profile, res)) return;
+
+    NodeIndex u = graph.nearestNode(qlat, qlon, profile);
+    if (u == RoutingGraph::INVALID_NODE) {
+        setError(res, 404, "graph is empty");
+        return;
+    }
+    double lat = graph.lat(u);
+    double lon = graph.lon(u);
+
+    std::string& out = res.body;
+    out += "{\"node\":";
+    out += std::to_string(graph.osmId(u));
+    out += ",\"lat\":";
+    appendNumber(out, lat, "%.7f");
+    out += ",\"lon\":";
+    appendNumber(out, lon, "%.7f");
+    out += ",\"distance_m\":";
+    appendNumber(out, haversine(qlat, qlon, lat, lon), "%.3f");
+    out += '}';
+}
+
+// points=lat,lon;lat,lon;... snapped to the profile's network (INVALID_NODE
+// where no road is near), at most maxPoints of them.
+bool parsePoints(const RoutingGraph& graph, const HttpRequest& req, Profile profile, size_t maxPoints,
+                 std::vector<NodeIndex>& snapped, HttpResponse& res) {
+    const std::string* pointsStr = req.param("points");
+    if (!pointsStr) {
+        setError(res, 400, "expected points=lat,lon;lat,lon;...");
+        return false;
+    }
+    size_t pos = 0;
+    while (pos <= pointsStr->size()) {
+        size_t semi = pointsStr->find(';', pos);
+        if (semi == std::string::npos) semi = pointsStr->size();
+        double lat, lon;
+        if (!parseLatLon(pointsStr->substr(pos, semi - pos), lat, lon)) {
+            setError(res, 400, "points must be lat,lon pairs separated by ';'");
+            return false;
+        }
+        snapped.push_back(graph.nearestNode(lat, lon, profile));
+        if (snapped.size() > maxPoints) {
+            setError(res, 400, "too many points");
+            return false;
+        }
+        pos = semi + 1;
+    }
+    return true;
+}
+
+void handleTable(const RoutingGraph& graph, const SearchOptions& live, const HttpRequest& req, HttpResponse& res) {
+    thread_local SearchWorkspace ws;
+
+    SearchOptions options = live;
+    if (!parseSearchOptions(req, options, res)) return;
+    const Metric metric = options.metric;
+
+    std::vector<NodeIndex> snapped;
+    if (!parsePoints(graph, req, options.profile, MAX_TABLE_POINTS, snapped, res)) return;
+
+    std::string& out = res.body;
+    out += "{\"snapped\":[";
+    for (size_t i = 0; i < snapped.size(); ++i) {
+        if (i > 0) out += ',';
+        out += snapped[i] == RoutingGraph::INVALID_NODE ? "null" : std::to_string(graph.osmId(snapped[i]));
+    }
+    // costs are meters or deciseconds
+    const bool byTime = metric == Metric::Duration;
+    out += byTime ? "],\"durations_s\":[" : "],\"distances_m\":[";
+    for (size_t i = 0; i < snapped.size(); ++i) {
+        if (i > 0) out += ',';
+        out += '[';
+        std::vector<double> row = distancesFrom(graph, snapped[i], snapped, ws, options);
+        for (size_t j = 0; j < row.size(); ++j) {
+            if (j > 0) out += ',';
+            appendNumber(out, byTime ? row[j] / 10.0 : row[j], byTime ? "%.1f" : "%.3f");
+        }
+        out += ']';
+    }
+    out += "]}";
+}
+
+// windows=open-close;...: minutes after departure, one entry per point, empty
+// for none. Fills windows only if some point has one.
+bool parseWindows(const std::string* s, size_t points, std::vector<TimeWindow>& windows, HttpResponse& res) {
+    if (!s) return true;
+    bool any = false;
+    size_t pos = 0;
+    while (pos <= s->size()) {
+        size_t semi = s->find(';', pos);
+        if (semi == std::string::npos) semi = s->size();
+        const std::string entry = s->substr(pos, semi - pos);
+        TimeWindow w;
+        if (!entry.empty()) {
+            const size_t dash = entry.find('-');
+            char* end1 = nullptr;
+            char* end2 = nullptr;
+            const double open = std::strtod(entry.c_str(), &end1);
+            const double close = dash == std::string::npos ? 0.0 : std::strtod(entry.c_str() + dash + 1, &end2);
+            if (dash == std::string::npos || end1 != entry.c_str() + dash || *end2 != '\0' || !(open >= 0.0) ||
+                !(close >= open)) {
+                setError(res, 400, "windows must be open-close minutes separated by ';'");
+                return false;
+            }
+            w = {open * 60.0, close * 60.0};
+            any = true;
+        }
+        windows.push_back(w);
+        pos = semi + 1;
+    }
+    if (windows.size() != points) {
+        setError(res, 400, "expected one window per point");
+        return false;
+    }
+    if (!any) windows.clear();
+    return true;
+}
+
+// Visiting order for points (the first is where the tour starts), then the road
+// route through them. The matrix rows and restarts use up to setTripThreads()
+// threads, so one large trip does not hold a worker for its whole solve.
+void handleTrip(const RoutingGraph& graph, const SearchOptions& live, const HttpRequest& req, HttpResponse& res) {
+    thread_local SearchWorkspace ws;
+
+    SearchOptions options = live;
+    if (!parseSearchOptions(req, options, res)) return;
+    std::vector<NodeIndex> snapped;
+    if (!parsePoints(graph, req, options.profile, MAX_TRIP_POINTS, snapped, res)) return;
+
+    TourOptions tour;
+    tour.threads = g_tripThreads.load();
+    const std::string* roundTrip = req.param("roundtrip");
+    const std::string* fixedEnd = req.param("fixed_end");
+    tour.roundTrip = !roundTrip || *roundTrip != "false";
+    tour.fixedEnd = fixedEnd && *fixedEnd == "true";
+    if (tour.fixedEnd && tour.roundTrip) {
+        setError(res, 400, "fixed_end needs roundtrip=false");
+        return;
+    }
+    if (const std::string* service = req.param("service")) {
+        char* end = nullptr;
+        tour.serviceSeconds = std::strtod(service->c_str(), &end);
+        if (service->empty() || *end != '\0' || !(tour.serviceSeconds >= 0.0)) {
+            setError(res, 400, "service must be seconds >= 0");
+            return;
+        }
+    }
+    if (!parseWindows(req.param("windows"), snapped.size(), tour.windows, res)) return;
+    if (!tour.windows.empty() && options.metric != Metric::Duration) {
+        setError(res, 400, "windows need metric=duration");
+        return;
+    }
+    for (NodeIndex n : snapped) {
+        if (n == RoutingGraph::INVALID_NODE) {
+            setError(res, 404, "no road near a point");
+            return;
+        }
+    }
+
+    const std::vector<std::vector<double>> matrix = costMatrix(graph, snapped, options, tour.threads);
+    const Tour best = solveTour(matrix, tour);
+    std::vector<NodeIndex> path;
+    if (best.reachable) path = tourPath(graph, snapped, best, ws, options, tour.roundTrip);
+
+    std::string& out = res.body;
+    out.reserve(64 + path.size() * 24);
+    out += "{\"found\":";
+    out += path.empty() ? "false" : "true";
+    out += ",\"order\":[";
+    for (size_t i = 0; i < best.order.size(); ++i) {
+        if (i > 0) out += ',';
+        out += std::to_string(best.order[i]);
+    }
+    out += ']';
+    const double INF = std::numeric_limits<double>::infinity();
+    PathLength length = measurePath(graph, path, options.metric, options.profile, options.traffic, options.departure,
+                                    options.overrides);
+    out += ",\"distance_m\":";
+    appendNumber(out, path.empty() ? INF : length.meters, "%.3f");
+    out += ",\"duration_s\":";
+    appendNumber(out, path.empty() ? INF : length.seconds, "%.1f");
+    if (options.metric == Metric::Duration) {
+        // arrivals follow the order, then the return to the first point for a round trip
+        out += ",\"late_s\":";
+        appendNumber(out, best.lateSeconds, "%.1f");
+        out += ",\"arrivals_s\":[";
+        for (size_t i = 0; i < best.arrivals.size(); ++i) {
+            if (i > 0) out += ',';
+            appendNumber(out, best.arrivals[i], "%.1f");
+        }
+        out += ']';
+    }
+    out += ",\"coordinates\":";
+    appendCoordinates(out, graph, path);
+    out += '}';
+}
+
+void handleCache(const GraphCache* graphCache, HttpResponse& res) {
+    const RouteCache::Stats stats = graphCache ? graphCache->cache.stats() : RouteCache::Stats{};
+    std::string& out = res.body;
+    out += "{\"enabled\":";
+    out += graphCache ? "true" : "false";
+    out += ",\"hits\":";
+    out += std::to_string(stats.hits);
+    out += ",\"misses\":";
+    out += std::to_string(stats.misses);
+    out += ",\"hit_rate\":";
+    appendNumber(out, stats.hitRate(), "%.4f");
+    out += ",\"insertions\":";
+    out += std::to_string(stats.insertions);
+    out += ",\"evictions\":";
+    out += std::to_string(stats.evictions);
+    out += ",\"entries\":";
+    out += std::to_string(stats.entries);
+    out += ",\"bytes\":";
+    out += std::to_string(stats.bytes);
+    out += ",\"path_nodes\":";
+    out += std::to_string(stats.pathNodes);
+    out += '}';
+}
+
+// Body: one "<from>,<to>,<factor>|closed|open" update per line, applied as one
+// new generation of overrides.
+void handleWeights(const RoutingGraph& graph, const HttpRequest& req, HttpResponse& res) {
+    std::istringstream in(req.body);
+    std::vector<WeightOverrides::Update> batch;
+    size_t unmatched = 0;
+    std::string error;
+    if (!parseWeightUpdates(graph, in, batch, unmatched, error)) {
+        setError(res, 400, error.c_str());
+        return;
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    std::shared_ptr<const WeightOverrides> overrides = applyWeightUpdates(graph, batch);
+    const double applyMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    if (!overrides) {
+        setError(res, 500, "could not apply updates");
+        return;
+    }
+
+    std::string& out = res.body;
+    out += "{\"generation\":";
+    out += std::to_string(overrides->generation());
+    out += ",\"updates\":";
+    out += std::to_string(batch.size());
+    out += ",\"unmatched\":";
+    out += std::to_string(unmatched);
+    out += ",\"overridden_edges\":";
+    out += std::to_string(overrides->overriddenEdges());
+    out += ",\"closed_edges\":";
+    out += std::to_string(overrides->closedEdges());
+    out += ",\"apply_ms\":";
+    appendNumber(out, applyMs, "%.3f");
+    out += '}';
+}
+
+} // namespace
+
+void handleRouteRequest(const HttpRequest& req, HttpResponse& res) {
+    const bool update = req.path == "/weights";
+    if (req.method != (update ? "POST" : "GET")) {
+        setError(res, 405, update ? "/weights takes POST" : "only GET is supported");
+        return;
+    }
+
+    // one snapshot per request: a graph published mid-request does not affect it
+    std::shared_ptr<const RoutingGraph> graph = currentGraph();
+    if (!graph) {
+        setError(res, 500, "no graph loaded");
+        return;
+    }
+
+    if (update) {
+        handleWeights(*graph, req, res);
+        return;
+    }
+
+    // traffic belongs to one graph; ignore it while a new graph is being swapped in
+    std::shared_ptr<const TrafficModel> traffic = currentTraffic();
+    if (traffic && traffic->edgeCount() != graph->edgeCount()) traffic.reset();
+    // the overrides generation current now serves the whole request, however many follow
+    const WeightSnapshot weights;
+    SearchOptions live;
+    live.traffic = traffic.get();
+    live.overrides = weights.get(*graph);
+
+    const std::shared_ptr<GraphCache> graphCache = cacheFor(graph);
+    // answers() checks the hierarchy was built for this graph
+    const std::shared_ptr<const ContractionHierarchy> hierarchy = currentHierarchy();
+    if (req.path == "/route")
+        handleRoute(*graph, live, graphCache ? &graphCache->cache : nullptr, hierarchy.get(), req, res);
+    else if (req.path == "/nearest") handleNearest(*graph, req, res);
+    else if (req.path == "/table") handleTable(*graph, live, req, res);
+    else if (req.path == "/trip") handleTrip(*graph, live, req, res);
+    else if (req.path == "/cache") handleCache(graphCache.get(), res);
+    else setError(res, 404, "unknown endpoint");
+}
+
+void setRouteCacheCapacity(size_t bytes) {
+    g_cacheBytes.store(bytes);
+    std::atomic_store(&g_graphCache, std::shared_ptr<GraphCache>());
+}
+
+void setTripThreads(size_t threads) {
+    g_tripThreads.store(threads);
+}
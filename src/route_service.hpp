@@ -0,0 +1,42 @@
+#ifndef ROUTE_SERVICE_HPP
+#define ROUTE_SERVICE_HPP
+
+#include <cstddef>
+
+#include "http_server.hpp"
+
+// HTTP endpoints over the graph published with publishGraph():
+//   GET /route?from=lat,lon&to=lat,lon   (or ?start=<node id>&goal=<node id>)
+//   GET /nearest?lat=..&lon=..
+//   GET /table?points=lat,lon;lat,lon;...
+//   GET /trip?points=lat,lon;lat,lon;...
+//   GET /cache
+//   POST /weights   body: one "<from node>,<to node>,<factor>|closed|open" per line
+// /route, /table and /trip take metric=duration (default) or metric=distance.
+// /route with alternatives=1..3 also returns up to that many alternative routes.
+// /route with weight=<w> (weighted A*), max_settled=<n> or max_ms=<ms> answers
+// within that budget and reports a status: optimal, bounded (within weight of
+// the best), partial (out of budget, route towards the goal) or unreachable.
+// /trip orders up to 50 points starting from the first: roundtrip=false ends
+// anywhere (fixed_end=true: at the last point), windows=open-close;... in
+// minutes after departure per point, service=<s> spent at each.
+// With traffic published (publishTraffic()), /route, /table and /trip leave at depart=hh:mm, or now.
+// /weights applies a batch of closures and slowdowns (see WeightOverrides) as a
+// new generation; requests already running keep the generation they started with.
+// Repeated exact /route queries are answered from a RouteCache of the current
+// graph (not under traffic, whose answers depend on the departure time);
+// /cache reports its hit counters.
+// Plain exact /route queries that a published ContractionHierarchy
+// (publishHierarchy()) answers() are routed through it instead of astar().
+// Each worker thread keeps its own search workspace; the graph itself is only read,
+// and each request works on the snapshot returned by currentGraph().
+void handleRouteRequest(const HttpRequest& req, HttpResponse& res);
+
+// Bytes for the route cache (0 turns it off); drops what is cached so far.
+void setRouteCacheCapacity(size_t bytes);
+
+// Threads each /trip request spreads its cost matrix and restarts over
+// (0: one per core, the default).
+void setTripThreads(size_t threads);
+
+#endif
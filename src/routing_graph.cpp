@@ -0,0 +1,506 @@
+#include "routing_graph.hpp"
+#include "osm_graph_handler.hpp"
+#include "binary_io.hpp"
+#include "geo.hpp"
+#include "osm_tags.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+#include <cstdlib>
+#include <string_view>
+#include <osmium/io/any_input.hpp>
+#include <osmium/handler.hpp>
+#include <osmium/visitor.hpp>
+#include <osmium/osm/relation.hpp>
+
+bool parseMetric(const std::string& name, Metric& metric) {
+    if (name == "distance" || name == "shortest") metric = Metric::Distance;
+    else if (name == "duration" || name == "fastest") metric = Metric::Duration;
+    else return false;
+    return true;
+}
+
+bool RoutingGraph::Builder::addEdge(int64_t fromOsmId, int64_t toOsmId, double distance, const ProfileSpeeds& speedKmh,
+                                    int64_t wayId) {
+    if (!hasNode(fromOsmId) || !hasNode(toOsmId)) return false;
+    RawEdge edge{fromOsmId, toOsmId, static_cast<float>(distance), {}, 0, wayId};
+    for (size_t p = 0; p < PROFILE_COUNT; ++p) {
+        if (speedKmh[p] <= 0.0) continue;
+        // meters / (km/h / 3.6) seconds, times 10 for deciseconds. Rounded up so the
+        // distance / max-speed heuristic stays admissible, and at least 1 per edge.
+        double ds = std::ceil(distance * 36.0 / speedKmh[p]);
+        edge.durations[p] = static_cast<uint32_t>(std::max(1.0, std::min(ds, 4.0e9)));
+        edge.profiles |= static_cast<uint8_t>(1u << p);
+        m_maxSpeedKmh[p] = std::max(m_maxSpeedKmh[p], speedKmh[p]);
+    }
+    if (edge.profiles == 0) return false;
+    m_edges.push_back(edge);
+    return true;
+}
+
+std::shared_ptr<const RoutingGraph> RoutingGraph::Builder::build() {
+    std::shared_ptr<RoutingGraph> g(new RoutingGraph());
+
+    std::vector<int64_t> edgeWays;
+    compressChains(*g, edgeWays);
+    g->m_maxSpeedKmh = m_maxSpeedKmh;
+    g->computeUnitVectors();
+    g->computeComponents();
+    g->computeBearings();
+    g->computeIncoming();
+    g->resolveRestrictions(m_restrictions, edgeWays);
+
+    std::pmr::unordered_map<int64_t, FixedCoord>(&m_arena).swap(m_coords);
+    m_arena.release();
+    m_edges.clear();
+    m_restrictions.clear();
+    return g;
+}
+
+// Parses "50", "50 km/h" and "30 mph". Returns 0 for anything else
+// ("none", "walk", "PK:urban", ...), which falls back to the highway default.
+static double parseMaxspeedKmh(const char* tag) {
+    if (!tag) return 0.0;
+    char* end = nullptr;
+    double v = std::strtod(tag, &end);
+    if (end == tag || v <= 0.0) return 0.0;
+    while (*end == ' ') ++end;
+    if (std::strncmp(end, "mph", 3) == 0) v *= 1.609344;
+    else if (*end != '\0' && std::strncmp(end, "km/h", 4) != 0 && std::strncmp(end, "kmh", 3) != 0) return 0.0;
+    return std::min(v, 150.0);
+}
+
+void OsmGraphHandler::node(const osmium::Node& node) {
+    if (node.location().valid()) {
+        m_builder.addNode(node.id(), {node.location().y(), node.location().x()});
+    }
+}
+
+void OsmGraphHandler::way(const osmium::Way& way) {
+    // speeds along and against the way's node order, 0 where a profile
+    // may not go (access tags, highway class or oneway)
+    const HighwayClass cls = classifyHighway(way.tags()["highway"]);
+    double carSpeed = parseMaxspeedKmh(way.tags()["maxspeed"]);
+    if (carSpeed <= 0.0) carSpeed = defaultSpeedKmh(cls);
+
+    ProfileSpeeds forward{}, backward{};
+    bool any = false;
+    for (size_t p = 0; p < PROFILE_COUNT; ++p) {
+        const Profile profile = static_cast<Profile>(p);
+        if (!profileAllowed(profile, cls, way.tags())) continue;
+        const double speed = profileSpeedKmh(profile, cls, carSpeed);
+        const Oneway oneway = profileOneway(profile, way.tags());
+        if (oneway != Oneway::Reverse) forward[p] = speed;
+        if (oneway != Oneway::Forward) backward[p] = speed;
+        any = true;
+    }
+    if (!any) return;
+
+    const osmium::WayNodeList& wnl = way.nodes();
+    m_segmentIds.clear();
+    m_segmentFrom.clear();
+    m_segmentTo.clear();
+    for (auto it = wnl.begin(); it != wnl.end() && std::next(it) != wnl.end(); ++it) {
+        int64_t id1 = it->ref();
+        int64_t id2 = std::next(it)->ref();
+        if (!m_builder.hasNode(id1) || !m_builder.hasNode(id2)) continue; // skip if coordinates unknown
+        m_segmentIds.push_back({id1, id2});
+        m_segmentFrom.push_back(m_builder.coord(id1));
+        m_segmentTo.push_back(m_builder.coord(id2));
+    }
+    m_segmentLengths.resize(m_segmentIds.size());
+    haversineBatch(m_segmentFrom.data(), m_segmentTo.data(), m_segmentIds.size(), m_segmentLengths.data());
+
+    // one edge per direction some profile may travel; addEdge() drops the other
+    for (size_t i = 0; i < m_segmentIds.size(); ++i) {
+        int64_t id1 = m_segmentIds[i].first;
+        int64_t id2 = m_segmentIds[i].second;
+        double d = m_segmentLengths[i];
+        m_builder.addEdge(id1, id2, d, forward, way.id());
+        m_builder.addEdge(id2, id1, d, backward, way.id());
+    }
+}
+
+// Whether an except=... list (";"-separated) names a key that covers p, e.g.
+// motor_vehicle for motorbikes.
+static bool exceptsProfile(const char* list, Profile p) {
+    if (!list) return false;
+    const auto keys = accessKeys(p);
+    std::string_view rest(list);
+    while (!rest.empty()) {
+        const size_t end = std::min(rest.find(';'), rest.size());
+        std::string_view item = rest.substr(0, end);
+        while (!item.empty() && item.front() == ' ') item.remove_prefix(1);
+        while (!item.empty() && item.back() == ' ') item.remove_suffix(1);
+        for (const char* key : keys) {
+            if (key && std::strcmp(key, "access") != 0 && item == key) return true;
+        }
+        rest.remove_prefix(std::min(end + 1, rest.size()));
+    }
+    return false;
+}
+
+// type=restriction relations, for each profile that obeys them:
+// restriction:motorcar / restriction:motorcycle for that vehicle alone, else
+// the plain restriction unless except= exempts the vehicle. Resolved against
+// the edges in Builder::build().
+void OsmGraphHandler::relation(const osmium::Relation& rel) {
+    const char* type = rel.tags()["type"];
+    if (!type || std::strcmp(type, "restriction") != 0) return;
+
+    const char* general = rel.tags()["restriction"];
+    const char* except = rel.tags()["except"];
+    std::array<const char*, PROFILE_COUNT> values{};
+    bool any = false;
+    for (size_t p = 0; p < PROFILE_COUNT; ++p) {
+        const Profile profile = static_cast<Profile>(p);
+        if (!obeysTurnRestrictions(profile)) continue;
+        const std::string own = std::string("restriction:") + accessKeys(profile)[0];
+        values[p] = rel.tags()[own.c_str()];
+        if (!values[p] && !exceptsProfile(except, profile)) values[p] = general;
+        any = any || values[p];
+    }
+    if (!any) return; // conditional or other-vehicle restrictions only
+
+    RoutingGraph::Restriction r;
+    for (const auto& member : rel.members()) {
+        const char* role = member.role();
+        bool isWay = member.type() == osmium::item_type::way;
+        if (isWay && std::strcmp(role, "from") == 0) r.fromWay = member.ref();
+        else if (isWay && std::strcmp(role, "to") == 0) r.toWay = member.ref();
+        else if (isWay && std::strcmp(role, "via") == 0) r.viaWays.push_back(member.ref());
+        else if (member.type() == osmium::item_type::node && std::strcmp(role, "via") == 0) r.viaNode = member.ref();
+    }
+    bool hasVia = (r.viaNode != 0) != !r.viaWays.empty();
+    if (!r.fromWay || !r.toWay || !hasVia) return;
+
+    // one restriction per distinct value, for every profile that has it
+    for (size_t p = 0; p < PROFILE_COUNT; ++p) {
+        if (!values[p]) continue;
+        const char* value = values[p];
+        uint8_t profiles = 0;
+        for (size_t q = p; q < PROFILE_COUNT; ++q) {
+            if (values[q] && std::strcmp(values[q], value) == 0) {
+                profiles |= profileBit(static_cast<Profile>(q));
+                values[q] = nullptr;
+            }
+        }
+        if (std::strncmp(value, "only_", 5) == 0) r.only = true;
+        else if (std::strncmp(value, "no_", 3) == 0) r.only = false;
+        else continue;
+        r.profiles = profiles;
+        m_builder.addRestriction(r);
+    }
+}
+
+std::shared_ptr<const RoutingGraph> OsmGraphHandler::finish() {
+    auto graph = m_builder.build();
+    std::clog << "Map loaded successfully! Nodes: " << graph->nodeCount()
+              << " (" << graph->coreNodeCount() << " junctions)"
+              << "  Edges: " << graph->edgeCount()
+              << "  Turn restrictions: " << graph->restrictionCount()
+              << "  Components: " << graph->componentCount() << "\n";
+    for (size_t p = 0; p < PROFILE_COUNT; ++p) {
+        const Profile profile = static_cast<Profile>(p);
+        size_t allowed = 0;
+        for (RoutingGraph::EdgeIndex e = 0; e < graph->edgeCount(); ++e) allowed += graph->edge(e).allows(profile);
+        std::clog << "  " << profileName(profile) << ": " << allowed << " edges, "
+                  << graph->componentCount(profile) << " components\n";
+    }
+    return graph;
+}
+
+std::shared_ptr<const RoutingGraph> RoutingGraph::fromOsm(const std::string& filename) {
+    try {
+        osmium::io::Reader reader(filename);
+        OsmGraphHandler handler;
+        osmium::apply(reader, handler);
+        reader.close();
+        return handler.finish();
+    } catch (const std::exception& e) {
+        std::cerr << "Error reading Karachi map: " << e.what() << "\n";
+        return nullptr;
+    }
+}
+
+// Graph file layout (native endianness): "RTGRAPH8", f64 maxSpeedKmh per
+// profile, u64 restrictionCount, u64 coreNodeCount, then each array as u64
+// length + raw elements in the order listed in save().
+static const char GRAPH_MAGIC[8] = {'R','T','G','R','A','P','H','8'};
+
+bool RoutingGraph::save(const std::string& filename) const {
+    std::ofstream out(filename, std::ios::binary);
+    if (!out) {
+        std::cerr << "Failed to open graph file for writing: " << filename << "\n";
+        return false;
+    }
+
+    out.write(GRAPH_MAGIC, sizeof(GRAPH_MAGIC));
+    out.write(reinterpret_cast<const char*>(m_maxSpeedKmh.data()), sizeof(m_maxSpeedKmh));
+    out.write(reinterpret_cast<const char*>(&m_restrictionCount), sizeof(m_restrictionCount));
+    out.write(reinterpret_cast<const char*>(&m_coreCount), sizeof(m_coreCount));
+    writeArray(out, m_osmIds);
+    writeArray(out, m_coords);
+    writeArray(out, m_offsets);
+    writeArray(out, m_edges);
+    for (const auto& durations : m_durations) writeArray(out, durations);
+    writeArray(out, m_shapeOffsets);
+    writeArray(out, m_shapePoints);
+    writeArray(out, m_shapeRefs);
+    writeArray(out, m_bearings);
+    writeArray(out, m_arrivalBearings);
+    writeArray(out, m_turnFlags);
+    writeArray(out, m_bannedTurns);
+    writeArray(out, m_bannedTurnProfiles);
+    writeArray(out, m_viaRoots);
+    writeArray(out, m_viaRootProfiles);
+    writeArray(out, m_viaRootStates);
+    writeArray(out, m_viaStates);
+    writeArray(out, m_viaChildren);
+    writeArray(out, m_viaExits);
+    return static_cast<bool>(out);
+}
+
+std::shared_ptr<const RoutingGraph> RoutingGraph::load(const std::string& filename) {
+    std::ifstream in(filename, std::ios::binary);
+    if (!in) {
+        std::cerr << "Failed to open graph file: " << filename << "\n";
+        return nullptr;
+    }
+
+    char magic[sizeof(GRAPH_MAGIC)];
+    if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, GRAPH_MAGIC, sizeof(magic)) != 0) {
+        std::cerr << "Not a route_tracer graph file (or an older format): " << filename << "\n";
+        return nullptr;
+    }
+
+    std::shared_ptr<RoutingGraph> g(new RoutingGraph());
+    bool ok = in.read(reinterpret_cast<char*>(g->m_maxSpeedKmh.data()), sizeof(g->m_maxSpeedKmh)) &&
+              in.read(reinterpret_cast<char*>(&g->m_restrictionCount), sizeof(g->m_restrictionCount)) &&
+              in.read(reinterpret_cast<char*>(&g->m_coreCount), sizeof(g->m_coreCount)) &&
+              readArray(in, g->m_osmIds) && readArray(in, g->m_coords) &&
+              readArray(in, g->m_offsets) && readArray(in, g->m_edges) &&
+              std::all_of(g->m_durations.begin(), g->m_durations.end(),
+                          [&](std::vector<uint32_t>& d) { return readArray(in, d); }) &&
+              readArray(in, g->m_shapeOffsets) && readArray(in, g->m_shapePoints) && readArray(in, g->m_shapeRefs) &&
+              readArray(in, g->m_bearings) && readArray(in, g->m_arrivalBearings) &&
+              readArray(in, g->m_turnFlags) && readArray(in, g->m_bannedTurns) &&
+              readArray(in, g->m_bannedTurnProfiles) && readArray(in, g->m_viaRoots) &&
+              readArray(in, g->m_viaRootProfiles) && readArray(in, g->m_viaRootStates) &&
+              readArray(in, g->m_viaStates) && readArray(in, g->m_viaChildren) && readArray(in, g->m_viaExits);
+
+    const size_t n = g->m_osmIds.size();
+    const size_t m = g->m_edges.size();
+    const bool durationsOk = std::all_of(g->m_durations.begin(), g->m_durations.end(),
+                                         [&](const std::vector<uint32_t>& d) { return d.size() == m; });
+    if (!ok || n >= INVALID_NODE || g->m_coords.size() != n || g->m_coreCount > n ||
+        g->m_offsets.size() != n + 1 || g->m_offsets.back() != m || !durationsOk ||
+        g->m_shapeOffsets.size() != m + 1 || g->m_shapeOffsets.back() != g->m_shapePoints.size() ||
+        g->m_shapeRefs.size() != (n - g->m_coreCount) * 2 ||
+        g->m_bearings.size() != m || g->m_arrivalBearings.size() != m || !g->indicesInRange()) {
+        std::cerr << "Truncated or corrupt graph file: " << filename << "\n";
+        return nullptr;
+    }
+    for (uint8_t profiles : g->m_bannedTurnProfiles) g->m_restrictedProfiles |= profiles;
+    for (uint8_t profiles : g->m_viaRootProfiles) g->m_restrictedProfiles |= profiles;
+    g->computeUnitVectors();
+    g->computeComponents();
+    g->computeIncoming();
+    return g;
+}
+
+// Whether every index stored in the arrays points inside the array it
+// indexes, so searches on a loaded file cannot read out of bounds. Assumes
+// the array sizes were checked.
+bool RoutingGraph::indicesInRange() const {
+    const size_t n = m_osmIds.size();
+    const size_t m = m_edges.size();
+    const size_t states = m_viaStates.size();
+    if (!std::is_sorted(m_offsets.begin(), m_offsets.end()) || m_offsets.front() != 0 ||
+        !std::is_sorted(m_shapeOffsets.begin(), m_shapeOffsets.end()) || m_shapeOffsets.front() != 0)
+        return false;
+    for (const Edge& e : m_edges) {
+        if (e.to >= n) return false;
+    }
+    for (const ShapePoint& p : m_shapePoints) {
+        if (p.node >= n) return false;
+    }
+    for (const ShapeRef& r : m_shapeRefs) {
+        if (r.edge != INVALID_EDGE && (r.edge >= m || r.index >= m_shapeOffsets[r.edge + 1] - m_shapeOffsets[r.edge]))
+            return false;
+    }
+
+    // turn restrictions: flags per edge whenever there are any
+    if (!m_turnFlags.empty() && m_turnFlags.size() != m) return false;
+    if (m_turnFlags.empty() && hasTurnRestrictions()) return false;
+    for (uint64_t key : m_bannedTurns) {
+        if ((key >> 32) >= m) return false;
+    }
+    if (m_bannedTurnProfiles.size() != m_bannedTurns.size() || m_viaRootProfiles.size() != m_viaRoots.size() ||
+        m_viaRootStates.size() != m_viaRoots.size())
+        return false;
+    for (uint32_t state : m_viaRootStates) {
+        if (state >= states) return false;
+    }
+    for (uint32_t state : m_viaChildren) {
+        if (state >= states) return false;
+    }
+    for (EdgeIndex e : m_viaExits) {
+        if (e >= m) return false;
+    }
+    for (const ViaState& vs : m_viaStates) {
+        if (vs.edge >= m || uint64_t(vs.firstChild) + vs.childCount > m_viaChildren.size() ||
+            uint64_t(vs.firstExit) + vs.exitCount > m_viaExits.size())
+            return false;
+    }
+    return true;
+}
+
+RoutingGraph::NodeIndex RoutingGraph::indexOf(int64_t osmId) const {
+    // core and shape nodes are sorted separately
+    auto core = m_osmIds.begin() + static_cast<std::ptrdiff_t>(m_coreCount);
+    auto it = std::lower_bound(m_osmIds.begin(), core, osmId);
+    if (it == core || *it != osmId) {
+        it = std::lower_bound(core, m_osmIds.end(), osmId);
+        if (it == m_osmIds.end() || *it != osmId) return INVALID_NODE;
+    }
+    return static_cast<NodeIndex>(it - m_osmIds.begin());
+}
+
+size_t RoutingGraph::shapeRefs(NodeIndex u, ShapeRef out[2], Profile p) const {
+    if (isCore(u)) return 0;
+    const ShapeRef* refs = &m_shapeRefs[(u - m_coreCount) * 2];
+    size_t count = 0;
+    for (int k = 0; k < 2; ++k) {
+        if (refs[k].edge != INVALID_EDGE && m_edges[refs[k].edge].allows(p)) out[count++] = refs[k];
+    }
+    return count;
+}
+
+bool RoutingGraph::segmentCost(NodeIndex u, NodeIndex v, Metric metric, Profile p, float& meters,
+                               uint32_t& deciseconds, EdgeIndex* edge) const {
+    // (edge, position of u in its shape; -1 for the tail) pairs that u starts a segment from
+    const size_t slot = profileSlot(p);
+    bool found = false;
+    auto consider = [&](EdgeIndex e, int64_t at) {
+        if (!m_edges[e].allows(p)) return;
+        const ShapeRange s = shape(e);
+        const size_t next = static_cast<size_t>(at + 1);
+        const NodeIndex nextNode = next < s.size() ? s[next].node : m_edges[e].to;
+        if (nextNode != v) return;
+        float d = next < s.size() ? s[next].distance : m_edges[e].distance;
+        uint32_t t = next < s.size() ? s[next].durations[slot] : m_durations[slot][e];
+        if (at >= 0) {
+            d -= s[static_cast<size_t>(at)].distance;
+            t -= s[static_cast<size_t>(at)].durations[slot];
+        }
+        // parallel segments can exist; take the one a search would use
+        bool better = metric == Metric::Distance ? d < meters : t < deciseconds;
+        if (!found || better) {
+            meters = d;
+            deciseconds = t;
+            if (edge) *edge = e;
+            found = true;
+        }
+    };
+
+    if (isCore(u)) {
+        for (uint32_t e = m_offsets[u]; e < m_offsets[u + 1]; ++e) consider(e, -1);
+    } else {
+        ShapeRef refs[2];
+        size_t count = shapeRefs(u, refs, p);
+        for (size_t k = 0; k < count; ++k) consider(refs[k].edge, refs[k].index);
+    }
+    return found;
+}
+
+RoutingGraph::EdgeIndex RoutingGraph::segmentEdge(NodeIndex u, NodeIndex v) const {
+    EdgeIndex e = INVALID_EDGE;
+    if (u >= nodeCount() || v >= nodeCount()) return e;
+    float meters;
+    uint32_t deciseconds;
+    for (size_t slot = 0; slot < PROFILE_COUNT && e == INVALID_EDGE; ++slot) {
+        segmentCost(u, v, Metric::Distance, static_cast<Profile>(slot), meters, deciseconds, &e);
+    }
+    return e;
+}
+
+RoutingGraph::NodeIndex RoutingGraph::nearestNode(double lat, double lon, Profile p) const {
+    if (nodeCount() == 0) return INVALID_NODE;
+    const FixedCoord query = toFixedCoord(lat, lon);
+    float qx, qy, qz;
+    projectToUnitSphere(&query, 1, &qx, &qy, &qz);
+    const NodeIndex nearest = static_cast<NodeIndex>(nearestByChord(m_unitX.data(), m_unitY.data(), m_unitZ.data(),
+                                                                    nodeCount(), qx, qy, qz));
+    const Reachability& reach = m_reach[profileSlot(p)];
+    if (reach.mainNodes.empty() || inMainComponent(nearest, p)) return nearest;
+
+    // a stub or island node is closest, or one p cannot use at all; take the
+    // main network unless it is clearly farther
+    const NodeIndex main = reach.mainNodes[nearestByChord(reach.mainUnitX.data(), reach.mainUnitY.data(),
+                                                          reach.mainUnitZ.data(), reach.mainNodes.size(), qx, qy, qz)];
+    if (!(m_nodeProfiles[nearest] & profileBit(p))) return main;
+    if (haversine(query, m_coords[main]) <= haversine(query, m_coords[nearest]) + SNAP_MAIN_SLACK_M) return main;
+    return nearest;
+}
+
+void RoutingGraph::computeUnitVectors() {
+    m_unitX.resize(nodeCount());
+    m_unitY.resize(nodeCount());
+    m_unitZ.resize(nodeCount());
+    projectToUnitSphere(m_coords.data(), nodeCount(), m_unitX.data(), m_unitY.data(), m_unitZ.data());
+}
+
+void RoutingGraph::computeBearings() {
+    auto bearingBetween = [&](NodeIndex a, NodeIndex b) {
+        double dLat = toDegrees(m_coords[b].lat - m_coords[a].lat);
+        double dLon = toDegrees(m_coords[b].lon - m_coords[a].lon) * std::cos(deg2rad(lat(a)));
+        double deg = std::atan2(dLon, dLat) * 180.0 / PI_CONST; // clockwise from north
+        if (deg < 0) deg += 360.0;
+        return static_cast<uint8_t>(static_cast<int>(std::lround(deg * 256.0 / 360.0)) & 0xFF);
+    };
+
+    m_bearings.resize(m_edges.size());
+    m_arrivalBearings.resize(m_edges.size());
+    for (NodeIndex u = 0; u < coreNodeCount(); ++u) {
+        for (const auto& e : edges(u)) {
+            const EdgeIndex i = edgeIndex(e);
+            const ShapeRange s = shape(i);
+            m_bearings[i] = bearingBetween(u, s.empty() ? e.to : s[0].node);
+            m_arrivalBearings[i] = bearingBetween(s.empty() ? u : s.back().node, e.to);
+        }
+    }
+}
+
+void RoutingGraph::computeIncoming() {
+    m_inOffsets.assign(nodeCount() + 1, 0);
+    for (const auto& e : m_edges) ++m_inOffsets[e.to + 1];
+    for (size_t i = 0; i < nodeCount(); ++i) m_inOffsets[i + 1] += m_inOffsets[i];
+
+    m_inEdges.resize(m_edges.size());
+    std::vector<uint32_t> cursor(m_inOffsets.begin(), m_inOffsets.end() - 1);
+    for (NodeIndex u = 0; u < coreNodeCount(); ++u) {
+        for (const auto& e : edges(u)) m_inEdges[cursor[e.to]++] = {u, edgeIndex(e)};
+    }
+}
+
+double RoutingGraph::heuristicScale(Metric metric, Profile p) const {
+    if (metric == Metric::Distance) return 1.0;
+    const double maxSpeed = m_maxSpeedKmh[profileSlot(p)];
+    if (maxSpeed <= 0.0) return 0.0;
+    // deciseconds per meter at p's fastest speed in the graph
+    return 36.0 / maxSpeed;
+}
+
+static std::shared_ptr<const RoutingGraph> g_currentGraph;
+
+std::shared_ptr<const RoutingGraph> currentGraph() {
+    return std::atomic_load(&g_currentGraph);
+}
+
+void publishGraph(std::shared_ptr<const RoutingGraph> graph) {
+    std::atomic_store(&g_currentGraph, std::move(graph));
+}
@@ -0,0 +1,352 @@
+#ifndef ROUTING_GRAPH_HPP
+#define ROUTING_GRAPH_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "distance_kernels.hpp"
+#include "geo.hpp"
+#include "profiles.hpp"
+
+// Which edge weight a search minimizes. Search costs are meters for Distance
+// and deciseconds for Duration.
+enum class Metric { Distance, Duration };
+
+// Accepts "distance" / "duration" (also "shortest" / "fastest").
+bool parseMetric(const std::string& name, Metric& metric);
+
+// Road network in compressed sparse row form. Nodes are dense indices; a
+// node's outgoing edges are m_edges[m_offsets[u] .. m_offsets[u+1]).
+//
+// Chains of degree-2 nodes are collapsed into single edges. Only core nodes
+// (junctions, dead ends, way boundaries and restriction via nodes) have edges;
+// they take indices [0, coreNodeCount()). The remaining shape nodes follow and
+// are listed, with the cost up to them, in the shape() of every edge that runs
+// through them. Both ranges are sorted by OSM id.
+//
+// One topology serves every Profile: each edge has a bitmask of the profiles
+// allowed on it and a travel time per profile (kept in separate arrays, so a
+// search only touches its own profile's times).
+//
+// A RoutingGraph is immutable once built and is only handed out as
+// shared_ptr<const RoutingGraph>, so any number of query threads, the viewer
+// and the HTTP service can read one instance without locking. Replacing the
+// graph means building a new one and publishing it with publishGraph().
+class RoutingGraph {
+public:
+    using NodeIndex = uint32_t;
+    using EdgeIndex = uint32_t;
+    // Edge-based search state: an edge id, or edgeCount() + i for the i-th
+    // partially travelled via-way restriction (see nextTurnState()).
+    using TurnState = uint32_t;
+    static constexpr NodeIndex INVALID_NODE = std::numeric_limits<NodeIndex>::max();
+    static constexpr TurnState INVALID_STATE = std::numeric_limits<TurnState>::max();
+    static constexpr EdgeIndex INVALID_EDGE = std::numeric_limits<EdgeIndex>::max();
+
+    struct Edge {
+        NodeIndex to;
+        float distance;   // meters
+        uint8_t profiles; // profileBit()s of the profiles allowed on it
+
+        bool allows(Profile p) const { return (profiles & profileBit(p)) != 0; }
+    };
+
+    struct EdgeRange {
+        const Edge* first;
+        const Edge* last;
+        const Edge* begin() const { return first; }
+        const Edge* end() const { return last; }
+        size_t size() const { return static_cast<size_t>(last - first); }
+    };
+
+    // Edge `edge` as seen from its head: it leaves core node `from`.
+    struct InEdge {
+        NodeIndex from;
+        EdgeIndex edge;
+    };
+
+    struct InEdgeRange {
+        const InEdge* first;
+        const InEdge* last;
+        const InEdge* begin() const { return first; }
+        const InEdge* end() const { return last; }
+        size_t size() const { return static_cast<size_t>(last - first); }
+    };
+
+    // Shape node inside an edge, with the cost from the edge's tail up to it.
+    struct ShapePoint {
+        NodeIndex node;
+        float distance;                                // meters
+        std::array<uint32_t, PROFILE_COUNT> durations; // deciseconds, by profileSlot()
+
+        double cost(Metric metric, Profile p) const {
+            return metric == Metric::Distance ? static_cast<double>(distance)
+                                              : static_cast<double>(durations[profileSlot(p)]);
+        }
+    };
+
+    struct ShapeRange {
+        const ShapePoint* first;
+        const ShapePoint* last;
+        const ShapePoint* begin() const { return first; }
+        const ShapePoint* end() const { return last; }
+        size_t size() const { return static_cast<size_t>(last - first); }
+        bool empty() const { return first == last; }
+        const ShapePoint& operator[](size_t i) const { return first[i]; }
+        const ShapePoint& back() const { return *(last - 1); }
+    };
+
+    // A shape node's position: shape(edge)[index].
+    struct ShapeRef {
+        EdgeIndex edge;
+        uint32_t index;
+    };
+
+    // OSM type=restriction relation. Exactly one of viaNode / viaWays is set.
+    struct Restriction {
+        int64_t fromWay = 0;
+        int64_t viaNode = 0;
+        std::vector<int64_t> viaWays;
+        int64_t toWay = 0;
+        bool only = false; // only_* (every other exit is banned) vs no_*
+        uint8_t profiles = 0; // profileBit()s of the profiles it binds
+    };
+
+    // Collects OSM nodes and directed edges, then compacts them into a graph.
+    // Only nodes that end up with at least one edge are kept.
+    class Builder {
+    public:
+        void addNode(int64_t osmId, FixedCoord coord) { m_coords[osmId] = coord; }
+        bool hasNode(int64_t osmId) const { return m_coords.count(osmId) != 0; }
+        // Returns false if either endpoint has no coordinates yet or no profile
+        // has a speed above 0. wayId ties the edge to its OSM way so restrictions
+        // can be resolved in build().
+        bool addEdge(int64_t fromOsmId, int64_t toOsmId, double distance, const ProfileSpeeds& speedKmh,
+                     int64_t wayId = 0);
+        void addRestriction(Restriction restriction) { m_restrictions.push_back(std::move(restriction)); }
+
+        // Compacts the collected edges into a graph with degree-2 chains collapsed.
+        std::shared_ptr<const RoutingGraph> build();
+
+        FixedCoord coord(int64_t osmId) const { return m_coords.at(osmId); }
+
+    private:
+        struct RawEdge {
+            int64_t from;
+            int64_t to;
+            float distance;
+            std::array<uint32_t, PROFILE_COUNT> durations;
+            uint8_t profiles;
+            int64_t wayId;
+        };
+        // Node coordinates are only ever added, then dropped together in
+        // build(): they come from a monotonic arena rather than one heap
+        // allocation per node.
+        std::pmr::monotonic_buffer_resource m_arena;
+        std::pmr::unordered_map<int64_t, FixedCoord> m_coords{&m_arena};
+        std::vector<RawEdge> m_edges;
+        std::vector<Restriction> m_restrictions;
+        std::array<double, PROFILE_COUNT> m_maxSpeedKmh{};
+
+        // Fills g's nodes, edges and shapes; edgeWays gets the OSM way of each edge.
+        void compressChains(RoutingGraph& g, std::vector<int64_t>& edgeWays) const;
+    };
+
+    RoutingGraph(const RoutingGraph&) = delete;
+    RoutingGraph& operator=(const RoutingGraph&) = delete;
+
+    // Parses the ways any profile may use from an OSM file. Returns nullptr on read errors.
+    static std::shared_ptr<const RoutingGraph> fromOsm(const std::string& filename);
+
+    // Binary dump, so headless tools can skip OSM parsing.
+    static std::shared_ptr<const RoutingGraph> load(const std::string& filename);
+    bool save(const std::string& filename) const;
+
+    size_t nodeCount() const { return m_osmIds.size(); }
+    size_t coreNodeCount() const { return m_coreCount; }
+    bool isCore(NodeIndex u) const { return u < m_coreCount; }
+    size_t edgeCount() const { return m_edges.size(); }
+
+    // INVALID_NODE if the id is not part of the graph.
+    NodeIndex indexOf(int64_t osmId) const;
+    int64_t osmId(NodeIndex u) const { return m_osmIds[u]; }
+    FixedCoord coord(NodeIndex u) const { return m_coords[u]; }
+    double lat(NodeIndex u) const { return toDegrees(m_coords[u].lat); }
+    double lon(NodeIndex u) const { return toDegrees(m_coords[u].lon); }
+
+    EdgeRange edges(NodeIndex u) const {
+        return { m_edges.data() + m_offsets[u], m_edges.data() + m_offsets[u + 1] };
+    }
+    EdgeIndex edgeIndex(const Edge& e) const { return static_cast<EdgeIndex>(&e - m_edges.data()); }
+    const Edge& edge(EdgeIndex e) const { return m_edges[e]; }
+    NodeIndex edgeTail(EdgeIndex e) const;
+    // Edges ending at core node v, for searches that run towards a goal.
+    InEdgeRange incoming(NodeIndex v) const {
+        return { m_inEdges.data() + m_inOffsets[v], m_inEdges.data() + m_inOffsets[v + 1] };
+    }
+    // Deciseconds along e at profile p's speed (meaningless if p is not allowed on e).
+    uint32_t duration(EdgeIndex e, Profile p) const { return m_durations[profileSlot(p)][e]; }
+    double cost(EdgeIndex e, Metric metric, Profile p) const {
+        return metric == Metric::Distance ? static_cast<double>(m_edges[e].distance)
+                                          : static_cast<double>(duration(e, p));
+    }
+
+    // Shape nodes between an edge's tail and head, in travel order.
+    ShapeRange shape(EdgeIndex e) const {
+        return { m_shapePoints.data() + m_shapeOffsets[e], m_shapePoints.data() + m_shapeOffsets[e + 1] };
+    }
+    // Edges allowing p that run through shape node u (one per direction of
+    // travel); returns how many of out[0..1] were filled, 0 for core nodes.
+    size_t shapeRefs(NodeIndex u, ShapeRef out[2], Profile p) const;
+    // Cost of the single OSM way segment u -> v for p, and the edge it is part
+    // of; false if p cannot go straight from u to v.
+    bool segmentCost(NodeIndex u, NodeIndex v, Metric metric, Profile p, float& meters, uint32_t& deciseconds,
+                     EdgeIndex* edge = nullptr) const;
+    // Edge containing the way segment u -> v for any profile, INVALID_EDGE if none.
+    EdgeIndex segmentEdge(NodeIndex u, NodeIndex v) const;
+
+    // Travel direction when leaving an edge's tail and when arriving at its head,
+    // 0..255 clockwise from north (256 steps per turn).
+    uint8_t bearing(EdgeIndex e) const { return m_bearings[e]; }
+    uint8_t arrivalBearing(EdgeIndex e) const { return m_arrivalBearings[e]; }
+
+    // Turn restrictions (for the profiles that obeysTurnRestrictions()), each
+    // for the profiles its relation names. Searches that honour them walk
+    // TurnStates instead of nodes.
+    bool hasTurnRestrictions() const { return !m_bannedTurns.empty() || !m_viaStates.empty(); }
+    bool hasTurnRestrictions(Profile p) const { return (m_restrictedProfiles & profileBit(p)) != 0; }
+    size_t restrictionCount() const { return m_restrictionCount; }
+    size_t turnStateCount() const { return m_edges.size() + m_viaStates.size(); }
+    EdgeIndex stateEdge(TurnState s) const {
+        return s < m_edges.size() ? s : m_viaStates[s - m_edges.size()].edge;
+    }
+    // State after leaving state `from` along edge `next` (which must start at
+    // stateEdge(from)'s head), or INVALID_STATE if that turn is forbidden for p.
+    TurnState nextTurnState(TurnState from, EdgeIndex next, Profile p) const;
+
+    // Nearest node p can use, preferring p's largest strongly connected
+    // component: a node outside it is only returned if it is more than
+    // SNAP_MAIN_SLACK_M closer. Vectorized linear scans; INVALID_NODE for an
+    // empty graph.
+    NodeIndex nearestNode(double lat, double lon, Profile p = Profile::Car) const;
+
+    // Profiles allowed on some edge at u.
+    uint8_t nodeProfiles(NodeIndex u) const { return m_nodeProfiles[u]; }
+
+    // Strongly connected components of the core nodes over the edges p may use
+    // (turn restrictions ignored), numbered so that a component only reaches
+    // lower-numbered ones.
+    size_t componentCount(Profile p = Profile::Car) const { return m_reach[profileSlot(p)].componentCount; }
+    uint32_t component(NodeIndex core, Profile p = Profile::Car) const {
+        return m_reach[profileSlot(p)].components[core];
+    }
+    bool inMainComponent(NodeIndex u, Profile p = Profile::Car) const {
+        const auto& main = m_reach[profileSlot(p)].mainNodes;
+        return std::binary_search(main.begin(), main.end(), u);
+    }
+    // False if p has no path from s to t; a constant number of lookups, so
+    // searches use it to reject pairs on separate islands or behind one-way exits.
+    bool mayReach(NodeIndex s, NodeIndex t, Profile p = Profile::Car) const;
+
+    // Never more than the great-circle distance between u and v, in meters.
+    // Two subtractions per axis on precomputed unit vectors, no trigonometry.
+    double lowerBoundMeters(NodeIndex u, NodeIndex v) const {
+        return chordLowerBound(m_unitX[u] - m_unitX[v], m_unitY[u] - m_unitY[v], m_unitZ[u] - m_unitZ[v]);
+    }
+
+    // Fastest speed of any edge for p. Straight-line meters times
+    // heuristicScale() never overestimates the remaining cost, so A* stays admissible.
+    double maxSpeedKmh(Profile p = Profile::Car) const { return m_maxSpeedKmh[profileSlot(p)]; }
+    double heuristicScale(Metric metric, Profile p = Profile::Car) const;
+
+private:
+    RoutingGraph() = default;
+
+    // Node of a via-way restriction prefix trie: reached by travelling the
+    // prefix's edges in order and currently standing on `edge`.
+    struct ViaState {
+        EdgeIndex edge;
+        uint32_t firstChild;  // into m_viaChildren (state ids, sorted by edge)
+        uint32_t childCount;
+        uint32_t firstExit;   // into m_viaExits
+        uint32_t exitCount;
+        uint32_t onlyExits;   // 1: exits are the only allowed ones, 0: exits are banned
+    };
+
+    // per-edge flags in m_turnFlags
+    static constexpr uint8_t TURN_HAS_BANS = 1;   // some (edge, next) pair is in m_bannedTurns
+    static constexpr uint8_t TURN_STARTS_VIA = 2; // some via-way prefix starts with this edge
+
+    // A node outside the main component must beat its nearest main node by this much.
+    static constexpr double SNAP_MAIN_SLACK_M = 100.0;
+
+    // Components of one profile and the nodes of its largest one, with their
+    // unit vectors for snapping.
+    struct Reachability {
+        std::vector<uint32_t> components;
+        std::vector<uint32_t> weakComponents;
+        uint32_t componentCount = 0;
+        std::vector<NodeIndex> mainNodes; // sorted
+        std::vector<float> mainUnitX;
+        std::vector<float> mainUnitY;
+        std::vector<float> mainUnitZ;
+    };
+
+    void computeBearings();
+    void computeUnitVectors();
+    void computeComponents();
+    void computeIncoming();
+    bool indicesInRange() const;
+    void resolveRestrictions(const std::vector<Restriction>& restrictions,
+                             const std::vector<int64_t>& edgeWays);
+
+    std::vector<int64_t> m_osmIds;  // core nodes first, see class comment
+    std::vector<FixedCoord> m_coords;
+    uint64_t m_coreCount = 0;
+    // unit-sphere projection of m_coords for lowerBoundMeters() / nearestNode();
+    // derived, so not part of the graph file
+    std::vector<float> m_unitX;
+    std::vector<float> m_unitY;
+    std::vector<float> m_unitZ;
+    // per-profile components and per-node profile masks; derived like the unit vectors above
+    std::array<Reachability, PROFILE_COUNT> m_reach;
+    std::vector<uint8_t> m_nodeProfiles;
+    std::vector<uint32_t> m_offsets; // nodeCount() + 1 entries, empty ranges for shape nodes
+    std::vector<Edge> m_edges;
+    // reverse adjacency, grouped by head like m_offsets / m_edges; derived, so not part of the graph file
+    std::vector<uint32_t> m_inOffsets;
+    std::vector<InEdge> m_inEdges;
+    std::array<std::vector<uint32_t>, PROFILE_COUNT> m_durations; // deciseconds per edge, by profileSlot()
+    std::vector<uint32_t> m_shapeOffsets; // edgeCount() + 1 entries into m_shapePoints
+    std::vector<ShapePoint> m_shapePoints;
+    std::vector<ShapeRef> m_shapeRefs;    // two per shape node, edge INVALID_EDGE if unused
+    std::vector<uint8_t> m_bearings;
+    std::vector<uint8_t> m_arrivalBearings;
+    std::array<double, PROFILE_COUNT> m_maxSpeedKmh{};
+
+    std::vector<uint8_t> m_turnFlags;       // one per edge, empty without restrictions
+    std::vector<uint64_t> m_bannedTurns;    // sorted (from edge << 32 | to edge) ...
+    std::vector<uint8_t> m_bannedTurnProfiles; // ... and the profiles each is banned for
+    std::vector<uint64_t> m_viaRoots;       // sorted (first edge << 32 | second edge) ...
+    std::vector<uint8_t> m_viaRootProfiles; // ... the profile whose restriction it starts ...
+    std::vector<uint32_t> m_viaRootStates;  // ... and the via state each pair leads to
+    std::vector<ViaState> m_viaStates;
+    std::vector<uint32_t> m_viaChildren;
+    std::vector<EdgeIndex> m_viaExits;
+    uint64_t m_restrictionCount = 0;
+    uint8_t m_restrictedProfiles = 0; // profiles with any restriction; derived, so not part of the graph file
+};
+
+// Process-wide graph slot. Readers take a snapshot and keep using it even if a
+// new graph is published concurrently; the old one is freed with its last reader.
+std::shared_ptr<const RoutingGraph> currentGraph();
+void publishGraph(std::shared_ptr<const RoutingGraph> graph);
+
+#endif
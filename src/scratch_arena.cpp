@@ -0,0 +1,26 @@
+#include "scratch_arena.hpp"
+
+ScratchArena::ScratchArena(size_t initialBytes)
+    : m_buffer(new std::byte[initialBytes]), m_size(initialBytes) {
+    m_arena.emplace(m_buffer.get(), m_size, &m_overflow);
+}
+
+std::pmr::memory_resource* ScratchArena::rewind() {
+    m_arena.reset(); // hands any overflow back to the heap
+    if (m_overflow.bytes > 0) {
+        m_size += m_overflow.bytes;
+        m_buffer.reset(new std::byte[m_size]);
+        m_overflow.bytes = 0;
+    }
+    m_arena.emplace(m_buffer.get(), m_size, &m_overflow);
+    return &*m_arena;
+}
+
+void* ScratchArena::Overflow::do_allocate(size_t n, size_t alignment) {
+    bytes += n;
+    return upstream->allocate(n, alignment);
+}
+
+void ScratchArena::Overflow::do_deallocate(void* p, size_t n, size_t alignment) {
+    upstream->deallocate(p, n, alignment);
+}
@@ -0,0 +1,47 @@
+#ifndef SCRATCH_ARENA_HPP
+#define SCRATCH_ARENA_HPP
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+
+// Scratch memory for one query at a time: a monotonic arena over a buffer
+// that is rewound, not freed, between queries. A query that outgrows the
+// buffer takes the rest from the heap, and the next rewind enlarges the buffer
+// to cover it, so a reused arena stops allocating once it has seen its
+// largest query.
+class ScratchArena {
+public:
+    explicit ScratchArena(size_t initialBytes = 16 * 1024);
+    ScratchArena(const ScratchArena&) = delete;
+    ScratchArena& operator=(const ScratchArena&) = delete;
+
+    // Drops everything allocated since the last rewind and returns the
+    // resource for the next query.
+    std::pmr::memory_resource* rewind();
+    std::pmr::memory_resource* resource() { return &*m_arena; }
+
+    size_t bufferBytes() const { return m_size; }
+
+private:
+    // Heap fallback that remembers how much the arena had to ask for; takes
+    // it from the default resource current when the arena was made.
+    class Overflow : public std::pmr::memory_resource {
+    public:
+        std::pmr::memory_resource* upstream = std::pmr::get_default_resource();
+        size_t bytes = 0;
+
+    private:
+        void* do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+    };
+
+    std::unique_ptr<std::byte[]> m_buffer;
+    size_t m_size;
+    Overflow m_overflow;
+    std::optional<std::pmr::monotonic_buffer_resource> m_arena;
+};
+
+#endif
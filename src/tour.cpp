@@ -0,0 +1,394 @@
+#include "tour.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <thread>
+
+namespace {
+
+constexpr double UNREACHABLE_LEG = 1e12; // stands in for +infinity so tours stay comparable
+constexpr double LATE_WEIGHT = 1e6;      // per second late: lateness outweighs any travel cost
+
+size_t threadCount(size_t requested, size_t jobs) {
+    size_t threads = requested ? requested : std::max(1u, std::thread::hardware_concurrency());
+    return std::max<size_t>(1, std::min(threads, jobs));
+}
+
+// Runs job(worker, i) for i in [0, count) on up to `threads` threads;
+// worker < threadCount(threads, count) names the thread.
+template <typename Job>
+void parallelFor(size_t count, size_t threads, Job job) {
+    threads = threadCount(threads, count);
+    if (threads == 1) {
+        for (size_t i = 0; i < count; ++i) job(0, i);
+        return;
+    }
+    std::atomic<size_t> next{0};
+    std::vector<std::thread> pool;
+    for (size_t t = 0; t < threads; ++t) {
+        pool.emplace_back([&, t] {
+            for (size_t i = next++; i < count; i = next++) job(t, i);
+        });
+    }
+    for (auto& th : pool) th.join();
+}
+
+// Scores visiting orders. Orders start with stop 0; for open tours with a
+// fixed end they finish with the last stop.
+class TourScorer {
+public:
+    TourScorer(const std::vector<std::vector<double>>& matrix, const TourOptions& options)
+        : m_matrix(matrix), m_options(options) {}
+
+    double leg(size_t a, size_t b) const {
+        const double c = m_matrix[a][b];
+        return std::isinf(c) ? UNREACHABLE_LEG : c;
+    }
+
+    // Travel cost plus weighted lateness; fills tour's figures if given.
+    double score(const std::vector<size_t>& order, Tour* tour = nullptr) const {
+        const bool windows = !m_options.windows.empty();
+        double cost = 0.0, late = 0.0, seconds = 0.0;
+        bool reachable = true;
+        if (tour) tour->arrivals.assign(1, 0.0);
+        auto travel = [&](size_t from, size_t to) {
+            const double c = leg(from, to);
+            reachable = reachable && c < UNREACHABLE_LEG;
+            cost += c;
+            seconds += c / 10.0;
+        };
+        for (size_t k = 1; k < order.size(); ++k) {
+            travel(order[k - 1], order[k]);
+            if (windows) {
+                const TimeWindow& w = m_options.windows[order[k]];
+                seconds = std::max(seconds, w.open);
+                late += std::max(0.0, seconds - w.close);
+            }
+            if (tour) tour->arrivals.push_back(seconds);
+            seconds += m_options.serviceSeconds;
+        }
+        if (m_options.roundTrip && order.size() > 1) {
+            travel(order.back(), order[0]);
+            // the first stop's window is when the tour has to be back
+            if (windows) late += std::max(0.0, seconds - m_options.windows[order[0]].close);
+            if (tour) tour->arrivals.push_back(seconds);
+        }
+        if (tour) {
+            tour->order = order;
+            tour->cost = cost;
+            tour->lateSeconds = late;
+            tour->reachable = reachable;
+        }
+        return cost + LATE_WEIGHT * late;
+    }
+
+    // Stops a construction may place anywhere: all but the first (and the fixed last).
+    std::vector<size_t> freeStops() const {
+        std::vector<size_t> stops;
+        for (size_t s = 1; s < m_matrix.size(); ++s) {
+            if (!(fixedLast() && s + 1 == m_matrix.size())) stops.push_back(s);
+        }
+        return stops;
+    }
+
+    bool fixedLast() const { return !m_options.roundTrip && m_options.fixedEnd && m_matrix.size() > 1; }
+    bool hasWindows() const { return !m_options.windows.empty(); }
+    bool roundTrip() const { return m_options.roundTrip; }
+
+    std::vector<size_t> frame() const {
+        std::vector<size_t> order{0};
+        if (fixedLast()) order.push_back(m_matrix.size() - 1);
+        return order;
+    }
+
+private:
+    const std::vector<std::vector<double>>& m_matrix;
+    const TourOptions& m_options;
+};
+
+// Nearest neighbour from the first stop; with rng, a random one of the
+// three nearest at each step.
+std::vector<size_t> nearestNeighbour(const TourScorer& scorer, std::mt19937* rng) {
+    std::vector<size_t> order = scorer.frame();
+    std::vector<size_t> left = scorer.freeStops();
+    const size_t tail = scorer.fixedLast() ? 1 : 0; // keep the fixed last stop at the end
+    while (!left.empty()) {
+        const size_t from = order[order.size() - 1 - tail];
+        std::sort(left.begin(), left.end(), [&](size_t a, size_t b) { return scorer.leg(from, a) < scorer.leg(from, b); });
+        const size_t pick = rng ? (*rng)() % std::min<size_t>(3, left.size()) : 0;
+        order.insert(order.end() - tail, left[pick]);
+        left.erase(left.begin() + pick);
+    }
+    return order;
+}
+
+// Inserts stops one at a time (in the given sequence) where they score best.
+std::vector<size_t> cheapestInsertion(const TourScorer& scorer, const std::vector<size_t>& sequence) {
+    std::vector<size_t> order = scorer.frame();
+    const size_t tail = scorer.fixedLast() ? 1 : 0;
+    for (size_t stop : sequence) {
+        size_t bestAt = order.size() - tail;
+        double best = std::numeric_limits<double>::infinity();
+        for (size_t at = 1; at <= order.size() - tail; ++at) {
+            order.insert(order.begin() + at, stop);
+            const double s = scorer.score(order);
+            order.erase(order.begin() + at);
+            if (s < best) {
+                best = s;
+                bestAt = at;
+            }
+        }
+        order.insert(order.begin() + bestAt, stop);
+    }
+    return order;
+}
+
+// Leg costs along an order, summed from the start walking forwards and
+// walking every leg backwards, so moves on tours without windows are priced
+// in O(1): reversing a stretch of one-way legs costs the difference of two
+// backward sums. NONE stands for "no next stop" at the end of an open tour.
+class LegSums {
+public:
+    static constexpr size_t NONE = SIZE_MAX;
+
+    explicit LegSums(const TourScorer& scorer) : m_scorer(scorer) {}
+
+    void update(const std::vector<size_t>& order) {
+        m_forward.assign(order.size(), 0.0);
+        m_backward.assign(order.size(), 0.0);
+        for (size_t k = 1; k < order.size(); ++k) {
+            m_forward[k] = m_forward[k - 1] + m_scorer.leg(order[k - 1], order[k]);
+            m_backward[k] = m_backward[k - 1] + m_scorer.leg(order[k], order[k - 1]);
+        }
+    }
+
+    double link(size_t a, size_t b) const { return b == NONE ? 0.0 : m_scorer.leg(a, b); }
+    // the legs between positions i and j, in order or walked the other way
+    double inside(size_t i, size_t j, bool reversed) const {
+        return reversed ? m_backward[j] - m_backward[i] : m_forward[j] - m_forward[i];
+    }
+    // stop after position k
+    size_t next(const std::vector<size_t>& order, size_t k) const {
+        if (k + 1 < order.size()) return order[k + 1];
+        return m_scorer.roundTrip() ? order[0] : NONE;
+    }
+
+private:
+    const TourScorer& m_scorer;
+    std::vector<double> m_forward;
+    std::vector<double> m_backward;
+};
+
+// Moves the run order[i, i + len) so it starts at position `at` of the order
+// without it, reversed if asked; undoRun() puts it back.
+void moveRun(std::vector<size_t>& order, size_t i, size_t len, size_t at, bool reversed) {
+    if (at < i) std::rotate(order.begin() + at, order.begin() + i, order.begin() + i + len);
+    else std::rotate(order.begin() + i, order.begin() + i + len, order.begin() + at + len);
+    if (reversed) std::reverse(order.begin() + at, order.begin() + at + len);
+}
+
+void undoRun(std::vector<size_t>& order, size_t i, size_t len, size_t at, bool reversed) {
+    if (reversed) std::reverse(order.begin() + at, order.begin() + at + len);
+    if (at < i) std::rotate(order.begin() + at, order.begin() + at + len, order.begin() + i + len);
+    else std::rotate(order.begin() + i, order.begin() + at, order.begin() + at + len);
+}
+
+// 2-opt (reverse a stretch), swaps and Or-opt (move a run of up to three
+// stops elsewhere, either way round) until none improves the score. Without
+// windows only the legs count and each move is priced from LegSums; with
+// windows a move changes every later arrival, so it is made, scored on the
+// whole tour and undone unless it helps. Both keep one-way legs exact.
+double localSearch(const TourScorer& scorer, std::vector<size_t>& order) {
+    const size_t first = 1;
+    const size_t last = order.size() - (scorer.fixedLast() ? 1 : 0); // movable stops are [first, last)
+    const bool legsOnly = !scorer.hasWindows();
+    LegSums sums(scorer);
+    if (legsOnly) sums.update(order);
+    double best = scorer.score(order);
+    // delta() prices the move from sums (legs only); apply() makes it, undo() reverts it
+    auto tryMove = [&](auto delta, auto apply, auto undo) {
+        if (legsOnly) {
+            const double d = delta();
+            if (d >= -1e-9) return false;
+            apply();
+            best += d;
+            sums.update(order);
+            return true;
+        }
+        apply();
+        const double s = scorer.score(order);
+        if (s < best - 1e-9) {
+            best = s;
+            return true;
+        }
+        undo();
+        return false;
+    };
+
+    for (bool improved = true; improved;) {
+        improved = false;
+        for (size_t i = first; i + 1 < last; ++i) {
+            for (size_t j = i + 1; j < last; ++j) {
+                auto reverse = [&] { std::reverse(order.begin() + i, order.begin() + j + 1); };
+                improved |= tryMove(
+                    [&] {
+                        const size_t prev = order[i - 1], next = sums.next(order, j);
+                        return sums.link(prev, order[j]) + sums.inside(i, j, true) + sums.link(order[i], next) -
+                               sums.link(prev, order[i]) - sums.inside(i, j, false) - sums.link(order[j], next);
+                    },
+                    reverse, reverse);
+            }
+        }
+        // swapping two stops matters once legs are one-way
+        for (size_t i = first; i + 1 < last; ++i) {
+            for (size_t j = i + 1; j < last; ++j) {
+                auto swap = [&] { std::swap(order[i], order[j]); };
+                improved |= tryMove(
+                    [&] {
+                        const size_t a = order[i], b = order[j], prev = order[i - 1], next = sums.next(order, j);
+                        if (j == i + 1) {
+                            return sums.link(prev, b) + sums.link(b, a) + sums.link(a, next) - sums.link(prev, a) -
+                                   sums.link(a, b) - sums.link(b, next);
+                        }
+                        return sums.link(prev, b) + sums.link(b, order[i + 1]) + sums.link(order[j - 1], a) +
+                               sums.link(a, next) - sums.link(prev, a) - sums.link(a, order[i + 1]) -
+                               sums.link(order[j - 1], b) - sums.link(b, next);
+                    },
+                    swap, swap);
+            }
+        }
+        for (size_t len = 1; len <= 3; ++len) {
+            for (size_t i = first; i + len <= last; ++i) {
+                for (size_t at = first; at + len <= last; ++at) {
+                    if (at == i) continue;
+                    for (int reversed = 0; reversed < (len > 1 ? 2 : 1); ++reversed) {
+                        improved |= tryMove(
+                            [&] {
+                                const size_t runFirst = order[i], runLast = order[i + len - 1];
+                                const size_t prev = order[i - 1], next = sums.next(order, i + len - 1);
+                                const double removed = sums.link(prev, runFirst) + sums.inside(i, i + len - 1, false) +
+                                                       sums.link(runLast, next) - sums.link(prev, next);
+                                // neighbours of `at` once the run is out
+                                auto rest = [&](size_t k) { return k < i ? order[k] : order[k + len]; };
+                                const size_t a = rest(at - 1);
+                                const size_t b = at < order.size() - len ? rest(at)
+                                                 : scorer.roundTrip()     ? order[0]
+                                                                          : LegSums::NONE;
+                                const size_t head = reversed ? runLast : runFirst;
+                                const size_t tail = reversed ? runFirst : runLast;
+                                const double added = sums.link(a, head) + sums.inside(i, i + len - 1, reversed) +
+                                                     sums.link(tail, b) - sums.link(a, b);
+                                return added - removed;
+                            },
+                            [&] { moveRun(order, i, len, at, reversed); },
+                            [&] { undoRun(order, i, len, at, reversed); });
+                    }
+                }
+            }
+        }
+    }
+    // sums drift by rounding; report the exact score
+    return legsOnly ? scorer.score(order) : best;
+}
+
+// Reorders three stretches of the movable stops [first, last) as A C B D: a
+// move no combination of the moves above undoes, to leave a local optimum.
+void doubleBridge(std::vector<size_t>& order, size_t first, size_t last, std::mt19937& rng) {
+    if (last - first < 4) return;
+    size_t cuts[3];
+    for (size_t& c : cuts) c = first + 1 + rng() % (last - first - 1);
+    std::sort(cuts, cuts + 3);
+    std::rotate(order.begin() + cuts[0], order.begin() + cuts[1], order.begin() + cuts[2]);
+}
+
+} // namespace
+
+std::vector<std::vector<double>> costMatrix(const RoutingGraph& graph, const std::vector<RoutingGraph::NodeIndex>& stops,
+                                            const SearchOptions& options, size_t threads) {
+    std::vector<std::vector<double>> rows(stops.size());
+    std::vector<SearchWorkspace> workspaces(threadCount(threads, stops.size()));
+    parallelFor(stops.size(), threads, [&](size_t worker, size_t i) {
+        rows[i] = distancesFrom(graph, stops[i], stops, workspaces[worker], options);
+    });
+    return rows;
+}
+
+Tour solveTour(const std::vector<std::vector<double>>& matrix, const TourOptions& options) {
+    Tour tour;
+    if (matrix.empty()) return tour;
+    const TourScorer scorer(matrix, options);
+    if (matrix.size() <= 2) {
+        scorer.score(scorer.fixedLast() ? scorer.frame() : cheapestInsertion(scorer, scorer.freeStops()), &tour);
+        return tour;
+    }
+
+    const size_t restarts = std::max<size_t>(1, options.restarts);
+    std::vector<std::vector<size_t>> orders(restarts);
+    std::vector<double> scores(restarts);
+    parallelFor(restarts, options.threads, [&](size_t, size_t r) {
+        std::mt19937 rng(options.seed + static_cast<uint32_t>(r));
+        std::vector<size_t> order;
+        if (r == 0) {
+            order = nearestNeighbour(scorer, nullptr);
+        } else if (r == 1) {
+            // farthest stops first: the classic insertion order; with windows, earliest deadline first
+            std::vector<size_t> sequence = scorer.freeStops();
+            if (!options.windows.empty()) {
+                std::stable_sort(sequence.begin(), sequence.end(), [&](size_t a, size_t b) {
+                    return options.windows[a].close < options.windows[b].close;
+                });
+            } else {
+                std::stable_sort(sequence.begin(), sequence.end(), [&](size_t a, size_t b) {
+                    return scorer.leg(0, a) > scorer.leg(0, b);
+                });
+            }
+            order = cheapestInsertion(scorer, sequence);
+        } else if (r % 2 == 0) {
+            order = nearestNeighbour(scorer, &rng);
+        } else {
+            std::vector<size_t> sequence = scorer.freeStops();
+            std::shuffle(sequence.begin(), sequence.end(), rng);
+            order = cheapestInsertion(scorer, sequence);
+        }
+        double score = localSearch(scorer, order);
+        // iterated local search: kick the best order found and search again
+        const size_t last = order.size() - (scorer.fixedLast() ? 1 : 0);
+        for (size_t k = 0; k < options.kicks; ++k) {
+            std::vector<size_t> kicked = order;
+            doubleBridge(kicked, 1, last, rng);
+            const double s = localSearch(scorer, kicked);
+            if (s < score) {
+                score = s;
+                order.swap(kicked);
+            }
+        }
+        scores[r] = score;
+        orders[r] = std::move(order);
+    });
+
+    // lowest score, then lowest restart: the same answer on any thread count
+    const size_t best = static_cast<size_t>(std::min_element(scores.begin(), scores.end()) - scores.begin());
+    scorer.score(orders[best], &tour);
+    return tour;
+}
+
+std::vector<RoutingGraph::NodeIndex> tourPath(const RoutingGraph& graph, const std::vector<RoutingGraph::NodeIndex>& stops,
+                                              const Tour& tour, SearchWorkspace& ws, const SearchOptions& options,
+                                              bool roundTrip) {
+    std::vector<RoutingGraph::NodeIndex> path;
+    if (tour.order.empty()) return path;
+    std::vector<size_t> visits = tour.order;
+    if (roundTrip && visits.size() > 1) visits.push_back(visits[0]);
+
+    path.push_back(stops[visits[0]]);
+    for (size_t k = 1; k < visits.size(); ++k) {
+        const std::vector<RoutingGraph::NodeIndex> legPath =
+            astar(graph, stops[visits[k - 1]], stops[visits[k]], ws, options);
+        if (legPath.empty()) return {};
+        path.insert(path.end(), legPath.begin() + 1, legPath.end()); // legPath[0] ends the previous leg
+    }
+    return path;
+}
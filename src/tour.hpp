@@ -0,0 +1,68 @@
+#ifndef TOUR_HPP
+#define TOUR_HPP
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "a_star.hpp"
+#include "routing_graph.hpp"
+
+// Multi-stop routing: the order to visit a handful of stops in (10 to 50 for
+// a delivery run), then the road route through them.
+
+// Cost (meters or deciseconds) between every pair of stops, one distancesFrom()
+// row per stop, rows spread over threads (0: one per core). +infinity where a
+// stop cannot reach another.
+std::vector<std::vector<double>> costMatrix(const RoutingGraph& graph,
+                                            const std::vector<RoutingGraph::NodeIndex>& stops,
+                                            const SearchOptions& options = {},
+                                            size_t threads = 0);
+
+// When a stop may be served, in seconds after leaving the first stop. Riders
+// arriving early wait; arriving late is allowed but costs lateness.
+struct TimeWindow {
+    double open = 0.0;
+    double close = std::numeric_limits<double>::infinity();
+};
+
+struct TourOptions {
+    // Back to the first stop at the end; otherwise the tour ends at whichever
+    // stop is cheapest, or at the last one with fixedEnd. Tours always start
+    // at the first stop.
+    bool roundTrip = true;
+    bool fixedEnd = false;
+    // Per stop (empty: none). Need a Duration matrix.
+    std::vector<TimeWindow> windows;
+    double serviceSeconds = 0.0; // spent at each stop before leaving it
+    // Randomized constructions, each improved by 2-opt, swap and Or-opt
+    // moves and then by `kicks` rounds of perturbing and improving again,
+    // spread over threads (0: one per core). The result only depends on seed.
+    size_t restarts = 16;
+    size_t kicks = 4;
+    size_t threads = 0;
+    uint32_t seed = 1;
+};
+
+struct Tour {
+    std::vector<size_t> order;    // stop indices, starting with 0; a round trip does not repeat it
+    double cost = 0.0;            // of the legs (return leg included), matrix units
+    double lateSeconds = 0.0;     // summed over stops served after their window closed
+    std::vector<double> arrivals; // seconds after departure at each stop in order (Duration matrices)
+    bool reachable = false;       // false if some leg has no route
+};
+
+// Best visiting order found for matrix (square, from costMatrix()). Lateness
+// outweighs any cost, so a tour that keeps every window wins if one is found.
+Tour solveTour(const std::vector<std::vector<double>>& matrix, const TourOptions& options = {});
+
+// Road route through stops in tour order (back to the first stop for a round
+// trip), as astar() paths joined at the stops; empty if a leg is unreachable.
+std::vector<RoutingGraph::NodeIndex> tourPath(const RoutingGraph& graph,
+                                              const std::vector<RoutingGraph::NodeIndex>& stops,
+                                              const Tour& tour,
+                                              SearchWorkspace& ws,
+                                              const SearchOptions& options = {},
+                                              bool roundTrip = true);
+
+#endif
@@ -0,0 +1,287 @@
+#include "traffic.hpp"
+#include "binary_io.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <unordered_map>
+
+namespace {
+
+using Points = std::vector<TrafficModel::Breakpoint>;
+
+constexpr uint32_t UNASSIGNED = UINT32_MAX;
+constexpr float MIN_FACTOR = 0.1f;
+constexpr float MAX_FACTOR = 20.0f;
+
+std::vector<std::string> splitFields(const std::string& line) {
+    std::vector<std::string> fields;
+    std::istringstream in(line);
+    for (std::string field; std::getline(in, field, ',');) {
+        const size_t first = field.find_first_not_of(" \t\r");
+        const size_t last = field.find_last_not_of(" \t\r");
+        fields.push_back(first == std::string::npos ? std::string() : field.substr(first, last - first + 1));
+    }
+    return fields;
+}
+
+// "hh:mm=factor"
+bool parseBreakpoint(const std::string& s, TrafficModel::Breakpoint& point) {
+    const size_t eq = s.find('=');
+    if (eq == std::string::npos || !parseTimeOfDay(s.substr(0, eq), point.second)) return false;
+    const char* rest = s.c_str() + eq + 1;
+    char* end = nullptr;
+    const double factor = std::strtod(rest, &end);
+    if (end == rest || *end != '\0' || !(factor >= MIN_FACTOR && factor <= MAX_FACTOR)) return false;
+    point.factor = static_cast<float>(factor);
+    return true;
+}
+
+// Raises points so the factor never falls faster than 1 / maxBaseS per
+// second, wrapping around midnight. Returns true if anything changed.
+bool enforceFifo(Points& points, double maxBaseS) {
+    if (points.size() < 2 || maxBaseS <= 0.0) return false;
+    bool changed = false;
+    // a drop can carry over midnight once, so two rounds settle every point
+    for (int round = 0; round < 2; ++round) {
+        for (size_t i = 0; i < points.size(); ++i) {
+            const TrafficModel::Breakpoint& a = points[i];
+            TrafficModel::Breakpoint& b = points[(i + 1) % points.size()];
+            const uint32_t span = (b.second + TrafficModel::PERIOD_S - a.second) % TrafficModel::PERIOD_S;
+            const float floor = static_cast<float>(a.factor - span / maxBaseS);
+            if (b.factor < floor) {
+                b.factor = floor;
+                changed = true;
+            }
+        }
+    }
+    return changed;
+}
+
+} // namespace
+
+bool parseTimeOfDay(const std::string& s, uint32_t& second) {
+    char* end = nullptr;
+    const long hours = std::strtol(s.c_str(), &end, 10);
+    if (end == s.c_str() || *end != ':') return false;
+    const char* rest = end + 1;
+    const long minutes = std::strtol(rest, &end, 10);
+    if (end != rest + 2 || *end != '\0' || hours < 0 || hours > 23 || minutes < 0 || minutes > 59) return false;
+    second = static_cast<uint32_t>(hours * 3600 + minutes * 60);
+    return true;
+}
+
+uint32_t localTimeOfDay() {
+    const std::time_t now = std::time(nullptr);
+    std::tm local{};
+    localtime_r(&now, &local);
+    return static_cast<uint32_t>(local.tm_hour * 3600 + local.tm_min * 60 + local.tm_sec);
+}
+
+std::shared_ptr<const TrafficModel> TrafficModel::fromCsv(const RoutingGraph& graph, const std::string& filename) {
+    std::ifstream in(filename);
+    if (!in) {
+        std::cerr << "Failed to open traffic file: " << filename << "\n";
+        return nullptr;
+    }
+
+    std::unordered_map<std::string, uint32_t> names;
+    std::vector<Points> profiles;
+    std::vector<uint32_t> edgeProfiles(graph.edgeCount(), UNASSIGNED);
+    size_t lineNo = 0, unmatched = 0;
+    auto fail = [&](const char* what) {
+        std::cerr << filename << ":" << lineNo << ": " << what << "\n";
+        return std::shared_ptr<const TrafficModel>();
+    };
+
+    for (std::string line; std::getline(in, line);) {
+        ++lineNo;
+        line = line.substr(0, line.find('#'));
+        const std::vector<std::string> fields = splitFields(line);
+        if (fields.empty() || (fields.size() == 1 && fields[0].empty())) continue;
+
+        if (fields[0] == "profile") {
+            if (fields.size() < 3 || fields[1].empty()) return fail("expected profile,<name>,<hh:mm>=<factor>,...");
+            if (!names.emplace(fields[1], static_cast<uint32_t>(profiles.size())).second) {
+                return fail("profile defined twice");
+            }
+            Points points(fields.size() - 2);
+            for (size_t i = 2; i < fields.size(); ++i) {
+                if (!parseBreakpoint(fields[i], points[i - 2])) return fail("bad breakpoint, expected hh:mm=factor");
+            }
+            std::sort(points.begin(), points.end(), [](const Breakpoint& a, const Breakpoint& b) {
+                return a.second < b.second;
+            });
+            for (size_t i = 1; i < points.size(); ++i) {
+                if (points[i].second == points[i - 1].second) return fail("two breakpoints at the same time");
+            }
+            profiles.push_back(std::move(points));
+        } else if (fields[0] == "edge") {
+            if (fields.size() != 4) return fail("expected edge,<from node>,<to node>,<profile>");
+            auto name = names.find(fields[3]);
+            if (name == names.end()) return fail("unknown profile");
+            char* end1 = nullptr;
+            char* end2 = nullptr;
+            const RoutingGraph::NodeIndex u = graph.indexOf(std::strtoll(fields[1].c_str(), &end1, 10));
+            const RoutingGraph::NodeIndex v = graph.indexOf(std::strtoll(fields[2].c_str(), &end2, 10));
+            if (*end1 != '\0' || *end2 != '\0') return fail("node ids must be integers");
+
+            const RoutingGraph::EdgeIndex e = graph.segmentEdge(u, v);
+            if (e == RoutingGraph::INVALID_EDGE) ++unmatched;
+            else edgeProfiles[e] = name->second;
+        } else {
+            return fail("expected a profile or edge record");
+        }
+    }
+
+    // longest free-flow time on each profile's edges bounds how fast it may fall
+    std::vector<double> maxBaseS(profiles.size(), 0.0);
+    for (RoutingGraph::EdgeIndex e = 0; e < graph.edgeCount(); ++e) {
+        if (edgeProfiles[e] == UNASSIGNED) continue;
+        for (size_t slot = 0; slot < PROFILE_COUNT; ++slot) {
+            const Profile p = static_cast<Profile>(slot);
+            if (!followsTraffic(p) || !graph.edge(e).allows(p)) continue;
+            maxBaseS[edgeProfiles[e]] = std::max(maxBaseS[edgeProfiles[e]], graph.duration(e, p) / 10.0);
+        }
+    }
+
+    std::shared_ptr<TrafficModel> model(new TrafficModel());
+    model->m_nodeCount = graph.nodeCount();
+    std::map<std::vector<std::pair<uint32_t, float>>, ProfileId> distinct;
+    std::vector<ProfileId> ids(profiles.size(), 0);
+    for (size_t r = 0; r < profiles.size(); ++r) {
+        if (maxBaseS[r] == 0.0) continue; // no edge uses it
+        Points& points = profiles[r];
+        if (enforceFifo(points, maxBaseS[r])) ++model->m_adjusted;
+
+        std::vector<std::pair<uint32_t, float>> key;
+        for (const Breakpoint& b : points) key.push_back({b.second, b.factor});
+        auto it = distinct.find(key);
+        if (it == distinct.end()) {
+            if (model->m_offsets.size() > UINT16_MAX) {
+                std::cerr << "Too many distinct traffic profiles in " << filename << "\n";
+                return nullptr;
+            }
+            it = distinct.emplace(std::move(key), static_cast<ProfileId>(model->m_offsets.size() - 1)).first;
+            model->m_points.insert(model->m_points.end(), points.begin(), points.end());
+            model->m_offsets.push_back(static_cast<uint32_t>(model->m_points.size()));
+            for (const Breakpoint& b : points) model->m_minFactor = std::min<double>(model->m_minFactor, b.factor);
+        }
+        ids[r] = it->second;
+    }
+
+    model->m_edgeProfiles.resize(graph.edgeCount(), 0);
+    for (RoutingGraph::EdgeIndex e = 0; e < graph.edgeCount(); ++e) {
+        if (edgeProfiles[e] != UNASSIGNED) model->m_edgeProfiles[e] = ids[edgeProfiles[e]];
+    }
+
+    std::clog << "Traffic: " << profiles.size() << " profiles (" << model->profileCount() << " distinct, "
+              << model->m_adjusted << " adjusted for FIFO), " << model->assignedEdges() << " edges";
+    if (unmatched > 0) std::clog << ", " << unmatched << " segments not in the graph";
+    std::clog << "\n";
+    return model;
+}
+
+// Traffic file layout (native endianness): "RTTRAFF1", u64 graph node count,
+// f64 minFactor, u64 adjusted profiles, then m_offsets, m_points and
+// m_edgeProfiles as u64 length + raw elements.
+static const char TRAFFIC_MAGIC[8] = {'R','T','T','R','A','F','F','1'};
+
+bool TrafficModel::save(const std::string& filename) const {
+    std::ofstream out(filename, std::ios::binary);
+    if (!out) {
+        std::cerr << "Failed to open traffic file for writing: " << filename << "\n";
+        return false;
+    }
+    const uint64_t adjusted = m_adjusted;
+    out.write(TRAFFIC_MAGIC, sizeof(TRAFFIC_MAGIC));
+    out.write(reinterpret_cast<const char*>(&m_nodeCount), sizeof(m_nodeCount));
+    out.write(reinterpret_cast<const char*>(&m_minFactor), sizeof(m_minFactor));
+    out.write(reinterpret_cast<const char*>(&adjusted), sizeof(adjusted));
+    writeArray(out, m_offsets);
+    writeArray(out, m_points);
+    writeArray(out, m_edgeProfiles);
+    return static_cast<bool>(out);
+}
+
+std::shared_ptr<const TrafficModel> TrafficModel::load(const RoutingGraph& graph, const std::string& filename) {
+    std::ifstream in(filename, std::ios::binary);
+    if (!in) {
+        std::cerr << "Failed to open traffic file: " << filename << "\n";
+        return nullptr;
+    }
+
+    char magic[sizeof(TRAFFIC_MAGIC)];
+    if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, TRAFFIC_MAGIC, sizeof(magic)) != 0) {
+        std::cerr << "Not a route_tracer traffic file: " << filename << "\n";
+        return nullptr;
+    }
+
+    std::shared_ptr<TrafficModel> model(new TrafficModel());
+    uint64_t adjusted = 0;
+    bool ok = in.read(reinterpret_cast<char*>(&model->m_nodeCount), sizeof(model->m_nodeCount)) &&
+              in.read(reinterpret_cast<char*>(&model->m_minFactor), sizeof(model->m_minFactor)) &&
+              in.read(reinterpret_cast<char*>(&adjusted), sizeof(adjusted)) &&
+              readArray(in, model->m_offsets) && readArray(in, model->m_points) &&
+              readArray(in, model->m_edgeProfiles);
+    model->m_adjusted = adjusted;
+
+    const auto& offsets = model->m_offsets;
+    ok = ok && offsets.size() >= 2 && offsets[0] == 0 && offsets[1] == 0 &&
+         offsets.back() == model->m_points.size() && std::is_sorted(offsets.begin(), offsets.end());
+    for (size_t id = 1; ok && id + 1 < offsets.size(); ++id) ok = offsets[id + 1] > offsets[id];
+    for (ProfileId id : model->m_edgeProfiles) ok = ok && size_t(id) + 1 < offsets.size();
+    if (!ok) {
+        std::cerr << "Truncated or corrupt traffic file: " << filename << "\n";
+        return nullptr;
+    }
+    if (model->m_nodeCount != graph.nodeCount() || model->m_edgeProfiles.size() != graph.edgeCount()) {
+        std::cerr << "Traffic file " << filename << " was made for another graph\n";
+        return nullptr;
+    }
+    return model;
+}
+
+double TrafficModel::evaluate(ProfileId id, double seconds) const {
+    const Breakpoint* first = m_points.data() + m_offsets[id];
+    const Breakpoint* last = m_points.data() + m_offsets[id + 1];
+    double t = std::fmod(seconds, static_cast<double>(PERIOD_S));
+    if (t < 0.0) t += PERIOD_S;
+
+    // between the last breakpoint at or before t and the next one, wrapping around midnight
+    const Breakpoint* next = std::upper_bound(first, last, t, [](double x, const Breakpoint& b) {
+        return x < b.second;
+    });
+    const Breakpoint& a = next == first ? *(last - 1) : *(next - 1);
+    const Breakpoint& b = next == last ? *first : *next;
+    double span = static_cast<double>(b.second) - a.second;
+    if (span <= 0.0) span += PERIOD_S;
+    double into = t - a.second;
+    if (into < 0.0) into += PERIOD_S;
+    return a.factor + (b.factor - a.factor) * (into / span);
+}
+
+size_t TrafficModel::assignedEdges() const {
+    return m_edgeProfiles.size() - std::count(m_edgeProfiles.begin(), m_edgeProfiles.end(), ProfileId(0));
+}
+
+size_t TrafficModel::memoryBytes() const {
+    return m_offsets.capacity() * sizeof(uint32_t) + m_points.capacity() * sizeof(Breakpoint) +
+           m_edgeProfiles.capacity() * sizeof(ProfileId);
+}
+
+static std::shared_ptr<const TrafficModel> g_currentTraffic;
+
+std::shared_ptr<const TrafficModel> currentTraffic() {
+    return std::atomic_load(&g_currentTraffic);
+}
+
+void publishTraffic(std::shared_ptr<const TrafficModel> traffic) {
+    std::atomic_store(&g_currentTraffic, std::move(traffic));
+}
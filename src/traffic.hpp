@@ -0,0 +1,81 @@
+#ifndef TRAFFIC_HPP
+#define TRAFFIC_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "routing_graph.hpp"
+
+// Time-of-day congestion. An edge may follow a traffic profile: a daily,
+// piecewise-linear function from time of day to a factor on its free-flow
+// travel time. Identical profiles are stored once, so each edge only costs a
+// 16-bit profile id. Only profiles that followsTraffic() are slowed down.
+//
+// Profiles are adjusted on load so that leaving later never means arriving
+// earlier (FIFO) on any edge that uses them: a factor falls by at most
+// 1 / (longest free-flow seconds of those edges) per second. Time-dependent
+// Dijkstra and A* stay exact under that property.
+//
+// Like RoutingGraph, a TrafficModel is immutable and handed out as
+// shared_ptr<const TrafficModel>; it belongs to the graph it was loaded for.
+class TrafficModel {
+public:
+    using ProfileId = uint16_t; // 0 is free flow
+    static constexpr uint32_t PERIOD_S = 24 * 3600;
+
+    struct Breakpoint {
+        uint32_t second; // of the day, ascending within a profile
+        float factor;
+    };
+
+    // Text format, one record per line ('#' starts a comment):
+    //   profile,<name>,<hh:mm>=<factor>,<hh:mm>=<factor>,...
+    //   edge,<from OSM node>,<to OSM node>,<profile name>
+    // An edge record applies to the graph edge containing that OSM way
+    // segment, in that direction. Returns nullptr on errors.
+    static std::shared_ptr<const TrafficModel> fromCsv(const RoutingGraph& graph, const std::string& filename);
+
+    // Binary dump; refuses files written for a graph of another size.
+    static std::shared_ptr<const TrafficModel> load(const RoutingGraph& graph, const std::string& filename);
+    bool save(const std::string& filename) const;
+
+    // Factor on e's free-flow time when entered `seconds` after midnight
+    // (wraps around daily).
+    double factor(RoutingGraph::EdgeIndex e, double seconds) const {
+        const ProfileId id = m_edgeProfiles[e];
+        return id == 0 ? 1.0 : evaluate(id, seconds);
+    }
+    // Smallest factor of any profile, at most 1; scales A* heuristics.
+    double minFactor() const { return m_minFactor; }
+
+    size_t profileCount() const { return m_offsets.size() - 2; }
+    size_t edgeCount() const { return m_edgeProfiles.size(); }
+    size_t assignedEdges() const;
+    size_t adjustedProfiles() const { return m_adjusted; }
+    size_t memoryBytes() const;
+
+private:
+    TrafficModel() = default;
+
+    std::vector<uint32_t> m_offsets{0, 0};  // profile id -> [m_offsets[id], m_offsets[id + 1]) in m_points
+    std::vector<Breakpoint> m_points;
+    std::vector<ProfileId> m_edgeProfiles; // one per graph edge
+    uint64_t m_nodeCount = 0;              // of the graph, to reject mismatched files
+    double m_minFactor = 1.0;
+    size_t m_adjusted = 0;                 // profiles raised on load to stay FIFO
+
+    double evaluate(ProfileId id, double seconds) const;
+};
+
+// "hh:mm" (00:00 to 23:59) as seconds after midnight.
+bool parseTimeOfDay(const std::string& s, uint32_t& second);
+// Seconds after local midnight now, the departure when none is given.
+uint32_t localTimeOfDay();
+
+// Process-wide traffic slot next to currentGraph(); empty means free flow.
+std::shared_ptr<const TrafficModel> currentTraffic();
+void publishTraffic(std::shared_ptr<const TrafficModel> traffic);
+
+#endif
@@ -0,0 +1,254 @@
+// Turn restriction resolution (OSM relations -> edge pairs / via-way trie) and
+// the transition function used by edge-based searches.
+
+#include "routing_graph.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace {
+
+using EdgeIndex = RoutingGraph::EdgeIndex;
+
+uint64_t turnKey(EdgeIndex from, EdgeIndex to) {
+    return (static_cast<uint64_t>(from) << 32) | to;
+}
+
+// Longest via-way chain we follow before giving up on a malformed relation.
+constexpr size_t MAX_VIA_EDGES = 256;
+
+// Mutable trie used while resolving; flattened into RoutingGraph's arrays afterwards.
+struct TrieNode {
+    EdgeIndex edge;
+    std::map<EdgeIndex, uint32_t> children;
+    std::vector<EdgeIndex> bannedExits;
+    std::vector<EdgeIndex> onlyExits;
+};
+
+} // namespace
+
+void RoutingGraph::resolveRestrictions(const std::vector<Restriction>& restrictions,
+                                       const std::vector<int64_t>& edgeWays) {
+    m_turnFlags.clear();
+    m_bannedTurns.clear();
+    m_bannedTurnProfiles.clear();
+    m_viaRoots.clear();
+    m_viaRootProfiles.clear();
+    m_viaRootStates.clear();
+    m_viaStates.clear();
+    m_viaChildren.clear();
+    m_viaExits.clear();
+    m_restrictionCount = 0;
+    m_restrictedProfiles = 0;
+    if (restrictions.empty()) return;
+
+    std::vector<NodeIndex> tail(m_edges.size());
+    for (NodeIndex u = 0; u < nodeCount(); ++u) {
+        for (uint32_t e = m_offsets[u]; e < m_offsets[u + 1]; ++e) tail[e] = u;
+    }
+
+    // edges of every way a restriction mentions
+    std::unordered_map<int64_t, std::vector<EdgeIndex>> wayEdges;
+    for (const auto& r : restrictions) {
+        wayEdges[r.fromWay];
+        wayEdges[r.toWay];
+        for (int64_t w : r.viaWays) wayEdges[w];
+    }
+    for (EdgeIndex e = 0; e < edgeWays.size(); ++e) {
+        auto it = wayEdges.find(edgeWays[e]);
+        if (it != wayEdges.end()) it->second.push_back(e);
+    }
+
+    // (from edge, to edge) and the profiles the turn is banned for
+    std::vector<std::pair<uint64_t, uint8_t>> bans;
+    // one trie per profile: an only_* rule for one must not override a no_* rule for another
+    std::vector<TrieNode> trie;
+    std::map<std::pair<uint64_t, uint8_t>, uint32_t> roots; // (first two edges, profile bit)
+    auto trieChild = [&](uint32_t parent, EdgeIndex edge) {
+        auto it = trie[parent].children.find(edge);
+        if (it != trie[parent].children.end()) return it->second;
+        uint32_t id = static_cast<uint32_t>(trie.size());
+        trie.push_back({edge, {}, {}, {}});
+        trie[parent].children.emplace(edge, id);
+        return id;
+    };
+
+    for (const auto& r : restrictions) {
+        const auto& fromEdges = wayEdges[r.fromWay];
+        const auto& toEdges = wayEdges[r.toWay];
+        bool resolved = false;
+
+        if (r.viaNode != 0) {
+            NodeIndex via = indexOf(r.viaNode);
+            if (via == INVALID_NODE) continue;
+            for (EdgeIndex in : fromEdges) {
+                if (m_edges[in].to != via) continue;
+                for (uint32_t out = m_offsets[via]; out < m_offsets[via + 1]; ++out) {
+                    bool listed = std::find(toEdges.begin(), toEdges.end(), out) != toEdges.end();
+                    // no_u_turn along one way must not ban going straight on through the via node
+                    if (listed && r.fromWay == r.toWay && !r.only && m_edges[out].to != tail[in]) continue;
+                    if (r.only ? !listed : listed) {
+                        bans.push_back({turnKey(in, out), r.profiles});
+                        resolved = true;
+                    } else if (r.only) {
+                        resolved = true;
+                    }
+                }
+            }
+        } else {
+            std::unordered_set<EdgeIndex> viaSet;
+            for (int64_t w : r.viaWays) {
+                for (EdgeIndex e : wayEdges[w]) viaSet.insert(e);
+            }
+
+            // walk from every from-way edge that enters the via ways until a to-way exit appears
+            for (EdgeIndex in : fromEdges) {
+                std::vector<EdgeIndex> prefix{in};
+                NodeIndex prev = tail[in];
+                NodeIndex cur = m_edges[in].to;
+                std::vector<EdgeIndex> exits;
+                while (prefix.size() <= MAX_VIA_EDGES) {
+                    if (prefix.size() >= 2) {
+                        for (EdgeIndex out : toEdges) {
+                            if (tail[out] == cur) exits.push_back(out);
+                        }
+                        if (!exits.empty()) break;
+                    }
+                    EdgeIndex next = INVALID_STATE;
+                    for (uint32_t e = m_offsets[cur]; e < m_offsets[cur + 1]; ++e) {
+                        if (viaSet.count(e) && m_edges[e].to != prev) {
+                            next = e;
+                            break;
+                        }
+                    }
+                    if (next == INVALID_STATE) break;
+                    prefix.push_back(next);
+                    prev = cur;
+                    cur = m_edges[next].to;
+                }
+                if (exits.empty()) continue;
+
+                for (size_t p = 0; p < PROFILE_COUNT; ++p) {
+                    const uint8_t bit = profileBit(static_cast<Profile>(p));
+                    if (!(r.profiles & bit)) continue;
+                    const std::pair<uint64_t, uint8_t> rootKey{turnKey(prefix[0], prefix[1]), bit};
+                    auto rootIt = roots.find(rootKey);
+                    uint32_t node;
+                    if (rootIt == roots.end()) {
+                        node = static_cast<uint32_t>(trie.size());
+                        trie.push_back({prefix[1], {}, {}, {}});
+                        roots.emplace(rootKey, node);
+                    } else {
+                        node = rootIt->second;
+                    }
+                    for (size_t i = 2; i < prefix.size(); ++i) node = trieChild(node, prefix[i]);
+
+                    auto& list = r.only ? trie[node].onlyExits : trie[node].bannedExits;
+                    list.insert(list.end(), exits.begin(), exits.end());
+                    resolved = true;
+                }
+            }
+        }
+
+        if (resolved) ++m_restrictionCount;
+    }
+
+    if (bans.empty() && trie.empty()) return;
+
+    // one entry per turn, banned for every profile any rule bans it for
+    std::sort(bans.begin(), bans.end());
+    for (const auto& ban : bans) {
+        if (!m_bannedTurns.empty() && m_bannedTurns.back() == ban.first) {
+            m_bannedTurnProfiles.back() |= ban.second;
+        } else {
+            m_bannedTurns.push_back(ban.first);
+            m_bannedTurnProfiles.push_back(ban.second);
+        }
+        m_restrictedProfiles |= ban.second;
+    }
+
+    m_turnFlags.assign(m_edges.size(), 0);
+    for (uint64_t key : m_bannedTurns) m_turnFlags[key >> 32] |= TURN_HAS_BANS;
+
+    // flatten the trie; state ids are trie indices
+    m_viaStates.resize(trie.size());
+    for (uint32_t i = 0; i < trie.size(); ++i) {
+        TrieNode& t = trie[i];
+        ViaState& vs = m_viaStates[i];
+        vs.edge = t.edge;
+        vs.firstChild = static_cast<uint32_t>(m_viaChildren.size());
+        vs.childCount = static_cast<uint32_t>(t.children.size());
+        for (const auto& c : t.children) m_viaChildren.push_back(c.second); // std::map keeps them sorted by edge
+
+        // an only_* rule wins over no_* rules on the same prefix
+        std::vector<EdgeIndex>& exits = t.onlyExits.empty() ? t.bannedExits : t.onlyExits;
+        std::sort(exits.begin(), exits.end());
+        exits.erase(std::unique(exits.begin(), exits.end()), exits.end());
+        vs.onlyExits = t.onlyExits.empty() ? 0 : 1;
+        vs.firstExit = static_cast<uint32_t>(m_viaExits.size());
+        vs.exitCount = static_cast<uint32_t>(exits.size());
+        m_viaExits.insert(m_viaExits.end(), exits.begin(), exits.end());
+    }
+    for (const auto& root : roots) {
+        m_viaRoots.push_back(root.first.first);
+        m_viaRootProfiles.push_back(root.first.second);
+        m_viaRootStates.push_back(root.second);
+        m_turnFlags[root.first.first >> 32] |= TURN_STARTS_VIA;
+        m_restrictedProfiles |= root.first.second;
+    }
+
+    std::clog << "Turn restrictions: " << m_restrictionCount << " of " << restrictions.size()
+              << " resolved (" << m_bannedTurns.size() << " banned turns, "
+              << m_viaStates.size() << " via-way states)\n";
+}
+
+RoutingGraph::TurnState RoutingGraph::nextTurnState(TurnState from, EdgeIndex next, Profile p) const {
+    if (m_turnFlags.empty()) return next;
+
+    const size_t edgeCount = m_edges.size();
+    const EdgeIndex cur = stateEdge(from);
+    const uint8_t flags = m_turnFlags[cur];
+    const uint8_t bit = profileBit(p);
+
+    if (flags & TURN_HAS_BANS) {
+        auto it = std::lower_bound(m_bannedTurns.begin(), m_bannedTurns.end(), turnKey(cur, next));
+        if (it != m_bannedTurns.end() && *it == turnKey(cur, next) &&
+            (m_bannedTurnProfiles[it - m_bannedTurns.begin()] & bit)) {
+            return INVALID_STATE;
+        }
+    }
+
+    if (from >= edgeCount) {
+        const ViaState& vs = m_viaStates[from - edgeCount];
+
+        if (vs.exitCount > 0) {
+            auto first = m_viaExits.begin() + vs.firstExit;
+            auto last = first + vs.exitCount;
+            bool listed = std::binary_search(first, last, next);
+            if (vs.onlyExits ? !listed : listed) return INVALID_STATE;
+        }
+
+        // still following a longer restricted prefix?
+        auto first = m_viaChildren.begin() + vs.firstChild;
+        auto last = first + vs.childCount;
+        auto it = std::lower_bound(first, last, next, [&](uint32_t state, EdgeIndex e) {
+            return m_viaStates[state].edge < e;
+        });
+        if (it != last && m_viaStates[*it].edge == next) return static_cast<TurnState>(edgeCount + *it);
+    }
+
+    if (flags & TURN_STARTS_VIA) {
+        // a via state belongs to one profile's trie; each pair has at most one per profile
+        uint64_t key = turnKey(cur, next);
+        for (auto it = std::lower_bound(m_viaRoots.begin(), m_viaRoots.end(), key);
+             it != m_viaRoots.end() && *it == key; ++it) {
+            const size_t i = static_cast<size_t>(it - m_viaRoots.begin());
+            if (m_viaRootProfiles[i] & bit) return static_cast<TurnState>(edgeCount + m_viaRootStates[i]);
+        }
+    }
+
+    return next;
+}
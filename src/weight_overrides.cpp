@@ -0,0 +1,203 @@
+#include "weight_overrides.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+WeightOverrides::WeightOverrides(size_t edgeCount, uint64_t generation)
+    : m_pages((edgeCount + PAGE_SIZE - 1) / PAGE_SIZE), m_edgeCount(edgeCount), m_generation(generation) {}
+
+std::shared_ptr<const WeightOverrides> WeightOverrides::apply(const std::vector<Update>& batch) const {
+    for (const Update& u : batch) {
+        if (u.edge >= m_edgeCount || !(u.factor >= 1.0f)) {
+            std::cerr << "Bad weight update: edge " << u.edge << ", factor " << u.factor << "\n";
+            return nullptr;
+        }
+    }
+
+    auto next = std::make_shared<WeightOverrides>(*this);
+    next->m_generation = m_generation + 1;
+    // pages copied for this batch; the shared ones stay untouched
+    std::vector<Page*> writable(m_pages.size(), nullptr);
+    for (const Update& u : batch) {
+        const size_t p = u.edge >> PAGE_BITS;
+        if (!writable[p]) {
+            auto page = std::make_shared<Page>();
+            if (m_pages[p]) *page = *m_pages[p];
+            else page->fill(1.0f);
+            writable[p] = page.get();
+            next->m_pages[p] = std::move(page);
+        }
+        float& f = (*writable[p])[u.edge & (PAGE_SIZE - 1)];
+        next->m_overridden += (u.factor != 1.0f) - (f != 1.0f);
+        next->m_closed += (u.factor == CLOSED) - (f == CLOSED);
+        f = u.factor;
+    }
+    for (size_t p = 0; p < writable.size(); ++p) {
+        if (writable[p] && std::all_of(writable[p]->begin(), writable[p]->end(), [](float f) { return f == 1.0f; })) {
+            next->m_pages[p] = nullptr;
+        }
+    }
+    return next;
+}
+
+std::vector<RoutingGraph::EdgeIndex> WeightOverrides::changedEdges(const WeightOverrides* before,
+                                                                  const WeightOverrides* after) {
+    std::vector<RoutingGraph::EdgeIndex> changed;
+    const WeightOverrides* any = after ? after : before;
+    if (!any || before == after) return changed;
+    for (size_t p = 0; p < any->m_pages.size(); ++p) {
+        const Page* a = before ? before->m_pages[p].get() : nullptr;
+        const Page* b = after ? after->m_pages[p].get() : nullptr;
+        if (a == b) continue; // shared page, or no overrides on either side
+        const size_t first = p << PAGE_BITS;
+        const size_t last = std::min(first + PAGE_SIZE, any->m_edgeCount);
+        for (size_t e = first; e < last; ++e) {
+            const float fa = a ? (*a)[e - first] : 1.0f;
+            const float fb = b ? (*b)[e - first] : 1.0f;
+            if (fa != fb) changed.push_back(static_cast<RoutingGraph::EdgeIndex>(e));
+        }
+    }
+    return changed;
+}
+
+bool parseWeightUpdates(const RoutingGraph& graph, std::istream& in, std::vector<WeightOverrides::Update>& batch,
+                        size_t& unmatched, std::string& error) {
+    size_t lineNo = 0;
+    for (std::string line; std::getline(in, line);) {
+        ++lineNo;
+        line = line.substr(0, line.find('#'));
+        while (!line.empty() && std::isspace(static_cast<unsigned char>(line.back()))) line.pop_back();
+        if (line.empty()) continue;
+
+        const size_t c1 = line.find(',');
+        const size_t c2 = c1 == std::string::npos ? c1 : line.find(',', c1 + 1);
+        if (c2 == std::string::npos) {
+            error = "line " + std::to_string(lineNo) + ": expected <from>,<to>,<factor>|closed|open";
+            return false;
+        }
+        char* end1 = nullptr;
+        char* end2 = nullptr;
+        const int64_t from = std::strtoll(line.c_str(), &end1, 10);
+        const int64_t to = std::strtoll(line.c_str() + c1 + 1, &end2, 10);
+        const std::string value = line.substr(c2 + 1);
+        float factor = 1.0f;
+        if (value == "closed") {
+            factor = WeightOverrides::CLOSED;
+        } else if (value != "open") {
+            char* end3 = nullptr;
+            factor = std::strtof(value.c_str(), &end3);
+            if (value.empty() || *end3 != '\0' || !(factor >= 1.0f) || !std::isfinite(factor)) {
+                error = "line " + std::to_string(lineNo) + ": factor must be a number >= 1, closed or open";
+                return false;
+            }
+        }
+        if (end1 != line.c_str() + c1 || end2 != line.c_str() + c2) {
+            error = "line " + std::to_string(lineNo) + ": node ids must be integers";
+            return false;
+        }
+
+        const RoutingGraph::EdgeIndex e = graph.segmentEdge(graph.indexOf(from), graph.indexOf(to));
+        if (e == RoutingGraph::INVALID_EDGE) ++unmatched;
+        else batch.push_back({e, factor});
+    }
+    return true;
+}
+
+namespace {
+
+// Epoch-based reclamation. A reader announces the global epoch in its slot
+// before loading g_current; a writer retires the generation it replaces with
+// the epoch it ends and frees it once every announced epoch is newer.
+constexpr size_t READER_SLOTS = 256;
+
+struct alignas(64) ReaderSlot {
+    std::atomic<uint64_t> epoch{0}; // 0: not reading
+    std::atomic<bool> taken{false};
+};
+
+ReaderSlot g_slots[READER_SLOTS];
+std::atomic<uint64_t> g_epoch{1};
+std::atomic<const WeightOverrides*> g_current{nullptr};
+
+// writer state, under g_writeMutex
+std::mutex g_writeMutex;
+std::shared_ptr<const WeightOverrides> g_owned; // what g_current points at
+struct Retired {
+    uint64_t epoch;
+    std::shared_ptr<const WeightOverrides> overrides;
+};
+std::vector<Retired> g_retired;
+
+// This thread's reader slot, given back when the thread exits.
+struct SlotClaim {
+    ReaderSlot* slot = nullptr;
+    size_t depth = 0;
+    ~SlotClaim() {
+        if (slot) slot->taken.store(false);
+    }
+};
+thread_local SlotClaim t_claim;
+
+ReaderSlot& claimSlot() {
+    while (!t_claim.slot) {
+        for (ReaderSlot& s : g_slots) {
+            bool expected = false;
+            if (s.taken.compare_exchange_strong(expected, true)) {
+                t_claim.slot = &s;
+                break;
+            }
+        }
+        // more reader threads than slots: wait for one to exit
+        if (!t_claim.slot) std::this_thread::yield();
+    }
+    return *t_claim.slot;
+}
+
+void reclaim() {
+    uint64_t oldest = UINT64_MAX;
+    for (const ReaderSlot& s : g_slots) {
+        const uint64_t e = s.epoch.load();
+        if (e != 0) oldest = std::min(oldest, e);
+    }
+    g_retired.erase(std::remove_if(g_retired.begin(), g_retired.end(),
+                                   [&](const Retired& r) { return r.epoch < oldest; }),
+                    g_retired.end());
+}
+
+} // namespace
+
+WeightSnapshot::WeightSnapshot() {
+    ReaderSlot& slot = claimSlot();
+    if (t_claim.depth++ == 0) slot.epoch.store(g_epoch.load());
+    m_overrides = g_current.load();
+}
+
+WeightSnapshot::~WeightSnapshot() {
+    if (--t_claim.depth == 0) t_claim.slot->epoch.store(0);
+}
+
+std::shared_ptr<const WeightOverrides> applyWeightUpdates(const RoutingGraph& graph,
+                                                          const std::vector<WeightOverrides::Update>& batch) {
+    std::lock_guard<std::mutex> lock(g_writeMutex);
+    std::shared_ptr<const WeightOverrides> base = g_owned;
+    if (!base || base->edgeCount() != graph.edgeCount()) {
+        base = std::make_shared<WeightOverrides>(graph.edgeCount(), base ? base->generation() : 0);
+    }
+    std::shared_ptr<const WeightOverrides> next = base->apply(batch);
+    if (!next) return nullptr;
+
+    g_current.store(next.get());
+    std::shared_ptr<const WeightOverrides> previous = std::move(g_owned);
+    g_owned = next;
+    // snapshots announced up to this epoch may still hold previous
+    const uint64_t ended = g_epoch.fetch_add(1);
+    if (previous) g_retired.push_back({ended, std::move(previous)});
+    reclaim();
+    return next;
+}
@@ -0,0 +1,102 @@
+#ifndef WEIGHT_OVERRIDES_HPP
+#define WEIGHT_OVERRIDES_HPP
+
+#include <array>
+#include <cstdint>
+#include <istream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "routing_graph.hpp"
+
+// Live changes to edge weights from closures and incident feeds, layered over
+// an immutable RoutingGraph. Each edge has a factor on its cost: 1 leaves it
+// alone, more slows it down (Duration searches only) and CLOSED takes it out
+// of every search. Factors never go below 1, so A* heuristics stay valid.
+// Under traffic a factor k adds k - 1 free-flow times as a fixed delay
+// instead of scaling the time-dependent cost, so it stays FIFO.
+//
+// A WeightOverrides is one immutable generation. apply() builds the next one
+// copy-on-write: factors live in pages of PAGE_SIZE edges, untouched pages are
+// shared between generations and pages without overrides are not stored.
+class WeightOverrides {
+public:
+    static constexpr float CLOSED = std::numeric_limits<float>::infinity();
+    static constexpr size_t PAGE_BITS = 12;
+    static constexpr size_t PAGE_SIZE = size_t(1) << PAGE_BITS;
+
+    struct Update {
+        RoutingGraph::EdgeIndex edge;
+        float factor; // 1 clears the override
+    };
+
+    // No overrides for a graph of edgeCount edges.
+    WeightOverrides(size_t edgeCount, uint64_t generation);
+
+    // The next generation with batch applied (later updates of an edge win);
+    // nullptr if an update names no edge of the graph or a factor below 1.
+    std::shared_ptr<const WeightOverrides> apply(const std::vector<Update>& batch) const;
+
+    double factor(RoutingGraph::EdgeIndex e) const {
+        const Page* page = m_pages[e >> PAGE_BITS].get();
+        return page ? (*page)[e & (PAGE_SIZE - 1)] : 1.0;
+    }
+
+    // Edges whose factor differs between two generations for the same graph
+    // (nullptr standing for no overrides), ascending.
+    static std::vector<RoutingGraph::EdgeIndex> changedEdges(const WeightOverrides* before,
+                                                             const WeightOverrides* after);
+
+    uint64_t generation() const { return m_generation; }
+    size_t edgeCount() const { return m_edgeCount; }
+    size_t overriddenEdges() const { return m_overridden; }
+    size_t closedEdges() const { return m_closed; }
+
+private:
+    using Page = std::array<float, PAGE_SIZE>;
+
+    std::vector<std::shared_ptr<const Page>> m_pages; // nullptr: every factor on the page is 1
+    size_t m_edgeCount;
+    uint64_t m_generation;
+    size_t m_overridden = 0;
+    size_t m_closed = 0;
+};
+
+// Text batches, one update per line ('#' starts a comment):
+//   <from OSM node>,<to OSM node>,<factor>|closed|open
+// naming the graph edge containing that way segment, in that direction.
+// Segments not in the graph are counted in unmatched. Returns false with a
+// message in error on malformed lines.
+bool parseWeightUpdates(const RoutingGraph& graph, std::istream& in, std::vector<WeightOverrides::Update>& batch,
+                        size_t& unmatched, std::string& error);
+
+// Reader side of the process-wide overrides: pins the current generation for
+// as long as it lives, without taking locks. A generation is freed only once
+// no snapshot taken while it was current remains (epoch-based reclamation).
+// Each thread takes a reader slot on first use; a thread may nest snapshots.
+class WeightSnapshot {
+public:
+    WeightSnapshot();
+    ~WeightSnapshot();
+    WeightSnapshot(const WeightSnapshot&) = delete;
+    WeightSnapshot& operator=(const WeightSnapshot&) = delete;
+
+    // nullptr until the first update, or if the overrides belong to another graph.
+    const WeightOverrides* get(const RoutingGraph& graph) const {
+        return m_overrides && m_overrides->edgeCount() == graph.edgeCount() ? m_overrides : nullptr;
+    }
+
+private:
+    const WeightOverrides* m_overrides;
+};
+
+// Writer side: applies batch on top of the current generation (or on no
+// overrides, if those were made for another graph) and publishes the result.
+// Writers are serialized; readers are never blocked. Returns the new
+// generation, or nullptr on a bad batch.
+std::shared_ptr<const WeightOverrides> applyWeightUpdates(const RoutingGraph& graph,
+                                                          const std::vector<WeightOverrides::Update>& batch);
+
+#endif
@@ -1,9 +1,12 @@
+#include <chrono>
 #include <iostream>
 #include <cmath>
 
 #include "imgui_panel.hpp"
 #include "windower.hpp"
 
+// Time spent on the route per frame, so dragging stays smooth on long routes.
+static constexpr std::chrono::milliseconds ROUTE_FRAME_BUDGET(8);
 
 // Modern Dark Theme Function
 // --------------------------
@@ -105,6 +108,12 @@ void Windower::run() {
 
 
         ShowRouteTracerPanel(*this);
+        if (m_searchRequested) {
+            runRoadSearch();
+            m_searchRequested = false;
+        }
+        if (m_runAStarWithNodes || m_runAStarWithCoords) startRoute();
+        updateRoute();
 
 
         m_renderer.render();
@@ -139,11 +148,22 @@ void Windower::m_mouseButtonCallback(GLFWwindow* window, int button, int action,
             win->m_middleDown = false;
         }
     }
+    if (button == GLFW_MOUSE_BUTTON_RIGHT) {
+        if (action == GLFW_PRESS && !ImGui::GetIO().WantCaptureMouse) {
+            win->m_rightDown = true;
+            double x, y;
+            glfwGetCursorPos(window, &x, &y);
+            win->dragGoal(x, y);
+        } else if (action == GLFW_RELEASE) {
+            win->m_rightDown = false;
+        }
+    }
 }
 
 void Windower::m_cursorPosCallback(GLFWwindow* window, double xpos, double ypos) {
     Windower* win = reinterpret_cast<Windower*>(glfwGetWindowUserPointer(window));
     if (!win) return;
+    if (win->m_rightDown) win->dragGoal(xpos, ypos);
     if (!win->m_middleDown) return;
 
     double dx = xpos - win->m_lastMouseX;
@@ -192,6 +212,94 @@ void Windower::m_scrollCallback(GLFWwindow* window, double xoffset, double yoffs
     win->m_renderer.setCamera(win->m_camOX, win->m_camOY, win->m_camScale);
 }
 
+void Windower::setRoadSearch(const Map& map, const RoadSearchIndex& index) {
+    m_map = &map;
+    m_searchSession = std::make_unique<RoadSearchIndex::Session>(index);
+}
+
+void Windower::runRoadSearch() {
+    if (!m_searchSession) return;
+    const auto& results = m_searchSession->update(m_searchBuffer);
+    selectSearchResult(results.empty() ? -1 : 0);
+}
+
+void Windower::selectSearchResult(int i) {
+    m_selectedResult = i;
+    std::vector<size_t> segments;
+    if (m_searchSession && m_map && i >= 0 && i < static_cast<int>(m_searchSession->results().size())) {
+        RoadCatalog::RoadId road = m_searchSession->results()[i].road;
+        for (size_t s = m_map->roadSegments[road]; s < m_map->roadSegments[road + 1]; ++s) segments.push_back(s);
+    }
+    m_renderer.setHighlightSegments(std::move(segments));
+}
+
+void Windower::setRouting(const Map& map, const RoutingGraph& graph) {
+    m_map = &map;
+    m_graph = &graph;
+    m_route = std::make_unique<IncrementalRoute>(graph);
+}
+
+void Windower::startRoute() {
+    const bool byNodes = m_runAStarWithNodes;
+    m_runAStarWithNodes = false;
+    m_runAStarWithCoords = false;
+    if (!m_route) return;
+
+    RoutingGraph::NodeIndex goal;
+    if (byNodes) {
+        m_routeStart = m_graph->indexOf(m_startNode);
+        goal = m_graph->indexOf(m_endNode);
+    } else {
+        m_routeStart = m_graph->nearestNode(m_startLat, m_startLon);
+        goal = m_graph->nearestNode(m_endLat, m_endLon);
+    }
+    if (m_routeStart == RoutingGraph::INVALID_NODE || goal == RoutingGraph::INVALID_NODE) {
+        std::cout << "Start or end node not found in the graph" << std::endl;
+        m_routeStart = RoutingGraph::INVALID_NODE;
+        return;
+    }
+    m_route->setEndpoints(m_routeStart, goal);
+    m_routeShown = false;
+}
+
+void Windower::dragGoal(double cursorX, double cursorY) {
+    if (!m_route || !m_map || m_routeStart == RoutingGraph::INVALID_NODE) return;
+
+    // cursor to NDC, then undo the camera (see the shader) to get map view space
+    double ndc_x = (2.0 * cursorX) / static_cast<double>(m_windowWidth) - 1.0;
+    double ndc_y = -((2.0 * cursorY) / static_cast<double>(m_windowHeight) - 1.0);
+    double lat, lon;
+    fromViewCoords(*m_map, static_cast<float>(ndc_x / m_camScale - m_camOX),
+                   static_cast<float>(ndc_y / m_camScale - m_camOY), lat, lon);
+
+    RoutingGraph::NodeIndex goal = m_graph->nearestNode(lat, lon);
+    if (goal == RoutingGraph::INVALID_NODE) return;
+    m_endLat = static_cast<float>(m_graph->lat(goal));
+    m_endLon = static_cast<float>(m_graph->lon(goal));
+    m_route->setEndpoints(m_routeStart, goal);
+    m_routeShown = false;
+}
+
+void Windower::updateRoute() {
+    if (!m_route || m_routeShown) return;
+    if (!m_route->update(ROUTE_FRAME_BUDGET)) return; // keep the old route on screen until then
+
+    std::vector<float> xy;
+    for (RoutingGraph::NodeIndex u : m_route->path()) {
+        float x, y;
+        toViewCoords(*m_map, m_graph->lat(u), m_graph->lon(u), x, y);
+        xy.push_back(x);
+        xy.push_back(y);
+    }
+    if (xy.empty()) {
+        m_renderer.setOverlayLines({}, {}, {});
+    } else {
+        const size_t points = xy.size() / 2;
+        m_renderer.setOverlayLines(xy, {points}, {m_pathColor[0], m_pathColor[1], m_pathColor[2], 1.0f});
+    }
+    m_routeShown = true;
+}
+
 void Windower::resizeViewport(GLFWwindow* window, int width, int height) {
     m_windowWidth = width;
     m_windowHeight = height;
@@ -8,7 +8,12 @@
 #include "imgui_impl_glfw.h"
 #include "imgui_impl_opengl3.h"
 
+#include <memory>
+
+#include "a_star.hpp"
+#include "map_data.hpp"
 #include "renderer.hpp"
+#include "road_search.hpp"
 
 class Windower {
 private:
@@ -38,9 +43,20 @@ public:
     float m_canvasScale = 1.0f;
     float m_pathColor[3] = {1.0f, 0.0f, 0.0f};
 
-    // Search bar for road name
+    // Search bar for road name (searched as you type)
     char m_searchBuffer[128] = "";
     bool m_searchRequested = false;
+    const Map* m_map = nullptr;
+    std::unique_ptr<RoadSearchIndex::Session> m_searchSession;
+    int m_selectedResult = -1;
+
+    // Route between the panel's endpoints; dragging with the right mouse
+    // button moves its goal and replans incrementally.
+    const RoutingGraph* m_graph = nullptr;
+    std::unique_ptr<IncrementalRoute> m_route;
+    RoutingGraph::NodeIndex m_routeStart = RoutingGraph::INVALID_NODE;
+    bool m_routeShown = true;
+    bool m_rightDown = false;
 
     // --------------------------------
     bool m_middleDown;
@@ -57,6 +73,17 @@ public:
     void processInput();
     void resizeViewport(GLFWwindow* window, int width, int height);
 
+    // Enables the road search box; map and index must outlive the window.
+    void setRoadSearch(const Map& map, const RoadSearchIndex& index);
+    void runRoadSearch();
+    void selectSearchResult(int i);
+
+    // Enables routing; graph must outlive the window and match the map.
+    void setRouting(const Map& map, const RoutingGraph& graph);
+    void startRoute();
+    void dragGoal(double cursorX, double cursorY);
+    void updateRoute();
+
 
     Windower(Renderer& renderer, int windowWidth, int windowHeight);
     void run();